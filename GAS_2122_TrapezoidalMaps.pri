@@ -0,0 +1,52 @@
+# Sources of the trapezoidal map that don't depend on the GUI. They are shared by the
+# GUI project and by the headless subprojects (e.g. the benchmark), which include this file.
+
+INCLUDEPATH += $$PWD
+
+SOURCES +=  \
+    $$PWD/algorithms/algorithms.cpp \
+    $$PWD/algorithms/parallel_builder.cpp \
+    $$PWD/algorithms/predicates.cpp \
+    $$PWD/algorithms/query_executor.cpp \
+    $$PWD/algorithms/range_queries.cpp \
+    $$PWD/algorithms/simd_predicates.cpp \
+    $$PWD/algorithms/utility.cpp \
+    $$PWD/data_structures/dag.cpp \
+    $$PWD/data_structures/dag_node.cpp \
+    $$PWD/data_structures/mapped_trapezoidalmap.cpp \
+    $$PWD/data_structures/packed_dag.cpp \
+    $$PWD/data_structures/segment_bvh.cpp \
+    $$PWD/data_structures/segment_intersection_checker.cpp \
+    $$PWD/data_structures/trapezoid.cpp \
+    $$PWD/data_structures/trapezoidalmap.cpp \
+    $$PWD/data_structures/trapezoidalmap_dataset.cpp \
+    $$PWD/data_structures/trapezoidalmap_snapshot.cpp \
+    $$PWD/utils/arena.cpp \
+    $$PWD/utils/fileutils.cpp \
+    $$PWD/utils/mappedfile.cpp \
+    $$PWD/utils/randomutils.cpp \
+    $$PWD/utils/segmentgenerator.cpp
+
+HEADERS += \
+    $$PWD/algorithms/algorithms.h \
+    $$PWD/algorithms/parallel_builder.h \
+    $$PWD/algorithms/predicates.h \
+    $$PWD/algorithms/query_executor.h \
+    $$PWD/algorithms/range_queries.h \
+    $$PWD/algorithms/simd_predicates.h \
+    $$PWD/algorithms/utility.h \
+    $$PWD/data_structures/dag.h \
+    $$PWD/data_structures/dag_node.h \
+    $$PWD/data_structures/mapped_trapezoidalmap.h \
+    $$PWD/data_structures/packed_dag.h \
+    $$PWD/data_structures/segment_bvh.h \
+    $$PWD/data_structures/segment_intersection_checker.h \
+    $$PWD/data_structures/trapezoid.h \
+    $$PWD/data_structures/trapezoidalmap.h \
+    $$PWD/data_structures/trapezoidalmap_dataset.h \
+    $$PWD/data_structures/trapezoidalmap_snapshot.h \
+    $$PWD/utils/arena.h \
+    $$PWD/utils/fileutils.h \
+    $$PWD/utils/mappedfile.h \
+    $$PWD/utils/randomutils.h \
+    $$PWD/utils/segmentgenerator.h
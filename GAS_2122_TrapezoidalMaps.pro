@@ -39,39 +39,19 @@ message($$MODULES)
 DISTFILES += \
     LICENSE
 
+# Sources of the algorithms and of the data structures
+include (GAS_2122_TrapezoidalMaps.pri)
+
 SOURCES +=  \
-    algorithms/algorithms.cpp \
-    algorithms/utility.cpp \
-    data_structures/dag.cpp \
-    data_structures/dag_node.cpp \
-    data_structures/segment_intersection_checker.cpp \
-    data_structures/trapezoid.cpp \
-    data_structures/trapezoidalmap.cpp \
-    data_structures/trapezoidalmap_dataset.cpp \
     drawables/drawable_trapezoidalmap.cpp \
     drawables/drawable_trapezoidalmap_dataset.cpp \
     main.cpp \
-    managers/trapezoidalmap_manager.cpp \
-    utils/fileutils.cpp
+    managers/trapezoidalmap_manager.cpp
 
 FORMS += \
     managers/trapezoidalmapmanager.ui
 
 HEADERS += \
-    algorithms/algorithms.h \
-    algorithms/utility.h \
-    data_structures/dag.h \
-    data_structures/dag_node.h \
-    data_structures/segment_intersection_checker.h \
-    data_structures/trapezoid.h \
-    data_structures/trapezoidalmap.h \
-    data_structures/trapezoidalmap_dataset.h \
     drawables/drawable_trapezoidalmap.h \
     drawables/drawable_trapezoidalmap_dataset.h \
-    managers/trapezoidalmap_manager.h \
-    utils/fileutils.h
-
-
-
-
-
+    managers/trapezoidalmap_manager.h
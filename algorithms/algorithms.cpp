@@ -1,1740 +1,1476 @@
 #include "algorithms.h"
+#include "simd_predicates.h"
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <random>
 #define TOP_LEFT 0
 #define TOP_RIGHT 1
 #define BOTTOM_LEFT 2
 #define BOTTOM_RIGHT 3
+#define CACHE_LINE 64 // the size of a cache line in bytes
 
+namespace {
 
 /**
- * @brief algorithms::followSegment
- * This algorithm, using the trapezoidal map T and the dag D, returns the vectir of trapezoids in T that are intersected by s
- * @param T the trapezoidal map containing the segments
- * @param D the Dag to query with the left endpoint of the segment
- * @param s the segment that intersects the trapezoids
- * @return the vector with all trapezoids intersected by the segment
+ * @brief randomBelow
+ * This function draws a number in [0, n) from the output of the generator. The values from the last multiple of n
+ * on are drawn again, so every number has the same probability. The sequence of mt19937_64 is fixed by the standard,
+ * while the algorithm of std::uniform_int_distribution depends on the library, so the number only depends on the seed.
+ * @param rng the random number generator
+ * @param n the number of possible values, greater than 0
+ * @return a number in [0, n)
  */
-std::vector<Trapezoid> algorithms::followSegment(TrapezoidalMap T, Dag D, cg3::Segment2d s){
-
-    std::vector<Trapezoid> delta; //the vector that will contain the trapezoids intersected by the segment
-    cg3::Point2d p = s.p1(); //p is the left endpoint of the segment
-    cg3::Point2d q = s.p2(); //q is the right endpoint of the segment
-
-    size_t i0 = queryPoint(D, p, q);//query the dag with the left endpoint to find the first intersected trapezoid
-    delta.push_back(T.getTrapezoid(D.getElementInDVector(i0).getEntityId())); //add in the vector the first trapezoid found
-    size_t j = 0; //variable used in the while loop
-    while(q.x() > delta[j].getRightp().x() && j < delta.size()){//while the right endpoint lies to the right of rightp(Δj)
-        if(utility::isAbove(s,delta[j].getRightp())){//if rightp(Δj) lies above si
-            if(delta[j].getNeighbor(BOTTOM_RIGHT) != SIZE_MAX){
-                delta.push_back(T.getTrapezoid(delta[j].getNeighbor(BOTTOM_RIGHT)));
-            }
-            //then Δj+1 be the lower right neighbor of Δj
-        }
-        else{
-            if(delta[j].getNeighbor(TOP_RIGHT) != SIZE_MAX){
-                delta.push_back(T.getTrapezoid(delta[j].getNeighbor(TOP_RIGHT)));
-            }
-            //else Δj+1 be the upper right neighbor of Δj
-        }
-        j++;//update the loop variable
+uint64_t randomBelow(std::mt19937_64& rng, uint64_t n){
+    uint64_t limit = UINT64_MAX - UINT64_MAX % n; //the first value of the incomplete interval at the end
+    uint64_t r = rng();
+    while(r >= limit){
+        r = rng();
     }
-    return delta;//return the vector with the trapezoid
+    return r % n;
 }
 
 /**
- * @brief algorithms::updateDag
- * This method updates the Dag after the segment insertion, when a split in 4 occurs.
- * The node of the trapezoid intersected by the segment is removed. The nodes for the segment, the two endpoints
- * and the four trapezoids are created and added to the dag, setting correctly their children.
- * @param D a reference to the Dag
- * @param s the segment inserted
- * @param tsplit the index of the dag node representing the trapezoid of the split
- * @param tleft the id of the trapezoid to the left
- * @param tright the id of the trapezoid to the right
- * @param ttop the id of the trapezoid above
- * @param tbottom the id of the trapezoid below
- * @return the vector with the ids of the dag of the 4 trapezoids
+ * @brief goesLeft
+ * This function decides, for a SEGMENT node, if the query proceeds to the left child (above the segment)
+ * or to the right child (below the segment). It is shared by the single and the batch queries, so that
+ * both of them return the same trapezoid for the same point.
+ * @param s the segment of the node
+ * @param p1 the query point
+ * @param p2 the right endpoint of the segment when p1 is a left endpoint, p1 itself otherwise
+ * @return true if the query proceeds to the left child, false otherwise
  */
-std::vector<size_t> algorithms::updateDag(TrapezoidalMap& T, Dag& D, cg3::Segment2d s, size_t tsplit, size_t tleft, size_t tright, size_t ttop, size_t tbottom){
+inline bool goesLeft(const cg3::Segment2d& s, const cg3::Point2d& p1, const cg3::Point2d& p2){
+    if(utility::isAbove(s,p1)){
+        return true;
+    }
+    if(utility::pointEqual(s.p1(),p1) || utility::pointEqual(s.p2(),p1)){
+        //the slope of the segment is compared with the slope from p1 to p2, infinite for a query point: the
+        //segment from p1 has the larger slope if p2 is above the segment of the node
+        if(utility::pointEqual(p1,p2)){
+            return s.p1().x() != s.p2().x();
+        }
+        return utility::isAbove(s,p2);
+    }
+    return false;
+}
 
-    //obtain the size of the vectors of dagNodes, points and segment
-    size_t pSize = D.getVectorSize(POINT);
-    size_t sSize = D.getVectorSize(SEGMENT);
-    std::vector<size_t> tId;
+/**
+ * @brief goesLeft
+ * This override decides the direction of a query point at a node of the packed dag. A query point is
+ * always a single point, so the slope of the query is infinite: on an endpoint of the segment the point
+ * goes to the left child unless the segment is vertical.
+ * @param s the endpoints of the segment of the node
+ * @param vertical true if the node is a PACKED_VERTICAL_SEGMENT node
+ * @param x the x coordinate of the query point
+ * @param y the y coordinate of the query point
+ * @return true if the query proceeds to the left child, false otherwise
+ */
+inline bool goesLeft(const PackedSegment& s, bool vertical, double x, double y){
+    if(utility::isAbove(s.x1,s.y1,s.x2,s.y2,x,y)){
+        return true;
+    }
+    if(!vertical && (utility::pointEqual(s.x1,s.y1,x,y) || utility::pointEqual(s.x2,s.y2,x,y))){
+        return true;
+    }
+    return false;
+}
 
-    DagNode p1,p2,sn;
-    bool p1AlreadyPresent;
-    bool p2AlreadyPresent;
-    bool sAlreadyPresent;
-    size_t p1_old;
-    size_t p2_old;
-    size_t s_old;
+/**
+ * @brief prefetch
+ * Hint to the processor that the memory at address will be read soon
+ */
+inline void prefetch(const void * address){
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(address);
+#else
+    (void) address;
+#endif
+}
 
-    D.findPoint(s.p1(),p1AlreadyPresent,p1_old);
-    D.findPoint(s.p2(),p2AlreadyPresent,p2_old);
-    D.findSegment(s,sAlreadyPresent,s_old);
+/**
+ * @brief The QueryArrays struct
+ * The points of a batch query stored as separate arrays of coordinates, with their positions in the input vector,
+ * so that the predicate kernels compare several points with a node of the dag at a time. The kernels write the
+ * side of every point of a range, then the range is partitioned in the points going to the left child and the
+ * points going to the right child.
+ */
+struct QueryArrays{
+    std::vector<double> x;
+    std::vector<double> y;
+    std::vector<size_t> index;
+    std::vector<unsigned char> side;
 
-    //create id of dag nodes
-    size_t p1_id, p2_id, s_id, a_id, b_id, c_id, d_id = SIZE_MAX;
+    QueryArrays(const std::vector<cg3::Point2d>& points, size_t begin, size_t end);
+    size_t partition(size_t begin, size_t end);
+};
 
-    //Create point, segment and trapezoid node
-    if(p1AlreadyPresent){
-        p1 = DagNode(POINT,p1_old);
-    }
-    else{
-        p1 = DagNode(POINT,pSize);
+/**
+ * @brief QueryArrays::QueryArrays
+ * Copies the points in the range [begin, end) of the input vector in the arrays
+ */
+QueryArrays::QueryArrays(const std::vector<cg3::Point2d>& points, size_t begin, size_t end) :
+    x(end - begin), y(end - begin), index(end - begin), side(end - begin)
+{
+    for(size_t i = begin; i < end; i++){
+        x[i - begin] = points[i].x();
+        y[i - begin] = points[i].y();
+        index[i - begin] = i;
     }
+}
 
-    if(p2AlreadyPresent){
-        p2 = DagNode(POINT,p2_old);
-    }
-    else{
-        if(!p1AlreadyPresent){
-            p2 = DagNode(POINT,pSize + 1);
+/**
+ * @brief QueryArrays::partition
+ * Moves the points of the range [begin, end) with SIDE_LEFT before the others. The sides must be decided.
+ * @return the position of the first point that goes to the right child
+ */
+size_t QueryArrays::partition(size_t begin, size_t end){
+    while(true){
+        while(begin < end && side[begin] == SIDE_LEFT){
+            begin++;
         }
-        else{
-            p2 = DagNode(POINT,pSize);
+        while(begin < end && side[end - 1] != SIDE_LEFT){
+            end--;
         }
+        if(begin == end){
+            return begin;
+        }
+        end--;
+        std::swap(x[begin], x[end]);
+        std::swap(y[begin], y[end]);
+        std::swap(index[begin], index[end]);
+        begin++;
     }
+}
 
-    if(sAlreadyPresent){
-        sn = DagNode(SEGMENT, s_old);
-    }
-    else{
-        sn = DagNode(SEGMENT, sSize);
-    }
-
-    DagNode a = DagNode(TRAPEZOID, tleft);
-    DagNode b = DagNode(TRAPEZOID, ttop);
-    DagNode c = DagNode(TRAPEZOID, tbottom);
-    DagNode d = DagNode(TRAPEZOID, tright);
+/**
+ * @brief The QueryBatch struct
+ * A group of query items (a range of the item vector) that has reached the same node of the dag
+ */
+struct QueryBatch{
+    size_t node;
+    size_t begin;
+    size_t end;
+};
 
-    //push the nodes in the dag vector
-    p1_id = D.replaceNode(tsplit,p1);
-    p2_id = D.insertInVector(p2);
-    s_id = D.insertInVector(sn);
 
-    if(T.getTrapezoid(tleft).getDagId() == SIZE_MAX){
-        a_id = D.insertInVector(a);
-    }
-    else{
-        a_id = T.getTrapezoid(tleft).getDagId();
+/**
+ * @brief setNeighborIfExists
+ * Sets the neighbor in position index of the trapezoid trap, if trap is a trapezoid
+ * @param T the trapezoidal map
+ * @param trap the id of the trapezoid, SIZE_MAX if there is no trapezoid
+ * @param index the position of the neighbor
+ * @param rep the id of the new neighbor
+ */
+inline void setNeighborIfExists(TrapezoidalMap& T, size_t trap, size_t index, size_t rep){
+    if(trap != SIZE_MAX){
+        T.setNeighbor(trap, index, rep);
     }
+}
 
-    if(T.getTrapezoid(ttop).getDagId() == SIZE_MAX){
-        b_id = D.insertInVector(b);
+/**
+ * @brief getLeaf
+ * Returns the id of the leaf of the trapezoid trap, the leaf is inserted in the dag if the trapezoid has none
+ * @param T the trapezoidal map
+ * @param D the dag
+ * @param trap the id of the trapezoid
+ * @return the id of the dag node of the trapezoid
+ */
+size_t getLeaf(TrapezoidalMap& T, Dag& D, size_t trap){
+    if(T.getTrapezoid(trap).getDagId() == SIZE_MAX){
+        DagNode leaf = DagNode(TRAPEZOID, trap);
+        T.setDagId(trap, D.insertInVector(leaf));
     }
-    else{
-        b_id = T.getTrapezoid(ttop).getDagId();
+    return T.getTrapezoid(trap).getDagId();
+}
+
+/**
+ * @brief locateAlongSegment
+ * Walks the dag with the middle point of a segment of the map. At the nodes of the segment itself the walk takes
+ * the given side, so it reaches a trapezoid that has the segment as bottom or as top.
+ * @param T the trapezoidal map
+ * @param D the dag
+ * @param s the id of the segment
+ * @param above true to reach a trapezoid above the segment, false to reach a trapezoid below it
+ * @return the id of the trapezoid
+ */
+size_t locateAlongSegment(const TrapezoidalMap& T, const Dag& D, size_t s, bool above){
+    const cg3::Segment2d& segment = T.getSegment(s);
+    double x = (segment.p1().x() + segment.p2().x()) / 2;
+    cg3::Point2d middle(x, utility::yAtX(segment, x));
+    const DagNode * d = &D.getElementInDVector(0);
+    while(d->getNodeType() != TRAPEZOID){
+        bool left;
+        if(d->getNodeType() == POINT){
+            left = middle.x() < D.getElementInPVector(d->getEntityId()).x();
+        }
+        else if(d->getEntityId() == s){
+            left = above;
+        }
+        else{
+            left = utility::isAbove(D.getElementInSVector(d->getEntityId()), middle);
+        }
+        d = &D.getElementInDVector(left ? d->getLeftC() : d->getRightC());
     }
+    return d->getEntityId();
+}
+
+/**
+ * @brief The MergedTrapezoid struct
+ * A trapezoid made by the removal of a segment, with the old trapezoids along its sides that start at its leftp
+ * and end at its rightp. Their neighbors outside the merged area become the neighbors of the new trapezoid.
+ */
+struct MergedTrapezoid{
+    Trapezoid t;
+    size_t topLeft;     //the position in the chain above of the old trapezoid that starts at leftp, SIZE_MAX if none
+    size_t bottomLeft;  //the position in the chain below of the old trapezoid that starts at leftp, SIZE_MAX if none
+    size_t topRight;    //the position in the chain above of the old trapezoid that ends at rightp, SIZE_MAX if none
+    size_t bottomRight; //the position in the chain below of the old trapezoid that ends at rightp, SIZE_MAX if none
+};
 
-    if(T.getTrapezoid(tbottom).getDagId() == SIZE_MAX){
-        c_id = D.insertInVector(c);
+/**
+ * @brief searchNode
+ * Builds the subtree that locates a point among the merged trapezoids first..last, which are consecutive from left
+ * to right, by the x coordinate of their leftp. The subtree is balanced, so it has a logarithmic depth.
+ * @param D the dag
+ * @param merged the merged trapezoids
+ * @param leaves the ids of the leaves of the merged trapezoids
+ * @param first the first trapezoid
+ * @param last the last trapezoid, greater than first
+ * @return the root of the subtree, not yet inserted in the dag
+ */
+DagNode searchNode(Dag& D, const std::vector<MergedTrapezoid>& merged, const std::vector<size_t>& leaves, size_t first, size_t last){
+    size_t middle = (first + last + 1) / 2;
+    DagNode root = DagNode(POINT, merged[middle].t.getLeftpId());
+    size_t children[2];
+    size_t begin[2] = {first, middle};
+    size_t end[2] = {middle - 1, last};
+    for(size_t i = 0; i < 2; i++){
+        if(begin[i] == end[i]){
+            children[i] = leaves[begin[i]];
+        }
+        else{
+            DagNode child = searchNode(D, merged, leaves, begin[i], end[i]);
+            children[i] = D.insertInVector(child);
+        }
     }
-    else{
-        c_id = T.getTrapezoid(tbottom).getDagId();
+    root.setLeftc(children[0]);
+    root.setRightc(children[1]);
+    return root;
+}
+
+/**
+ * @brief moveLastTrapezoid
+ * Moves the last trapezoid of the map in the place of a trapezoid that is no longer in the map, then removes the
+ * last position. The leaf of the moved trapezoid and its neighbors are updated with the new id.
+ * @param T the trapezoidal map
+ * @param D the dag
+ * @param hole the id of the trapezoid that is no longer in the map, no trapezoid refers to it
+ */
+void moveLastTrapezoid(TrapezoidalMap& T, Dag& D, size_t hole){
+    size_t last = T.getTsize() - 1;
+    if(hole != last){
+        Trapezoid t = T.getTrapezoid(last);
+        T.replaceTrapezoid(hole, t);
+        D.replaceNode(t.getDagId(), DagNode(TRAPEZOID, hole));
+        for(size_t i = 0; i < 4; i++){
+            size_t neighbor = t.getNeighbor(i);
+            if(neighbor == SIZE_MAX){
+                continue;
+            }
+            for(size_t j = 0; j < 4; j++){
+                if(T.getNeighbor(neighbor, j) == last){
+                    T.setNeighbor(neighbor, j, hole);
+                }
+            }
+        }
     }
+    T.removeLastTrapezoid();
+}
 
-    if(T.getTrapezoid(tright).getDagId() == SIZE_MAX){
-        d_id = D.insertInVector(d);
+/**
+ * @brief queryPacked
+ * Locates a point in the arrays of a packed dag. The arrays can belong to a PackedDag or to a mapped file.
+ * @param nodes the packed nodes, the first one is the root
+ * @param segments the segments of the packed nodes
+ * @param p the query point
+ * @return the id of the trapezoid that contains the point
+ */
+size_t queryPacked(const PackedDagNode * nodes, const PackedSegment * segments, const cg3::Point2d& p){
+    double x = p.x(), y = p.y();
+    const PackedDagNode * d = nodes; //start from the root of the dag
+    while(true){
+        switch(PackedDag::getNodeType(*d)){
+            case PACKED_POINT:
+                d = x < d->x ? nodes + d->left : nodes + PackedDag::getRightC(*d);
+            break;
+            case PACKED_SEGMENT:
+                d = goesLeft(segments[d->segment],false,x,y) ? nodes + d->left : nodes + PackedDag::getRightC(*d);
+            break;
+            case PACKED_VERTICAL_SEGMENT:
+                d = goesLeft(segments[d->segment],true,x,y) ? nodes + d->left : nodes + PackedDag::getRightC(*d);
+            break;
+            default: //PACKED_TRAPEZOID
+                return d->left;
+        }
     }
-    else{
-        d_id = T.getTrapezoid(tright).getDagId();
+}
+
+/**
+ * @brief queryPackedPoints
+ * Locates the points in the range [begin, end) of the input vector in the arrays of a packed dag.
+ * The output vector must already contain a position for every input point.
+ * @param nodes the packed nodes, the first one is the root
+ * @param segments the segments of the packed nodes
+ * @param points the query points
+ * @param begin the position of the first point of the range
+ * @param end the position after the last point of the range
+ * @param[out] out the ids of the trapezoids containing the points, in the same order of the input
+ */
+void queryPackedPoints(const PackedDagNode * nodes, const PackedSegment * segments, const std::vector<cg3::Point2d>& points,
+                       size_t begin, size_t end, std::vector<size_t>& out){
+    if(begin >= end){
+        return;
     }
 
+    QueryArrays items(points, begin, end);
 
-    //set left and right children
-    D.getElementInDVector(p1_id).setLeftc(a_id);
-    D.getElementInDVector(p1_id).setRightc(p2_id);
-    D.getElementInDVector(p2_id).setLeftc(s_id);
-    D.getElementInDVector(p2_id).setRightc(d_id);
-    D.getElementInDVector(s_id).setLeftc(b_id);
-    D.getElementInDVector(s_id).setRightc(c_id);
+    std::vector<QueryBatch> stack;
+    stack.push_back({0, 0, end - begin}); //all the points start from the root of the dag
 
-    //push the points and the segment in the respective vector
-    D.insertInVector(s.p1());
-    D.insertInVector(s.p2());
-    D.insertInVector(s);
+    while(!stack.empty()){
+        QueryBatch b = stack.back();
+        stack.pop_back();
+        const PackedDagNode& d = nodes[b.node];
+        size_t n = b.end - b.begin;
+        packedNodeType type = PackedDag::getNodeType(d);
 
-    tId.push_back(a_id);
-    tId.push_back(b_id);
-    tId.push_back(c_id);
-    tId.push_back(d_id);
+        if(type == PACKED_TRAPEZOID){
+            //every point of the range is contained in the trapezoid of the leaf
+            for(size_t i = b.begin; i < b.end; i++){
+                out[items.index[i]] = d.left;
+            }
+            continue;
+        }
 
-    return tId;
+        prefetch(nodes + d.left);
+        prefetch(nodes + PackedDag::getRightC(d));
+        if(type == PACKED_POINT){
+            predicates::classifyX(d.x, &items.x[b.begin], n, &items.side[b.begin]);
+        }
+        else{
+            const PackedSegment& s = segments[d.segment];
+            bool vertical = type == PACKED_VERTICAL_SEGMENT;
+            predicates::classifyAbove(s.x1, s.y1, s.x2, s.y2, &items.x[b.begin], &items.y[b.begin], n, &items.side[b.begin]);
+            for(size_t i = b.begin; i < b.end; i++){
+                if(items.side[i] == SIDE_UNSURE){
+                    items.side[i] = goesLeft(s,vertical,items.x[i],items.y[i]) ? SIDE_LEFT : SIDE_RIGHT;
+                }
+            }
+        }
 
+        size_t m = items.partition(b.begin, b.end);
+        //the right range is pushed first, so that the left one is visited next
+        if(m < b.end){
+            stack.push_back({PackedDag::getRightC(d), m, b.end});
+        }
+        if(b.begin < m){
+            stack.push_back({d.left, b.begin, m});
+        }
+    }
 }
+
 /**
- * @brief algorithms::updateDag
- * This is an override of the updateDag function to manage the case of a split in 3. This function returns the vector with the dag id's
- * of the 3 trapezoids, in order to update the field of the trapezoid in the split in 3 algorithm.
- * @param D The dag to update
- * @param s The segment that caused the split and thus the update of the dag
- * @param tsplit the id of the dagNode of the Trapezoid intersected by the segment
- * @param ttop The id of the trapezoid on the top
- * @param tbottom The id of the trapezoid on the bottom
- * @param tother The id of the other trapezoid (left or right)
- * @param left a boolean value that determines if the split in 3 is on the left or on the right
- * @return the vector with the id of the dagNodes representing the 3 trapezoids inserted in the Dag.
+ * @brief datasetSegment
+ * @param s the id of a segment of the map
+ * @return the same id, or NO_SEGMENT for a side of the bounding box
  */
-std::vector<size_t> algorithms::updateDag(TrapezoidalMap& T, Dag& D, cg3::Segment2d s, size_t tsplit, size_t ttop, size_t tbottom, size_t tother, bool left){
-    //obtain the size of the vectors of dagNodes, points and segment
-    size_t pSize = D.getVectorSize(POINT);
-    size_t sSize = D.getVectorSize(SEGMENT);
-    DagNode p, sn;
+size_t datasetSegment(size_t s){
+    return s == BOUNDINGBOX_TOP || s == BOUNDINGBOX_BOTTOM ? NO_SEGMENT : s;
+}
 
-    bool pAlreadyPresent;
-    bool sAlreadyPresent;
-    size_t p_old;
-    size_t s_old;
+}
 
-    if(left){
-        D.findPoint(s.p1(),pAlreadyPresent,p_old);
-    }
-    else{
-        D.findPoint(s.p2(),pAlreadyPresent,p_old);
-    }
-    D.findSegment(s,sAlreadyPresent,s_old);
+/**
+ * @brief algorithms::addSegment
+ * This method performs the incremental step of the construction for a new segment: the segment is added to the
+ * tables of the trapezoidal map, then it is inserted in the map and in the Dag.
+ * @param T the trapezoidal map in which the segment is inserted
+ * @param D the Dag of the trapezoidal map
+ * @param segment the segment to insert
+ */
+void algorithms::addSegment(TrapezoidalMap& T, Dag& D, const cg3::Segment2d& segment){
+    insertSegment(T,D,T.addSegment(segment));
+}
 
-    //create id of dag nodes
-    size_t p_id, s_id, a_id, b_id, c_id = SIZE_MAX;
+/**
+ * @brief algorithms::insertSegment
+ * This method performs the incremental step of the construction for a segment that is already in the tables of the
+ * trapezoidal map: the trapezoids intersected by the segment are found and split, and the Dag is updated.
+ * @param T the trapezoidal map in which the segment is inserted
+ * @param D the Dag of the trapezoidal map
+ * @param s the id of the segment to insert
+ */
+void algorithms::insertSegment(TrapezoidalMap& T, Dag& D, size_t s){
+    //the dag stores the geometry of the segment with the same ids of the map
+    D.setPoint(T.getSegmentLeftpId(s), T.getPoint(T.getSegmentLeftpId(s)));
+    D.setPoint(T.getSegmentRightpId(s), T.getPoint(T.getSegmentRightpId(s)));
+    D.setSegment(s, T.getSegment(s));
+
+    std::vector<size_t> delta = followSegment(T,D,s);
+    splitTrapezoids(T,D,s,delta);
+}
 
-    std::vector<size_t> tId;
 
-    //Create point, segment and trapezoid node
-    if(pAlreadyPresent){
-        p = DagNode(POINT,p_old);
+/**
+ * @brief algorithms::randomInsertionOrder
+ * This method returns a random permutation of the positions of n segments. The permutation only depends on the
+ * seed, so a construction can be reproduced by using the same seed again.
+ * @param n the number of segments
+ * @param seed the seed of the random number generator
+ * @return the positions 0..n-1 in random order
+ */
+std::vector<size_t> algorithms::randomInsertionOrder(size_t n, unsigned long seed){
+    std::vector<size_t> order(n);
+    for(size_t i = 0; i < n; i++){
+        order[i] = i;
     }
-    else{
-        p = DagNode(POINT,pSize);
+    std::mt19937_64 rng(seed);
+    //Fisher-Yates shuffle on the raw output of the generator, so that the order is the same with every standard library
+    for(size_t i = n; i > 1; i--){
+        std::swap(order[i - 1], order[randomBelow(rng, i)]);
     }
+    return order;
+}
 
-    if(sAlreadyPresent){
-        sn = DagNode(SEGMENT,s_old);
+/**
+ * @brief algorithms::buildTrapezoidalMap
+ * This method builds the trapezoidal map with the randomized incremental algorithm: the segments are inserted
+ * in a random order given by the seed, so the expected depth of the Dag is O(log n) even when the input is
+ * sorted or clustered. All the segments are added to the tables of the map before the construction, so the id
+ * of a segment is its position in the input vector whatever the insertion order is.
+ * @param T the trapezoidal map to build
+ * @param D the Dag of the trapezoidal map
+ * @param segments the segments to insert
+ * @param seed the seed of the random insertion order
+ */
+void algorithms::buildTrapezoidalMap(TrapezoidalMap& T, Dag& D, const std::vector<cg3::Segment2d>& segments, unsigned long seed){
+    size_t first = T.getSegmentsSize();
+    T.reserve(segments.size());
+    D.reserve(segments.size());
+    for(const cg3::Segment2d& s : segments){
+        T.addSegment(s);
     }
-    else{
-        sn = DagNode(SEGMENT, sSize);
+    for(size_t i : randomInsertionOrder(segments.size(), seed)){
+        insertSegment(T,D,first + i);
     }
+}
 
-    DagNode a = DagNode(TRAPEZOID, ttop);
-    DagNode b = DagNode(TRAPEZOID, tbottom);
-    DagNode c = DagNode(TRAPEZOID, tother);
-
-    //push the nodes in the dag vector
-    p_id = D.replaceNode(tsplit,p);
-    s_id = D.insertInVector(sn);
-
-    if(left){
-        if(T.getTrapezoid(tother).getDagId() == SIZE_MAX){
-            c_id = D.insertInVector(c);
+/**
+ * @brief algorithms::followSegment
+ * This algorithm, using the trapezoidal map T and the dag D, returns the ids of the trapezoids in T that are intersected by s,
+ * from left to right
+ * @param T the trapezoidal map containing the segments
+ * @param D the Dag to query with the left endpoint of the segment
+ * @param s the id of the segment that intersects the trapezoids
+ * @return the vector with the ids of all trapezoids intersected by the segment
+ */
+std::vector<size_t> algorithms::followSegment(const TrapezoidalMap& T, const Dag& D, size_t s){
+    const cg3::Segment2d& segment = T.getSegment(s);
+    size_t p = T.getSegmentLeftpId(s); //the left endpoint of the segment
+    std::vector<size_t> delta; //the vector that will contain the trapezoids intersected by the segment
+
+    //query the dag with the left endpoint to find the first intersected trapezoid. When the endpoint is the
+    //left endpoint of the segment of a node, the new segment is above if its right endpoint is above
+    const DagNode * d = &D.getElementInDVector(0);
+    while(d->getNodeType() != TRAPEZOID){
+        bool left;
+        if(d->getNodeType() == POINT){
+            left = segment.p1().x() < D.getElementInPVector(d->getEntityId()).x();
+        }
+        else if(T.getSegmentLeftpId(d->getEntityId()) == p){
+            left = utility::isAbove(D.getElementInSVector(d->getEntityId()), segment.p2());
         }
         else{
-            c_id = T.getTrapezoid(tother).getDagId();
+            left = utility::isAbove(D.getElementInSVector(d->getEntityId()), segment.p1());
         }
+        d = &D.getElementInDVector(left ? d->getLeftC() : d->getRightC());
     }
-    else{
-        if(T.getTrapezoid(ttop).getDagId() == SIZE_MAX){
-            a_id = D.insertInVector(a);
+    delta.push_back(d->getEntityId()); //add in the vector the first trapezoid found
+
+    while(segment.p2().x() > T.getRightp(T.getTrapezoid(delta.back())).x()){//while the right endpoint lies to the right of rightp(Δj)
+        const Trapezoid& t = T.getTrapezoid(delta.back());
+        size_t next;
+        if(utility::isAbove(segment, T.getRightp(t))){//if rightp(Δj) lies above si
+            next = t.getNeighbor(BOTTOM_RIGHT); //then Δj+1 be the lower right neighbor of Δj
         }
         else{
-            a_id = T.getTrapezoid(ttop).getDagId();
+            next = t.getNeighbor(TOP_RIGHT); //else Δj+1 be the upper right neighbor of Δj
         }
+        if(next == SIZE_MAX){
+            break; //it happens only if the map is not valid
+        }
+        delta.push_back(next);
     }
+    return delta;//return the vector with the trapezoids
+}
 
-    if(left){
-        if(T.getTrapezoid(ttop).getDagId() == SIZE_MAX){
-            a_id = D.insertInVector(a);
+/**
+ * @brief algorithms::splitTrapezoids
+ * This method replaces the trapezoids intersected by a segment with the new trapezoids. Every intersected trapezoid is
+ * divided in a piece above and a piece below the segment, two consecutive pieces above the segment are merged when the
+ * point that separates them lies below the segment, and vice versa. The first trapezoid has a piece to the left of the
+ * segment, unless the left endpoint is its leftp, and the last trapezoid has a piece to the right.
+ * The new trapezoids take the ids of the intersected ones, the others are appended to the map. Only the ids of the points
+ * and of the segments are copied, so no intersection is computed.
+ * Then the neighbors around the new trapezoids are updated and the updateDag() method is called.
+ * @param T the trapezoidal map containing the trapezoids
+ * @param D the dag that is a search structure for the trapezoidal map
+ * @param s the id of the segment inserted
+ * @param delta the ids of the trapezoids intersected by the segment, from left to right
+ */
+void algorithms::splitTrapezoids(TrapezoidalMap& T, Dag& D, size_t s, const std::vector<size_t>& delta){
+    const cg3::Segment2d segment = T.getSegment(s);
+    size_t p = T.getSegmentLeftpId(s);
+    size_t q = T.getSegmentRightpId(s);
+    size_t k = delta.size() - 1;
+
+    //copy the intersected trapezoids, they are overwritten by the new ones
+    std::vector<Trapezoid> old;
+    std::vector<size_t> leaves;
+    for(size_t id : delta){
+        old.push_back(T.getTrapezoid(id));
+        leaves.push_back(T.getTrapezoid(id).getDagId());
+    }
+    bool hasLeft = old[0].getLeftpId() != p;  //if the left endpoint is not leftp of the first trapezoid
+    bool hasRight = old[k].getRightpId() != q; //if the right endpoint is not rightp of the last trapezoid
+
+    //the pieces above and below the segment, with the first intersected trapezoid of every piece
+    std::vector<Trapezoid> upper, lower;
+    std::vector<size_t> upperFirst, lowerFirst;
+    std::vector<size_t> upperOf(k + 1), lowerOf(k + 1); //the pieces above and below of every intersected trapezoid
+    for(size_t j = 0; j <= k; j++){
+        size_t leftp = j == 0 ? p : old[j].getLeftpId();
+        size_t rightp = j == k ? q : old[j].getRightpId();
+        bool above = j > 0 && utility::isAbove(segment, T.getPoint(leftp)); //the side of the point between Δj-1 and Δj
+        if(j == 0 || above){
+            upper.push_back(Trapezoid(leftp, rightp, old[j].getTopId(), s));
+            upperFirst.push_back(j);
         }
         else{
-            a_id = T.getTrapezoid(ttop).getDagId();
+            upper.back().setRightpId(rightp); //merge with the previous piece above
         }
-    }
-    else{
-        if(T.getTrapezoid(tbottom).getDagId() == SIZE_MAX){
-            b_id = D.insertInVector(b);
+        if(j == 0 || !above){
+            lower.push_back(Trapezoid(leftp, rightp, s, old[j].getBottomId()));
+            lowerFirst.push_back(j);
+        }
+        else{
+            lower.back().setRightpId(rightp); //merge with the previous piece below
+        }
+        upperOf[j] = upper.size() - 1;
+        lowerOf[j] = lower.size() - 1;
+    }
+    upperFirst.push_back(k + 1);
+    lowerFirst.push_back(k + 1);
+
+    //assign the ids: the ids of the intersected trapezoids first, then the positions after the end of the map
+    size_t count = upper.size() + lower.size() + (hasLeft ? 1 : 0) + (hasRight ? 1 : 0);
+    std::vector<size_t> ids(delta);
+    for(size_t i = delta.size(); i < count; i++){
+        ids.push_back(T.getTsize() + i - delta.size());
+    }
+    size_t left_id = hasLeft ? ids[0] : SIZE_MAX;
+    size_t right_id = hasRight ? ids[count - 1] : SIZE_MAX;
+    std::vector<size_t> upper_id(ids.begin() + (hasLeft ? 1 : 0), ids.begin() + (hasLeft ? 1 : 0) + upper.size());
+    std::vector<size_t> lower_id(ids.begin() + (hasLeft ? 1 : 0) + upper.size(), ids.begin() + (hasLeft ? 1 : 0) + upper.size() + lower.size());
+
+    //the trapezoids that are adjacent to the new trapezoids but are not intersected by the segment
+    size_t first_top_left = hasLeft ? left_id : upper_id.front();
+    size_t first_bottom_left = hasLeft ? left_id : lower_id.front();
+    size_t last_top_right = hasRight ? right_id : upper_id.back();
+    size_t last_bottom_right = hasRight ? right_id : lower_id.back();
+
+    std::vector<Trapezoid> created;
+    if(hasLeft){
+        Trapezoid tleft = Trapezoid(old[0].getLeftpId(), p, old[0].getTopId(), old[0].getBottomId());
+        tleft.setNeighbor(TOP_LEFT, old[0].getNeighbor(TOP_LEFT));
+        tleft.setNeighbor(BOTTOM_LEFT, old[0].getNeighbor(BOTTOM_LEFT));
+        tleft.setNeighbor(TOP_RIGHT, upper_id.front());
+        tleft.setNeighbor(BOTTOM_RIGHT, lower_id.front());
+        created.push_back(tleft);
+    }
+    for(size_t i = 0; i < upper.size(); i++){
+        //a piece above the segment is adjacent to the previous and the next piece along the segment
+        size_t last = upperFirst[i + 1] - 1;
+        upper[i].setNeighbor(TOP_LEFT, i == 0 ? (hasLeft ? left_id : old[0].getNeighbor(TOP_LEFT)) : old[upperFirst[i]].getNeighbor(TOP_LEFT));
+        upper[i].setNeighbor(BOTTOM_LEFT, i == 0 ? SIZE_MAX : upper_id[i - 1]);
+        upper[i].setNeighbor(TOP_RIGHT, i == upper.size() - 1 ? (hasRight ? right_id : old[k].getNeighbor(TOP_RIGHT)) : old[last].getNeighbor(TOP_RIGHT));
+        upper[i].setNeighbor(BOTTOM_RIGHT, i == upper.size() - 1 ? SIZE_MAX : upper_id[i + 1]);
+        created.push_back(upper[i]);
+    }
+    for(size_t i = 0; i < lower.size(); i++){
+        //a piece below the segment is adjacent to the previous and the next piece along the segment
+        size_t last = lowerFirst[i + 1] - 1;
+        lower[i].setNeighbor(TOP_LEFT, i == 0 ? SIZE_MAX : lower_id[i - 1]);
+        lower[i].setNeighbor(BOTTOM_LEFT, i == 0 ? (hasLeft ? left_id : old[0].getNeighbor(BOTTOM_LEFT)) : old[lowerFirst[i]].getNeighbor(BOTTOM_LEFT));
+        lower[i].setNeighbor(TOP_RIGHT, i == lower.size() - 1 ? SIZE_MAX : lower_id[i + 1]);
+        lower[i].setNeighbor(BOTTOM_RIGHT, i == lower.size() - 1 ? (hasRight ? right_id : old[k].getNeighbor(BOTTOM_RIGHT)) : old[last].getNeighbor(BOTTOM_RIGHT));
+        created.push_back(lower[i]);
+    }
+    if(hasRight){
+        Trapezoid tright = Trapezoid(q, old[k].getRightpId(), old[k].getTopId(), old[k].getBottomId());
+        tright.setNeighbor(TOP_LEFT, upper_id.back());
+        tright.setNeighbor(BOTTOM_LEFT, lower_id.back());
+        tright.setNeighbor(TOP_RIGHT, old[k].getNeighbor(TOP_RIGHT));
+        tright.setNeighbor(BOTTOM_RIGHT, old[k].getNeighbor(BOTTOM_RIGHT));
+        created.push_back(tright);
+    }
+
+    //store the new trapezoids, the ids after the end of the map are in increasing order
+    for(size_t i = 0; i < created.size(); i++){
+        if(i < delta.size()){
+            T.replaceTrapezoid(ids[i], created[i]);
         }
         else{
-            b_id = T.getTrapezoid(tbottom).getDagId();
+            T.insertTrapezoid(created[i]);
         }
     }
 
-    if(left){
-        if(T.getTrapezoid(tbottom).getDagId() == SIZE_MAX){
-            b_id = D.insertInVector(b);
+    //the trapezoids around the new ones point to them
+    setNeighborIfExists(T, old[0].getNeighbor(TOP_LEFT), TOP_RIGHT, first_top_left);
+    setNeighborIfExists(T, old[0].getNeighbor(BOTTOM_LEFT), BOTTOM_RIGHT, first_bottom_left);
+    setNeighborIfExists(T, old[k].getNeighbor(TOP_RIGHT), TOP_LEFT, last_top_right);
+    setNeighborIfExists(T, old[k].getNeighbor(BOTTOM_RIGHT), BOTTOM_LEFT, last_bottom_right);
+    for(size_t i = 0; i < upper.size(); i++){
+        if(i > 0){
+            setNeighborIfExists(T, old[upperFirst[i]].getNeighbor(TOP_LEFT), TOP_RIGHT, upper_id[i]);
         }
-        else{
-            b_id = T.getTrapezoid(tbottom).getDagId();
+        if(i < upper.size() - 1){
+            setNeighborIfExists(T, old[upperFirst[i + 1] - 1].getNeighbor(TOP_RIGHT), TOP_LEFT, upper_id[i]);
         }
     }
-    else{
-        if(T.getTrapezoid(tother).getDagId() == SIZE_MAX){
-            c_id = D.insertInVector(c);
+    for(size_t i = 0; i < lower.size(); i++){
+        if(i > 0){
+            setNeighborIfExists(T, old[lowerFirst[i]].getNeighbor(BOTTOM_LEFT), BOTTOM_RIGHT, lower_id[i]);
         }
-        else{
-            c_id = T.getTrapezoid(tother).getDagId();
+        if(i < lower.size() - 1){
+            setNeighborIfExists(T, old[lowerFirst[i + 1] - 1].getNeighbor(BOTTOM_RIGHT), BOTTOM_LEFT, lower_id[i]);
         }
     }
 
-    //set left and right children
-    if(left){
-        D.getElementInDVector(p_id).setLeftc(c_id);
-        D.getElementInDVector(p_id).setRightc(s_id);
-        D.getElementInDVector(s_id).setLeftc(a_id);
-        D.getElementInDVector(s_id).setRightc(b_id);
-    }
-    else{
-        D.getElementInDVector(p_id).setLeftc(s_id);
-        D.getElementInDVector(p_id).setRightc(c_id);
-        D.getElementInDVector(s_id).setLeftc(a_id);
-        D.getElementInDVector(s_id).setRightc(b_id);
+    std::vector<size_t> tupper, tlower;
+    for(size_t j = 0; j <= k; j++){
+        tupper.push_back(upper_id[upperOf[j]]);
+        tlower.push_back(lower_id[lowerOf[j]]);
     }
+    updateDag(T,D,s,leaves,left_id,right_id,tupper,tlower);
+}
 
-
-    //push the points and the segment in the respective vector
-    if(!sAlreadyPresent){
-        D.insertInVector(s);
+/**
+ * @brief algorithms::updateDag
+ * This method updates the Dag after the segment insertion. The leaf of every intersected trapezoid is replaced by
+ * the node of the segment, whose children are the leaves of the trapezoids above and below the segment. The leaf of the
+ * first trapezoid is replaced by the node of the left endpoint when there is a trapezoid to the left, and the leaf of the
+ * last trapezoid by the node of the right endpoint when there is a trapezoid to the right.
+ * The trapezoids produced by a merge have a single leaf, shared by the nodes of the segment.
+ * @param T a reference to the trapezoidal map
+ * @param D a reference to the Dag
+ * @param s the id of the segment inserted
+ * @param leaves the ids of the dag nodes of the intersected trapezoids, from left to right
+ * @param tleft the id of the trapezoid to the left of the segment, SIZE_MAX if there is none
+ * @param tright the id of the trapezoid to the right of the segment, SIZE_MAX if there is none
+ * @param tupper the id of the trapezoid above the segment for every intersected trapezoid
+ * @param tlower the id of the trapezoid below the segment for every intersected trapezoid
+ */
+void algorithms::updateDag(TrapezoidalMap& T, Dag& D, size_t s, const std::vector<size_t>& leaves, size_t tleft, size_t tright,
+                           const std::vector<size_t>& tupper, const std::vector<size_t>& tlower){
+    size_t k = leaves.size() - 1;
+    for(size_t j = 0; j <= k; j++){
+        DagNode root = DagNode(SEGMENT, s);
+        root.setLeftc(getLeaf(T,D,tupper[j])); //the trapezoid above the segment
+        root.setRightc(getLeaf(T,D,tlower[j])); //the trapezoid below the segment
+
+        if(j == k && tright != SIZE_MAX){
+            size_t child = D.insertInVector(root);
+            root = DagNode(POINT, T.getSegmentRightpId(s));
+            root.setLeftc(child);
+            root.setRightc(getLeaf(T,D,tright));
+        }
+        if(j == 0 && tleft != SIZE_MAX){
+            size_t child = D.insertInVector(root);
+            root = DagNode(POINT, T.getSegmentLeftpId(s));
+            root.setLeftc(getLeaf(T,D,tleft));
+            root.setRightc(child);
+        }
+        D.replaceNode(leaves[j], root); //the parents of the old leaf now point to the new subtree
     }
+}
 
-    if(left){
-        if(!pAlreadyPresent){
-            D.insertInVector(s.p1());
+/**
+ * @brief algorithms::removeSegment
+ * This method removes a segment from the trapezoidal map without building it again. The trapezoids above and below
+ * the segment are found by walking the dag to one of them and then along the segment, so the cost is proportional
+ * to their number. An endpoint that is not shared with another segment disappears together with its walls, and the
+ * trapezoids to its left or right are merged as well. The area is divided again by the walls of the endpoints that
+ * remain: every merged trapezoid takes the top of the chain above and the bottom of the chain below.
+ * The merged trapezoids take the ids of the old ones, the ids left over are filled with the last trapezoids of the
+ * map, so the table stays contiguous. The leaf of every old trapezoid becomes a balanced search on the x coordinate
+ * among the merged trapezoids that overlap it, so the other nodes of the dag don't change. The nodes of the removed
+ * segment stay in the dag: they still divide the plane correctly, but they make the queries longer. The dag is never
+ * built again here, so a removal never stalls: isCompactionDue() tells the caller when to call
+ * compactTrapezoidalMap().
+ * @param T the trapezoidal map
+ * @param D the Dag of the trapezoidal map
+ * @param s the id of the segment to remove
+ * @return false if there is no segment with that id in the map, true otherwise
+ */
+bool algorithms::removeSegment(TrapezoidalMap& T, Dag& D, size_t s){
+    if(s >= T.getSegmentsSize() || T.isSegmentRemoved(s)){
+        return false;
+    }
+    size_t p = T.getSegmentLeftpId(s);
+    size_t q = T.getSegmentRightpId(s);
+
+    //the trapezoids above and below the segment, from left to right
+    std::vector<size_t> upper, lower;
+    size_t t = locateAlongSegment(T,D,s,true);
+    while(T.getTrapezoid(t).getLeftpId() != p){
+        t = T.getTrapezoid(t).getNeighbor(BOTTOM_LEFT);
+    }
+    for(upper.push_back(t); T.getTrapezoid(t).getRightpId() != q; upper.push_back(t)){
+        t = T.getTrapezoid(t).getNeighbor(BOTTOM_RIGHT);
+    }
+    t = locateAlongSegment(T,D,s,false);
+    while(T.getTrapezoid(t).getLeftpId() != p){
+        t = T.getTrapezoid(t).getNeighbor(TOP_LEFT);
+    }
+    for(lower.push_back(t); T.getTrapezoid(t).getRightpId() != q; lower.push_back(t)){
+        t = T.getTrapezoid(t).getNeighbor(TOP_RIGHT);
+    }
+
+    //an endpoint disappears when no other segment ends in it: then the trapezoid beyond it is adjacent to both sides
+    size_t tleft = T.getTrapezoid(upper.front()).getNeighbor(TOP_LEFT);
+    if(tleft != T.getTrapezoid(lower.front()).getNeighbor(BOTTOM_LEFT)){
+        tleft = SIZE_MAX;
+    }
+    size_t tright = T.getTrapezoid(upper.back()).getNeighbor(TOP_RIGHT);
+    if(tright != T.getTrapezoid(lower.back()).getNeighbor(BOTTOM_RIGHT)){
+        tright = SIZE_MAX;
+    }
+    size_t pRemoved = tleft != SIZE_MAX ? p : SIZE_MAX;
+    size_t qRemoved = tright != SIZE_MAX ? q : SIZE_MAX;
+
+    //the chains of old trapezoids along the top and the bottom of the merged area
+    std::vector<size_t> top, bottom;
+    if(tleft != SIZE_MAX){
+        top.push_back(tleft);
+        bottom.push_back(tleft);
+    }
+    top.insert(top.end(), upper.begin(), upper.end());
+    bottom.insert(bottom.end(), lower.begin(), lower.end());
+    if(tright != SIZE_MAX){
+        top.push_back(tright);
+        bottom.push_back(tright);
+    }
+
+    //the merged trapezoids lie between the walls of both chains, from left to right, and every old trapezoid
+    //overlaps a range of them
+    std::vector<MergedTrapezoid> merged;
+    std::vector<size_t> topFirst(top.size(), SIZE_MAX), topLast(top.size());
+    std::vector<size_t> bottomFirst(bottom.size(), SIZE_MAX), bottomLast(bottom.size());
+    size_t end = T.getTrapezoid(top.back()).getRightpId();
+    size_t leftp = T.getTrapezoid(top.front()).getLeftpId();
+    size_t i = 0, j = 0;
+    size_t topLeft = 0, bottomLeft = 0;
+    while(true){
+        size_t ti = i, bj = j; //the last old trapezoids before the next wall of each chain
+        while(T.getTrapezoid(top[ti]).getRightpId() == pRemoved || T.getTrapezoid(top[ti]).getRightpId() == qRemoved){
+            ti++;
+        }
+        while(T.getTrapezoid(bottom[bj]).getRightpId() == pRemoved || T.getTrapezoid(bottom[bj]).getRightpId() == qRemoved){
+            bj++;
+        }
+        size_t rt = T.getTrapezoid(top[ti]).getRightpId();
+        size_t rb = T.getTrapezoid(bottom[bj]).getRightpId();
+        size_t rightp = rt == rb || T.getPoint(rt).x() < T.getPoint(rb).x() ? rt : rb;
+
+        MergedTrapezoid m;
+        m.t = Trapezoid(leftp, rightp, T.getTrapezoid(top[i]).getTopId(), T.getTrapezoid(bottom[j]).getBottomId());
+        m.topLeft = topLeft;
+        m.bottomLeft = bottomLeft;
+        m.topRight = rightp == rt ? ti : SIZE_MAX;
+        m.bottomRight = rightp == rb ? bj : SIZE_MAX;
+        for(size_t k = i; k <= ti; k++){
+            topFirst[k] = std::min(topFirst[k], merged.size());
+            topLast[k] = merged.size();
+        }
+        for(size_t k = j; k <= bj; k++){
+            bottomFirst[k] = std::min(bottomFirst[k], merged.size());
+            bottomLast[k] = merged.size();
+        }
+        merged.push_back(m);
+        if(rightp == end){
+            break;
         }
-    }
-    else{
-        if(!pAlreadyPresent){
-            D.insertInVector(s.p2());
+        topLeft = bottomLeft = SIZE_MAX;
+        if(rightp == rt){
+            i = ti + 1;
+            topLeft = i;
         }
+        if(rightp == rb){
+            j = bj + 1;
+            bottomLeft = j;
+        }
+        leftp = rightp;
     }
 
-    tId.push_back(a_id);
-    tId.push_back(b_id);
-    tId.push_back(c_id);
-
-    return tId;
-
-
-
-}
-/**
- * @brief algorithms::updateDag
- * This override of updateDag is used when a split in 2 occurs. As always, the vector of the dagNode id's created for the trapezoids
- * in order to update the field of the trapezoid that stores the position in the Dag in which the trapezoid is present
- * @param D the Dag to update
- * @param s the segment that caused the split and thus the update of the Dag
- * @param tsplit the id of the DagNode representing the trapezoid that is intersected by the segment
- * @param ttop the id of the Trapezoid above the segment
- * @param tbottom the id of the Trapezoid below the segment
- * @return A vector with the id's of the DagNodes representing the top and bottom trapezoid
- */
-std::vector<size_t> algorithms::updateDag(TrapezoidalMap& T, Dag& D, cg3::Segment2d s, size_t tsplit, size_t ttop, size_t tbottom){
-    //obtain the size of the vectors of dagNodes, points and segment
-    bool alreadyPresent;
-    size_t entity_position;
-    D.findSegment(s,alreadyPresent,entity_position);
-
-    size_t sSize = D.getVectorSize(SEGMENT);
-    DagNode sn;
-
-    //create id of dag nodes
-    size_t s_id, a_id, b_id = SIZE_MAX;
-
-    std::vector<size_t> tId;
-
-    //Create point, segment and trapezoid node
-
-    if(alreadyPresent){
-        sn = DagNode(SEGMENT,entity_position);
+    //the old trapezoids, each one once, with the merged trapezoids they overlap and their leaves
+    std::vector<size_t> old, oldFirst, oldLast, oldLeaf;
+    for(size_t k = 0; k < top.size(); k++){
+        old.push_back(top[k]);
+        oldFirst.push_back(topFirst[k]);
+        oldLast.push_back(topLast[k]);
     }
-    else{
-        sn = DagNode(SEGMENT,sSize);
-    }
-    DagNode a = DagNode(TRAPEZOID, ttop);
-    DagNode b = DagNode(TRAPEZOID, tbottom);
-
-    //push the nodes in the dag vector
-    s_id = tsplit;
-    D.replaceNode(tsplit,sn);
-
-    if(T.getTrapezoid(ttop).getDagId() == SIZE_MAX){
-        a_id = D.insertInVector(a);
+    for(size_t k = 0; k < bottom.size(); k++){
+        if(bottom[k] != tleft && bottom[k] != tright){
+            old.push_back(bottom[k]);
+            oldFirst.push_back(bottomFirst[k]);
+            oldLast.push_back(bottomLast[k]);
+        }
     }
-    else{
-        a_id = T.getTrapezoid(ttop).getDagId();
+    for(size_t id : old){
+        oldLeaf.push_back(T.getTrapezoid(id).getDagId());
     }
 
-    if(T.getTrapezoid(tbottom).getDagId() == SIZE_MAX){
-        b_id = D.insertInVector(b);
+    //the neighbors of the merged trapezoids: inside the area the previous and the next one, outside the neighbors
+    //of the old trapezoids that start or end at the same wall. They are read before the old trapezoids are replaced.
+    for(size_t k = 0; k < merged.size(); k++){
+        MergedTrapezoid& m = merged[k];
+        m.t.setNeighbor(TOP_LEFT, m.topLeft != SIZE_MAX ? T.getTrapezoid(top[m.topLeft]).getNeighbor(TOP_LEFT) : old[k - 1]);
+        m.t.setNeighbor(BOTTOM_LEFT, m.bottomLeft != SIZE_MAX ? T.getTrapezoid(bottom[m.bottomLeft]).getNeighbor(BOTTOM_LEFT) : old[k - 1]);
+        m.t.setNeighbor(TOP_RIGHT, m.topRight != SIZE_MAX ? T.getTrapezoid(top[m.topRight]).getNeighbor(TOP_RIGHT) : old[k + 1]);
+        m.t.setNeighbor(BOTTOM_RIGHT, m.bottomRight != SIZE_MAX ? T.getTrapezoid(bottom[m.bottomRight]).getNeighbor(BOTTOM_RIGHT) : old[k + 1]);
     }
-    else{
-        b_id = T.getTrapezoid(tbottom).getDagId();
-    }
-
-    //set left and right children
-    D.getElementInDVector(s_id).setLeftc(a_id);
-    D.getElementInDVector(s_id).setRightc(b_id);
 
-    //push the segment in the respective vector
-    if(!alreadyPresent){
-        D.insertInVector(s);
+    //the merged trapezoids take the first ids of the old ones, the trapezoids around them point to them
+    for(size_t k = 0; k < merged.size(); k++){
+        T.replaceTrapezoid(old[k], merged[k].t);
     }
-
-    tId.push_back(a_id);
-    tId.push_back(b_id);
-    return tId;
-}
-
-/**
- * @brief algorithms::updateDag
- * This algorithm performs an update of the Dag when a split in 4 occurs with one of the endpoints of the segment being coincident
- * to another one
- * @param D, a reference to the Dag to update
- * @param s, the segment that caused the split
- * @param coincidence, LEFT if the left endpoint is coincident, RIGHT if the right endpoint is coincident
- * @param tsplit, the id of the trapezoid intersected by the segment
- * @param tother, the id of the trapezoid to the side of the segment, in case of left-coincidence, tother is to the right, while in case of
- * right coincidence, tother is to the left
- * @param ttop, the id of the trapezoid above the segment
- * @param tbottom, the id of the trapezoid below the segment
- * @return a vector with the dag ids of the three trapezoids
- */
-std::vector<size_t> algorithms::updateDag(TrapezoidalMap& T, Dag& D, cg3::Segment2d s, coincidence coincidence, size_t tsplit, size_t tother, size_t ttop, size_t tbottom){
-    //obtain the size of the vectors of dagNodes, points and segment
-    size_t pSize = D.getVectorSize(POINT);
-    size_t sSize = D.getVectorSize(SEGMENT);
-    std::vector<size_t> tId;
-
-    DagNode p, sn,a,b,c;
-
-    //create id of dag nodes
-    size_t p_id, s_id, a_id, b_id, c_id = SIZE_MAX;
-
-    //Create point, segment and trapezoid node
-    p = DagNode(POINT,pSize);
-    sn = DagNode(SEGMENT, sSize);
-
-    switch(coincidence){
-    case LEFT:
-        a = DagNode(TRAPEZOID,ttop);
-        b = DagNode(TRAPEZOID,tbottom);
-        c = DagNode(TRAPEZOID,tother);
-        break;
-    case RIGHT:
-        a = DagNode(TRAPEZOID,tother);
-        b = DagNode(TRAPEZOID,ttop);
-        c = DagNode(TRAPEZOID,tbottom);
-        break;
-    default:
-        break;
-    }
-
-    p_id = D.replaceNode(tsplit,p);
-    s_id = D.insertInVector(sn);
-
-    switch(coincidence){
-    case LEFT:
-        if(T.getTrapezoid(ttop).getDagId() == SIZE_MAX){
-            a_id = D.insertInVector(a);
+    for(size_t k = 0; k < merged.size(); k++){
+        const MergedTrapezoid& m = merged[k];
+        if(m.topLeft != SIZE_MAX){
+            setNeighborIfExists(T, m.t.getNeighbor(TOP_LEFT), TOP_RIGHT, old[k]);
         }
-        else{
-            a_id = T.getTrapezoid(ttop).getDagId();
+        if(m.bottomLeft != SIZE_MAX){
+            setNeighborIfExists(T, m.t.getNeighbor(BOTTOM_LEFT), BOTTOM_RIGHT, old[k]);
         }
-
-        if(T.getTrapezoid(tbottom).getDagId() == SIZE_MAX){
-            b_id = D.insertInVector(b);
+        if(m.topRight != SIZE_MAX){
+            setNeighborIfExists(T, m.t.getNeighbor(TOP_RIGHT), TOP_LEFT, old[k]);
         }
-        else{
-            b_id = T.getTrapezoid(tbottom).getDagId();
+        if(m.bottomRight != SIZE_MAX){
+            setNeighborIfExists(T, m.t.getNeighbor(BOTTOM_RIGHT), BOTTOM_LEFT, old[k]);
         }
+    }
 
-        if(T.getTrapezoid(tother).getDagId() == SIZE_MAX){
-            c_id = D.insertInVector(c);
-        }
-        else{
-            c_id = T.getTrapezoid(tother).getDagId();
+    //every merged trapezoid reuses the leaf of an old trapezoid that overlaps only it, if there is one
+    std::vector<size_t> leaves(merged.size(), SIZE_MAX);
+    std::vector<char> reused(old.size(), 0);
+    for(size_t k = 0; k < old.size(); k++){
+        if(oldFirst[k] == oldLast[k] && leaves[oldFirst[k]] == SIZE_MAX){
+            leaves[oldFirst[k]] = oldLeaf[k];
+            reused[k] = 1;
         }
-
-        break;
-
-    case RIGHT:
-        if(T.getTrapezoid(tother).getDagId() == SIZE_MAX){
-            a_id = D.insertInVector(a);
+    }
+    for(size_t k = 0; k < merged.size(); k++){
+        if(leaves[k] == SIZE_MAX){
+            DagNode leaf = DagNode(TRAPEZOID, old[k]);
+            leaves[k] = D.insertInVector(leaf);
         }
         else{
-            a_id = T.getTrapezoid(tother).getDagId();
+            D.replaceNode(leaves[k], DagNode(TRAPEZOID, old[k]));
         }
+        T.setDagId(old[k], leaves[k]);
+    }
 
-        if(T.getTrapezoid(ttop).getDagId() == SIZE_MAX){
-            b_id = D.insertInVector(b);
+    //the other leaves become a search among the merged trapezoids they overlap, the parents of the leaves don't change
+    for(size_t k = 0; k < old.size(); k++){
+        if(reused[k]){
+            continue;
         }
-        else{
-            b_id = T.getTrapezoid(ttop).getDagId();
-        }
-
-        if(T.getTrapezoid(tbottom).getDagId() == SIZE_MAX){
-            c_id = D.insertInVector(c);
+        if(oldFirst[k] == oldLast[k]){
+            //a node with a single child: both sides of the left endpoint lead to the same trapezoid
+            DagNode node = DagNode(POINT, p);
+            node.setLeftc(leaves[oldFirst[k]]);
+            node.setRightc(leaves[oldFirst[k]]);
+            D.replaceNode(oldLeaf[k], node);
         }
         else{
-            c_id = T.getTrapezoid(tbottom).getDagId();
+            D.replaceNode(oldLeaf[k], searchNode(D, merged, leaves, oldFirst[k], oldLast[k]));
         }
-    default:
-        break;
-    }
-
-    switch(coincidence){
-    case LEFT:
-        D.getElementInDVector(p_id).setLeftc(s_id);
-        D.getElementInDVector(p_id).setRightc(c_id);
-        D.getElementInDVector(s_id).setLeftc(a_id);
-        D.getElementInDVector(s_id).setRightc(b_id);
-        D.insertInVector(s.p2());
-        break;
-    case RIGHT:
-        D.getElementInDVector(p_id).setLeftc(a_id);
-        D.getElementInDVector(p_id).setRightc(s_id);
-        D.getElementInDVector(s_id).setLeftc(b_id);
-        D.getElementInDVector(s_id).setRightc(c_id);
-        D.insertInVector(s.p1());
-        break;
-    default:
-        break;
-    }
-
-    D.insertInVector(s);
-    tId.push_back(a_id);
-    tId.push_back(b_id);
-    tId.push_back(c_id);
-    return tId;
+    }
+
+    //the ids left over are filled from the end of the table, the highest first so the last trapezoid is never one of them
+    std::vector<size_t> holes(old.begin() + merged.size(), old.end());
+    std::sort(holes.begin(), holes.end(), std::greater<size_t>());
+    for(size_t hole : holes){
+        moveLastTrapezoid(T, D, hole);
+    }
+
+    T.removeSegment(s);
+    D.addStaleSegment();
+    return true;
 }
 
 /**
- * @brief algorithms::updateDag
- * This algorithm performs an update of the Dag when a split in 4 occurs when both endpoints are shared
- * or when a split in 3 with an endpoint coincident occurs.
- * @param D, a reference to the Dag to update
- * @param s, the segment that caused the split
- * @param coincidence, the end point that is coincident (LEFT for a split in 3 to the left, RIGHT for a
- * split in 3 to the right, BOTH for a split in 2 with both endpoints shared)
- * @param tsplit, the id of the trapezoid intersected by the segment
- * @param ttop, the id of the trapezoid above the segment
- * @param tbottom, the id of the trapezoid below the segment
- * @return a vector with the dag ids of the two trapezoids
+ * @brief algorithms::isCompactionDue
+ * This method tells if the map should be compacted: the removed segments whose nodes are still in the dag are more
+ * than the segments of the map, so calling compactTrapezoidalMap() at this point amortizes its cost over the
+ * removals. The caller chooses when to do it, e.g. when the map is idle.
+ * @param T the trapezoidal map
+ * @param D the Dag of the trapezoidal map
+ * @return true if the map should be compacted
  */
-std::vector<size_t> algorithms::updateDag(TrapezoidalMap& T, Dag& D, cg3::Segment2d s, coincidence coincidence, size_t tsplit, size_t ttop, size_t tbottom){
-    //obtain the size of the vectors of dagNodes, points and segment
-    size_t sSize = D.getVectorSize(SEGMENT);
-    std::vector<size_t> tId;
-
-    DagNode sn,a,b;
-
-    //create id of dag nodes
-    size_t s_id, a_id, b_id = SIZE_MAX;
-
-    //Create point, segment and trapezoid node
-    sn = DagNode(SEGMENT, sSize);
-    a  = DagNode(TRAPEZOID,ttop);
-    b  = DagNode(TRAPEZOID,tbottom);
-
-    s_id = D.replaceNode(tsplit,sn);
-
-    if(T.getTrapezoid(ttop).getDagId() == SIZE_MAX){
-        a_id = D.insertInVector(a);
-    }
-    else{
-        a_id = T.getTrapezoid(ttop).getDagId();
-    }
+bool algorithms::isCompactionDue(const TrapezoidalMap& T, const Dag& D){
+    return D.getStaleSegmentsSize() > T.getSegmentsSize() - T.getRemovedSegmentsSize();
+}
 
-    if(T.getTrapezoid(tbottom).getDagId() == SIZE_MAX){
-        b_id = D.insertInVector(b);
+/**
+ * @brief algorithms::compactTrapezoidalMap
+ * This method builds the trapezoidal map and the dag again from the segments that have not been removed, in a random
+ * order given by the seed. The nodes of the removed segments are dropped from the dag, so the queries are as short as
+ * after a new construction, and the segments keep their ids. It is never called by removeSegment(): the caller
+ * calls it when isCompactionDue() is true, with the seed of the construction so that the rebuild can be reproduced.
+ * @param T the trapezoidal map
+ * @param D the Dag of the trapezoidal map
+ * @param seed the seed of the random insertion order
+ */
+void algorithms::compactTrapezoidalMap(TrapezoidalMap& T, Dag& D, unsigned long seed){
+    std::vector<size_t> segments;
+    for(size_t s = 0; s < T.getSegmentsSize(); s++){
+        if(!T.isSegmentRemoved(s)){
+            segments.push_back(s);
+        }
     }
-    else{
-        b_id = T.getTrapezoid(tbottom).getDagId();
+    T.clearTrapezoids();
+    D.clearDag();
+    T.reserve(0, T.getMap().getHugePages());
+    D.reserve(T.getSegmentsSize(), D.getdVector().getHugePages());
+    for(size_t i : randomInsertionOrder(segments.size(), seed)){
+        insertSegment(T,D,segments[i]);
     }
+}
 
-    D.getElementInDVector(s_id).setLeftc(a_id);
-    D.getElementInDVector(s_id).setRightc(b_id);
-    D.insertInVector(s);
+/**
+ * @brief algorithms::queryPoint
+ * This method queries the Dag with a single point
+ * @param dag the dag to use for the query
+ * @param p the point for which to check the trapezoid in which the point is contained
+ * @return the id of the node of the DagVector representing the trapezoid containing the point
+ */
+size_t algorithms::queryPoint(const Dag& dag, const cg3::Point2d& p){
+    size_t depth;
+    return queryPoint(dag,p,p,depth).getDagId();
+}
 
-    tId.push_back(a_id);
-    tId.push_back(b_id);
-    return tId;
+/**
+ * @brief algorithms::queryPoint
+ * This method queries the Dag with the left endpoint p1 of a segment, the right endpoint p2 is used to
+ * decide the side when p1 is coincident with the endpoint of a segment already in the dag
+ * @param dag the dag to use for the query
+ * @param p1 the left endpoint of the segment
+ * @param p2 the right endpoint of the segment
+ * @return the id of the node of the DagVector representing the trapezoid containing the point
+ */
+size_t algorithms::queryPoint(const Dag& dag, const cg3::Point2d& p1, const cg3::Point2d& p2){
+    size_t depth;
+    return queryPoint(dag,p1,p2,depth).getDagId();
 }
 
-size_t algorithms::queryPoint(Dag dag, cg3::Point2d p){
-    return queryPoint(dag,p,p);
+/**
+ * @brief algorithms::queryPoint
+ * This method queries the Dag with a single point and returns the leaf reached together with its depth
+ * @param dag the dag to use for the query
+ * @param p the query point
+ * @param[out] depth the number of nodes visited before reaching the leaf
+ * @return a reference to the leaf of the dag representing the trapezoid containing the point
+ */
+const DagNode& algorithms::queryPoint(const Dag& dag, const cg3::Point2d& p, size_t& depth){
+    return queryPoint(dag,p,p,depth);
 }
 
 /**
  * This method queries the Dag with a point.
- * The query returns the id of the node representing in the Dag the trapezoid that intersects the point
+ * The query returns the leaf of the dag representing the trapezoid that intersects the point
  * If the current node is a point, then it is checked if the querypoint lies to the left or to the right
  * of the point in the node. If it is in the left, the query proceeds to the left, otherwise to the right.
  * If the current node is a segment, then it is checked if the querypoint is above or below the segment.
  * If it is above, the query proceeds to the left. If it is below, the query proceeds to the right.
  * If the current node is a trapezoid, return that node
+ * The nodes are visited by reference, so neither the dag nor its nodes are copied during the query.
  * @brief algorithms::queryPoint
  * @param dag the dag to use for the query
- * @param p the point for which to check the trapezoid in which the point is contained
- * @return the id of the node of the DagVector representing the trapezoid containing the point
+ * @param p1 the point for which to check the trapezoid in which the point is contained
+ * @param p2 the right endpoint of the segment when p1 is a left endpoint, p1 itself otherwise
+ * @param[out] depth the number of nodes visited before reaching the leaf
+ * @return a reference to the leaf of the dag representing the trapezoid containing the point
  */
-size_t algorithms::queryPoint(Dag dag, cg3::Point2d p1, cg3::Point2d p2){
-    DagNode d = dag.getElementInDVector(0); //start from the root of the dag
+const DagNode& algorithms::queryPoint(const Dag& dag, const cg3::Point2d& p1, const cg3::Point2d& p2, size_t& depth){
+    const DagNode * d = &dag.getElementInDVector(0); //start from the root of the dag
+    depth = 0;
     while(true){
-        switch(d.getNodeType()){ //check the type of the node
+        switch(d->getNodeType()){ //check the type of the node
             case POINT: //if it's a point
-                if(p1.x() < dag.getElementInPVector(d.getEntityId()).x()){
+                if(p1.x() < dag.getElementInPVector(d->getEntityId()).x()){
                     //check if the query point lies to the left of the point of the node
-                    d = dag.getElementInDVector(d.getLeftC());
+                    d = &dag.getElementInDVector(d->getLeftC());
                     //if yes, go to the left child
                 }
                 else{
-                    d = dag.getElementInDVector(d.getRightC());
+                    d = &dag.getElementInDVector(d->getRightC());
                     //if no, go to the right child
                 }
             break;
-            case SEGMENT:{ //if it's a segment
-                cg3::Segment2d s = dag.getElementInSVector(d.getEntityId());
-                if(utility::isAbove(s,p1)){//check if the point is above the segment
-                    d = dag.getElementInDVector(d.getLeftC()); //if yes, go to the left child
-                }
-                else if(utility::pointEqual(s.p1(),p1) || utility::pointEqual(s.p2(),p1)){
-                    if(utility::slope(s.p1(),s.p2()) < utility::slope(p1,p2)){
-                        d = dag.getElementInDVector(d.getLeftC());
-                    }
-                    else{
-                        d = dag.getElementInDVector(d.getRightC());
-                    }
+            case SEGMENT: //if it's a segment
+                if(goesLeft(dag.getElementInSVector(d->getEntityId()),p1,p2)){//check if the point is above the segment
+                    d = &dag.getElementInDVector(d->getLeftC()); //if yes, go to the left child
                 }
                 else{
-                   d = dag.getElementInDVector(d.getRightC()); //if no, go to the right child
+                   d = &dag.getElementInDVector(d->getRightC()); //if no, go to the right child
                 }
-            }
             break;
             case TRAPEZOID: //if it's a trapezoid
-                return d.getDagId();
-                //return the id of the node of the dag that represents that trapezoid
+                return *d;
+                //return the leaf of the dag that represents that trapezoid
             break;
         default:
             break;
+        }
+        depth++;
     }
-   }
+}
+
+/**
+ * @brief algorithms::queryTrapezoid
+ * This method queries the Dag with a point and directly returns the trapezoid containing it
+ * @param dag the dag to use for the query
+ * @param p the query point
+ * @return the id of the trapezoid in the trapezoidal map that contains the point
+ */
+size_t algorithms::queryTrapezoid(const Dag& dag, const cg3::Point2d& p){
+    size_t depth;
+    return queryPoint(dag,p,p,depth).getEntityId();
 }
 /**
- * @brief algorithms::splitin2
- * This algorithm performs a split in 2. The old trapezoid is divided in one above and one below. One of the two has to be merged with
- * a previous trapezoid t_merge. The boolean parameter merge_above establishes which of the two has to be merged.
- * The neighbors of the trapezoids are set.
- * The updateDag() method is called in order to reflect the changes in the trapezoidal map in the DAG as well.
- * @param T The trapezoidal Map containing the trapezoids
- * @param s The segment that caused the split
- * @param D The dag that is a search structure for the trapezoidal Map
- * @param trap_id the id of the trapezoid that is intersected by the segment
- * @param merge_above a boolean value that establishes if the trapezoid that has to be merged with the previous is the top or bottom one
- * @param t_merge The trapezoid from the previous split that needs to be merged
- * @param t_prev The id of the other trapezoid from the previous split. It is necessary in order to update its neighbors.
- * @param next The id of the next trapezoid that is intersected by the segment. In this way, the neighbors of this trapezoid
- * won't be updated, since a split will occur after this one
+ * @brief algorithms::queryPoints
+ * This method locates a batch of points in the Dag. Instead of walking every point from the root, the points
+ * are walked through the dag together: all the points that reached the same node are stored in a contiguous
+ * range, which is partitioned in the points going to the left child and the points going to the right child.
+ * The ranges are visited depth first, so the nodes of a subtree stay in cache while all of its points are
+ * processed, and the children of a node are prefetched while the node is partitioning its points.
+ * @param dag the dag to use for the query
+ * @param points the query points
+ * @param[out] out the ids of the trapezoids containing the points, in the same order of the input
  */
-void algorithms::splitin2(TrapezoidalMap& T, const cg3::Segment2d& s, Dag & D, size_t trap_id, bool& merge_above, Trapezoid& t_merge, size_t & t_prev, size_t next, bool& first){
-    char dummy;
-    Trapezoid ttop, tbottom, t_split;
-    size_t merge_id, dag_id;
-    t_split = T.getTrapezoid(trap_id);
-    dag_id = t_split.getDagId();
-    std::vector<size_t> dagVector;
-    cg3::Segment2d proj1, proj2, internal;
-    cg3::Point2d p1, p2;
-    proj1 =  cg3::Segment2d(cg3::Point2d(t_split.getLeftp().x(),BOUNDINGBOX),
-                               cg3::Point2d(t_split.getLeftp().x(), -BOUNDINGBOX));
-    proj2 =  cg3::Segment2d(cg3::Point2d(t_split.getRightp().x(),BOUNDINGBOX),
-                                cg3::Point2d(t_split.getRightp().x(), -BOUNDINGBOX));
-
-    cg3::checkSegmentIntersection2(s,proj1,dummy,0,p1);
-    cg3::checkSegmentIntersection2(s,proj2,dummy,0,p2);
-    internal = cg3::Segment2d(p1,p2);
-
-    size_t other_id, top_id, bottom_id;
-    size_t * old_neighbors = t_split.getNeighbors();
-
-    cg3::Point2d p1t, p1b, p2t, p2b;
-    //the four points of intersections: the intersection with top and bottom of the two projection segments
-
-    //calculate the intersectionss
-    cg3::checkSegmentIntersection2(t_split.getTop(),proj1,dummy,0,p1t);
-    cg3::checkSegmentIntersection2(t_split.getBottom(),proj1,dummy,0,p1b);
-    cg3::checkSegmentIntersection2(t_split.getTop(),proj2,dummy,0,p2t);
-    cg3::checkSegmentIntersection2(t_split.getBottom(),proj2,dummy,0,p2b);
-
-    //create the trapezoid above
-    ttop = Trapezoid(
-                t_split.getLeftp(),
-                t_split.getRightp(),
-                t_split.getTop(),
-                internal
-                );
-
-    //create the trapezoid below
-    tbottom = Trapezoid(
-                t_split.getLeftp(),
-                t_split.getRightp(),
-                internal,
-                t_split.getBottom()
-                );
-
-     if(merge_above){
-
-            ttop.setLeftp(t_merge.getLeftp());
-            ttop.setTop(cg3::Segment2d(t_merge.getTop().p1(),ttop.getTop().p2()));
-            ttop.setBottom(cg3::Segment2d(t_merge.getBottom().p1(),ttop.getBottom().p2()));
-            top_id = t_merge.getId();
-            ttop.setDagId(t_merge.getDagId());
-            T.replaceTrapezoid(top_id,ttop);
-            T.setNeighbor(top_id,TOP_LEFT,t_merge.getNeighbor(TOP_LEFT));
-            T.setNeighbor(top_id,TOP_RIGHT,t_split.getNeighbor(TOP_RIGHT));
-            T.setNeighbor(top_id,BOTTOM_LEFT,t_merge.getNeighbor(BOTTOM_LEFT));
-            T.setNeighbor(top_id,BOTTOM_RIGHT,t_split.getNeighbor(BOTTOM_RIGHT));
-            bottom_id = trap_id;
-            T.replaceTrapezoid(bottom_id,tbottom);
-            T.setNeighbors(bottom_id,t_split.getNeighbors());
+void algorithms::queryPoints(const Dag& dag, const std::vector<cg3::Point2d>& points, std::vector<size_t>& out){
+    out.resize(points.size());
+    queryPoints(dag,points,0,points.size(),out);
+}
 
+/**
+ * @brief algorithms::queryPoints
+ * This override locates only the points in the range [begin, end) of the input vector. The output vector
+ * must already contain a position for every input point, only the positions of the range are written.
+ * In this way several threads can locate disjoint ranges of the same batch.
+ * @param dag the dag to use for the query
+ * @param points the query points
+ * @param begin the position of the first point of the range
+ * @param end the position after the last point of the range
+ * @param[out] out the ids of the trapezoids containing the points, in the same order of the input
+ */
+void algorithms::queryPoints(const Dag& dag, const std::vector<cg3::Point2d>& points, size_t begin, size_t end, std::vector<size_t>& out){
+    if(begin >= end){
+        return;
+    }
 
-        }
-        else{
+    QueryArrays items(points, begin, end);
 
-            tbottom.setLeftp(t_merge.getLeftp());
-            tbottom.setTop(cg3::Segment2d(t_merge.getTop().p1(),tbottom.getTop().p2()));
-            tbottom.setBottom(cg3::Segment2d(t_merge.getBottom().p1(),tbottom.getBottom().p2()));
-            tbottom.setDagId(t_merge.getDagId());
-            bottom_id = t_merge.getId();
-            T.setNeighbor(bottom_id,TOP_LEFT,t_merge.getNeighbor(TOP_LEFT));
-            T.setNeighbor(bottom_id,TOP_RIGHT,t_split.getNeighbor(TOP_RIGHT));
-            T.setNeighbor(bottom_id,BOTTOM_LEFT,t_merge.getNeighbor(BOTTOM_LEFT));
-            T.setNeighbor(bottom_id,BOTTOM_RIGHT,t_split.getNeighbor(BOTTOM_RIGHT));
-            T.replaceTrapezoid(bottom_id,tbottom);
-            top_id = trap_id;
-            T.replaceTrapezoid(top_id,ttop);
-            T.setNeighbors(top_id,t_split.getNeighbors());
+    std::vector<QueryBatch> stack;
+    stack.push_back({0, 0, end - begin}); //all the points start from the root of the dag
 
-        }
+    while(!stack.empty()){
+        QueryBatch b = stack.back();
+        stack.pop_back();
+        const DagNode& d = dag.getElementInDVector(b.node);
+        size_t n = b.end - b.begin;
 
-    if(merge_above){
-        if(utility::isAbove(T.getTrapezoid(t_prev).getBottom(),tbottom.getTop().p1())
-            || cg3::internal::isBetween(T.getTrapezoid(t_prev).getBottom().p1(),
-                    T.getTrapezoid(t_prev).getBottom().p2(),
-                    tbottom.getTop().p1(),0)){
-            T.setNeighbor(bottom_id,TOP_LEFT,t_prev);
-        }
-        if(!utility::isAbove(tbottom.getBottom(),T.getTrapezoid(t_prev).getBottom().p2())){
-            T.setNeighbor(bottom_id,BOTTOM_LEFT,t_prev);
+        switch(d.getNodeType()){
+            case POINT:{
+                prefetch(&dag.getElementInDVector(d.getLeftC()));
+                prefetch(&dag.getElementInDVector(d.getRightC()));
+                //the points to the left of the point of the node go to the left child
+                predicates::classifyX(dag.getElementInPVector(d.getEntityId()).x(), &items.x[b.begin], n, &items.side[b.begin]);
+            }
+            break;
+            case SEGMENT:{
+                prefetch(&dag.getElementInDVector(d.getLeftC()));
+                prefetch(&dag.getElementInDVector(d.getRightC()));
+                const cg3::Segment2d& s = dag.getElementInSVector(d.getEntityId());
+                //the points above the segment of the node go to the left child
+                predicates::classifyAbove(s.p1().x(), s.p1().y(), s.p2().x(), s.p2().y(), &items.x[b.begin], &items.y[b.begin], n, &items.side[b.begin]);
+                for(size_t i = b.begin; i < b.end; i++){
+                    if(items.side[i] == SIDE_UNSURE){
+                        cg3::Point2d p(items.x[i], items.y[i]);
+                        items.side[i] = goesLeft(s,p,p) ? SIDE_LEFT : SIDE_RIGHT;
+                    }
+                }
+            }
+            break;
+            case TRAPEZOID:
+                //every point of the range is contained in the trapezoid of the leaf
+                for(size_t i = b.begin; i < b.end; i++){
+                    out[items.index[i]] = d.getEntityId();
+                }
+                continue;
+            default:
+                continue;
         }
-        if(!utility::isAbove(tbottom.getBottom(),T.getTrapezoid(t_prev).getTop().p2())){
-            T.setNeighbor(t_prev,TOP_RIGHT,bottom_id);
+
+        size_t m = items.partition(b.begin, b.end);
+        //the right range is pushed first, so that the left one is visited next
+        if(m < b.end){
+            stack.push_back({d.getRightC(), m, b.end});
         }
-        if(utility::isAbove(tbottom.getBottom(),T.getTrapezoid(t_prev).getBottom().p2())
-                || cg3::internal::isBetween(tbottom.getBottom().p1(), tbottom.getBottom().p2(),
-                                            T.getTrapezoid(t_prev).getBottom().p2(),0)){
-            T.setNeighbor(t_prev,BOTTOM_RIGHT,bottom_id);
+        if(b.begin < m){
+            stack.push_back({d.getLeftC(), b.begin, m});
         }
-
     }
-    else{
-        if(utility::isAbove(ttop.getTop(),T.getTrapezoid(t_prev).getTop().p2())
-                || cg3::internal::isBetween(ttop.getTop().p1(), ttop.getTop().p2(), T.getTrapezoid(t_prev).getTop().p2(),0)){
-            T.setNeighbor(top_id,TOP_LEFT,t_prev);
+}
+
+/**
+ * @brief algorithms::walkToPoint
+ * This method locates a point by walking through the neighbors of the trapezoids, starting from a trapezoid that
+ * is expected to be near the point. The walk follows the line from the middle of the start trapezoid to the point:
+ * it crosses the left or the right wall of a trapezoid, through the neighbor above or below the point of the wall.
+ * The walk stops when the line crosses a segment, since the neighbors only connect the trapezoids through the walls.
+ * A point on a segment or on a wall is located in one of the trapezoids that contain it.
+ * @param T the trapezoidal map
+ * @param p the query point
+ * @param start the id of the trapezoid where the walk starts
+ * @param maxSteps the largest number of walls crossed by the walk
+ * @param[out] trapezoid the id of the trapezoid containing the point, if it has been reached
+ * @return true if the walk reached the trapezoid containing the point, false otherwise
+ */
+bool algorithms::walkToPoint(const TrapezoidalMap& T, const cg3::Point2d& p, size_t start, size_t maxSteps, size_t& trapezoid){
+    if(start >= T.getTsize()){
+        return false;
+    }
+    const Trapezoid * t = &T.getTrapezoid(start);
+    double cx = (T.getLeftp(*t).x() + T.getRightp(*t).x()) / 2;
+    double cy = (utility::yAtX(T.getSegment(t->getTopId()), cx) + utility::yAtX(T.getSegment(t->getBottomId()), cx)) / 2;
+    for(size_t step = 0;; step++){
+        const cg3::Point2d& leftp = T.getLeftp(*t);
+        const cg3::Point2d& rightp = T.getRightp(*t);
+        bool right = p.x() > rightp.x();
+        if(!right && p.x() >= leftp.x()){
+            //the point is in the slab of the trapezoid, otherwise the line has crossed the top or the bottom: the
+            //segments of the map are tested with the exact predicate, as in the dag
+            if(utility::isAbove(T.getSegment(t->getTopId()), p) || utility::isBelow(T.getSegment(t->getBottomId()), p)){
+                return false;
+            }
+            trapezoid = t->getId();
+            return true;
         }
-        if(utility::isAbove(T.getTrapezoid(t_prev).getBottom(),ttop.getBottom().p1())
-                || cg3::internal::isBetween(T.getTrapezoid(t_prev).getBottom().p1(),
-                                                     T.getTrapezoid(t_prev).getBottom().p2(),
-                                                     ttop.getBottom().p1(),0)){
-            T.setNeighbor(top_id,BOTTOM_LEFT,t_prev);
+        if(step == maxSteps){
+            return false;
         }
-        if(!utility::isAbove(ttop.getTop(),T.getTrapezoid(t_prev).getTop().p2())){
-            T.setNeighbor(t_prev,TOP_RIGHT,top_id);
+        const cg3::Point2d& wall = right ? rightp : leftp;
+        double y = cy + (p.y() - cy) * (wall.x() - cx) / (p.x() - cx);
+        size_t next = y > wall.y() ? t->getNeighbor(right ? TOP_RIGHT : TOP_LEFT)
+                                   : t->getNeighbor(right ? BOTTOM_RIGHT : BOTTOM_LEFT);
+        if(next == SIZE_MAX){
+            return false;
         }
+        t = &T.getTrapezoid(next);
+    }
+}
 
-        if(utility::isAbove(ttop.getBottom(),T.getTrapezoid(t_prev).getBottom().p2())
-                            || cg3::internal::isBetween(ttop.getBottom().p1(), ttop.getBottom().p2(), T.getTrapezoid(t_prev).getBottom().p2(),0)){
-            T.setNeighbor(t_prev,BOTTOM_RIGHT,top_id);
-        }
+/**
+ * @brief algorithms::queryTrapezoid
+ * This override locates a point by walking from a hint trapezoid, as the trapezoid of the previous query of a
+ * coherent stream of points. The point is located in the dag if the walk fails, so the result is always correct.
+ * @param T the trapezoidal map
+ * @param dag the dag of the map
+ * @param p the query point
+ * @param hint the id of the trapezoid where the walk starts, SIZE_MAX to query the dag
+ * @param maxSteps the largest number of walls crossed by the walk
+ * @return the id of the trapezoid in the trapezoidal map that contains the point
+ */
+size_t algorithms::queryTrapezoid(const TrapezoidalMap& T, const Dag& dag, const cg3::Point2d& p, size_t hint, size_t maxSteps){
+    size_t trapezoid;
+    if(hint != SIZE_MAX && walkToPoint(T, p, hint, maxSteps, trapezoid)){
+        return trapezoid;
     }
+    return queryTrapezoid(dag, p);
+}
 
-    dagVector = updateDag(T,D,s,dag_id,top_id,bottom_id);
-    T.setDagId(top_id,dagVector[0]);
-    T.setDagId(bottom_id,dagVector[1]);
-
-    if(merge_above && utility::isAbove(s,t_split.getRightp())){
-        t_merge = T.getTrapezoid(bottom_id);
-        merge_above = false;
-        t_prev = top_id;
-        first = true;
-    }
-    else if(!merge_above && !utility::isAbove(s,t_split.getRightp()))
-    {
-        t_merge = T.getTrapezoid(top_id);
-        merge_above = true;
-        t_prev = bottom_id;
-        first = true;
-    }
-    else{
-        if(merge_above){
-            t_merge = T.getTrapezoid(top_id);
-            bottom_id = trap_id;
-            t_prev = bottom_id;
-            first = false;
-        }
-        else{
-            t_merge = T.getTrapezoid(bottom_id);
-            top_id = trap_id;
-            t_prev = top_id;
-            first = false;
-        }
-
-        if(merge_above){
-            if(!utility::pointEqual(t_split.getBottom().p2(), t_split.getRightp())){
-                T.setNeighbor(bottom_id,BOTTOM_RIGHT,old_neighbors[BOTTOM_RIGHT]);
-                T.updateOldNeighbors(true,old_neighbors[BOTTOM_RIGHT], trap_id, bottom_id);
-            }
-        }
-        else{
-            if(!utility::pointEqual(t_split.getTop().p2(), t_split.getRightp())){
-                T.setNeighbor(top_id,TOP_RIGHT,old_neighbors[TOP_RIGHT]);
-                T.updateOldNeighbors(true,old_neighbors[TOP_RIGHT], trap_id, bottom_id);
-            }
-        }
+/**
+ * @brief algorithms::queryPointsWalking
+ * This method locates a stream of points in their order, every point is located by walking from the trapezoid
+ * of the previous one. It is faster than the batch query when the consecutive points are near, as in a track.
+ * @param T the trapezoidal map
+ * @param dag the dag of the map
+ * @param points the query points
+ * @param[out] out the ids of the trapezoids containing the points, in the same order of the input
+ * @param maxSteps the largest number of walls crossed by every walk
+ */
+void algorithms::queryPointsWalking(const TrapezoidalMap& T, const Dag& dag, const std::vector<cg3::Point2d>& points,
+                                    std::vector<size_t>& out, size_t maxSteps){
+    out.resize(points.size());
+    size_t hint = SIZE_MAX;
+    for(size_t i = 0; i < points.size(); i++){
+        out[i] = queryTrapezoid(T, dag, points[i], hint, maxSteps);
+        hint = out[i];
     }
 }
 
-
 /**
- * @brief algorithms::splitin3
- * This method performs a split in 3. The intersecting face t_split is removed from the trapezoidal map and the 3 new trapezoid
- * generated are inserted. The boolean parameter left determines if one of the trapezoid is to the left (true) or to the right (false).
- * Then the updateDag() method is called in order to reflect the changes in the trapezoidal map in the DAG as well.
- * @param T The trapezoidal map containing the trapezoids
- * @param s The segment that caused the split in 3
- * @param D The dag to use a search structure
- * @param t_split the trapezoid to delete
- * @param left This parameter determines if the split occurs in the left or in the right endpoint of the segment, for which
- * the split in 3 is different
- * @param merge_above a boolean value that determines if the merge has to be done with the trapezoid above or below the segment
- * @param t_merge a reference to the previous trapezoid that has to be merged
- * @param t_prev the id of the other trapezoid generated in the previous split. This is necessary in order to update the neighbors
- * @param next the id of the next Trapezoid that is intersected by the segment. This is necessary in order to avoid to update
- * his neighbors because new trapezoids will be generated in the next split
+ * @brief algorithms::queryTrapezoid
+ * This override locates a point in the packed dag
+ * @param dag the packed dag to use for the query
+ * @param p the query point
+ * @return the id of the trapezoid in the trapezoidal map that contains the point
  */
-void algorithms::splitin3(TrapezoidalMap& T, const cg3::Segment2d& s, Dag& D, size_t trap_id, bool left, bool& merge_above, Trapezoid & t_merge, size_t & t_prev, size_t next, bool& first){
-
-    coincidence coincidence;
-    bool coincident_above = false;
-    bool side_coincident = false;
-    char dummy, d1t, d1b, d2t, d2b;
-    Trapezoid t_split, tother, ttop, tbottom;
-    t_split = T.getTrapezoid(trap_id);
-    size_t dag_id = t_split.getDagId();
-    cg3::Segment2d proj1, proj2;
-    cg3::Point2d cross;
-    std::vector<size_t> dagVector;
-    //these 2 segments represent the projection on the x axis of the 2 endpoints of the segment
-    if(left){
-    proj1 = cg3::Segment2d(cg3::Point2d(s.p1().x(),BOUNDINGBOX), cg3::Point2d(s.p1().x(), -BOUNDINGBOX));
-    proj2 = cg3::Segment2d(cg3::Point2d(t_split.getRightp().x(),BOUNDINGBOX),
-                           cg3::Point2d(t_split.getRightp().x(), -BOUNDINGBOX));
-    cg3::checkSegmentIntersection2(s,proj2,dummy,0,cross);
-    }
-    else{
-        proj1 = cg3::Segment2d(cg3::Point2d(t_split.getLeftp().x(),BOUNDINGBOX),
-                               cg3::Point2d(t_split.getLeftp().x(), -BOUNDINGBOX));
-        proj2 = cg3::Segment2d(cg3::Point2d(s.p2().x(),BOUNDINGBOX), cg3::Point2d(s.p2().x(), -BOUNDINGBOX));
-        cg3::checkSegmentIntersection2(s,proj1,dummy,0,cross);
-    }
-
-    size_t other_id, top_id, bottom_id;
-    size_t * old_neighbors = t_split.getNeighbors();
-
-    cg3::Point2d p1t, p1b, p2t, p2b;
-    //the four points of intersections: the intersection with top and bottom of the two projection segments
-
-    //calculate the intersections
-    cg3::checkSegmentIntersection2(t_split.getTop(),proj1,d1t,0,p1t);
-    cg3::checkSegmentIntersection2(t_split.getBottom(),proj1,d1b,0,p1b);
-    cg3::checkSegmentIntersection2(t_split.getTop(),proj2,d2t,0,p2t);
-    cg3::checkSegmentIntersection2(t_split.getBottom(),proj2,d2b,0,p2b);
-
-    if(d1t == '0'){
-        p1t = t_split.getTop().p1();
-    }
-
-    if(d1b == '0'){
-        p1b = t_split.getBottom().p1();
-    }
-
-    if(d2t == '0'){
-        p2t = t_split.getTop().p2();
-    }
-
-    if(d2b == '0'){
-        p2b = t_split.getBottom().p2();
-    }
-
-
-    //create the trapezoid above
-    if(left){
-        ttop = Trapezoid(
-                    s.p1(),
-                    t_split.getRightp(),
-                    cg3::Segment2d(p1t,t_split.getTop().p2()),
-                    cg3::Segment2d(s.p1(),cross)
-                    );
-
-
-    //create the trapezoid below
-        tbottom = Trapezoid(
-                    s.p1(),
-                    t_split.getRightp(),
-                    cg3::Segment2d(s.p1(),cross),
-                    cg3::Segment2d(p1b,t_split.getBottom().p2())
-                    );
-
-           tother = Trapezoid(
-                        t_split.getLeftp(),
-                        s.p1(),
-                        cg3::Segment2d(t_split.getTop().p1(),p1t),
-                        cg3::Segment2d(t_split.getBottom().p1(),p1b)
-                        );
-
-
-        if(utility::pointEqual(ttop.getTop().p1(),ttop.getBottom().p1())){
-            coincidence = LEFT;
-            coincident_above = true;
-        }
-        else if(utility::pointEqual(tbottom.getTop().p1(),tbottom.getBottom().p1())){
-            coincidence = LEFT;
-            coincident_above = false;
-        }
-        else{
-            coincidence = NONE;
-        }
-
-        if(utility::pointEqual(tother.getTop().p1(),tother.getBottom().p1()) || utility::pointEqual(tother.getTop().p2(),tother.getBottom().p2())){
-            coincidence = LEFT;
-            side_coincident = true;
-        }
-    }
-
-    else{
-        ttop = Trapezoid(
-                    t_split.getLeftp(),
-                    s.p2(),
-                    cg3::Segment2d(t_split.getTop().p1(),p2t),
-                    cg3::Segment2d(cross,s.p2()));
-        tbottom = Trapezoid(
-                    t_split.getLeftp(),
-                    s.p2(),
-                    cg3::Segment2d(cross,s.p2()),
-                    cg3::Segment2d(t_split.getBottom().p1(),p2b)
-                    );
-
-        tother = Trapezoid(
-                    s.p2(),
-                    t_split.getRightp(),
-                    cg3::Segment2d(p2t,t_split.getTop().p2()),
-                    cg3::Segment2d(p2b,t_split.getBottom().p2())
-                    );
-
-        if(utility::pointEqual(ttop.getTop().p2(),ttop.getBottom().p2())){
-            coincidence = RIGHT;
-            coincident_above = true;
-        }
-        else if(utility::pointEqual(tbottom.getTop().p2(),tbottom.getBottom().p2())){
-            coincidence = RIGHT;
-            coincident_above = false;
-        }
-        else{
-            coincidence = NONE;
-        }
-
-        if(utility::pointEqual(tother.getTop().p1(),tother.getTop().p2()) && utility::pointEqual(tother.getBottom().p1(),tother.getBottom().p2())){
-            coincidence = RIGHT;
-            side_coincident = true;
-        }
-
-    }
-
-    //create the other trapezoid of the split (left or right depending by the endpoint)
-
-    if(merge_above){
-        ttop.setLeftp(t_merge.getLeftp());
-        ttop.setTop(cg3::Segment2d(t_merge.getTop().p1(),ttop.getTop().p2()));
-        ttop.setBottom(cg3::Segment2d(t_merge.getBottom().p1(),ttop.getBottom().p2()));
-        ttop.setNeighbors(t_merge.getNeighbors());
-        ttop.setDagId(t_merge.getDagId());
-        top_id = t_merge.getId();
-        T.replaceTrapezoid(top_id,ttop);
-
-    }
-    else{
-        if(!left){
-            tbottom.setLeftp(t_merge.getLeftp());
-            tbottom.setTop(cg3::Segment2d(t_merge.getTop().p1(),tbottom.getTop().p2()));
-            tbottom.setBottom(cg3::Segment2d(t_merge.getBottom().p1(),tbottom.getBottom().p2()));
-            tbottom.setNeighbors(t_merge.getNeighbors());
-            tbottom.setDagId(t_merge.getDagId());
-            bottom_id = t_merge.getId();
-            T.replaceTrapezoid(bottom_id,tbottom);
-        }
-
-   }
-
-    if(left){
-        ttop.setNeighbors(t_split.getNeighbors());
-        tbottom.setNeighbors(t_split.getNeighbors());
-        if(coincidence == NONE){
-            other_id = trap_id;
-            tother.setNeighbors(t_split.getNeighbors());
-            T.replaceTrapezoid(trap_id,tother);
-            top_id = T.insertTrapezoid(ttop);
-        }
-        else{
-            top_id = trap_id;
-            T.replaceTrapezoid(trap_id,ttop);
-        }
-
-        bottom_id = T.insertTrapezoid(tbottom);
-
-    }
-    else{
-
-        if(merge_above){
-            bottom_id = trap_id;
-            tbottom.setNeighbors(t_split.getNeighbors());
-
-            T.replaceTrapezoid(trap_id,tbottom);
-            if(coincidence == NONE){
-                other_id = T.insertTrapezoid(tother);
-            }
-        }
-        else{
-            top_id = trap_id;
-            ttop.setNeighbors(t_split.getNeighbors());
-            T.replaceTrapezoid(trap_id,ttop);
-            if(coincidence == NONE){
-                other_id = T.insertTrapezoid(tother);
-            }
-        }
-    }
-    switch(coincidence){
-    case NONE:
-        dagVector = updateDag(T,D,s,dag_id,top_id,bottom_id,other_id,left);
-        if(left){
-            T.setDagId(other_id,dagVector[2]);
-            T.setDagId(top_id,dagVector[0]);
-            T.setDagId(bottom_id,dagVector[1]);
-        }
-        else{
-            T.setDagId(top_id,dagVector[0]);
-            T.setDagId(bottom_id,dagVector[1]);
-            T.setDagId(other_id,dagVector[2]);
-        }
-        break;
-    case LEFT:
-    case RIGHT:
-        dagVector = updateDag(T,D,s,coincidence,dag_id,top_id,bottom_id);
-        T.setDagId(top_id,dagVector[0]);
-        T.setDagId(bottom_id,dagVector[1]);
-        break;
-    default:
-        break;
-    }
-
-
-    if(left){
-        //set neighbors of left trapezoid
-        if(coincidence == NONE){
-        T.setNeighbor(other_id,TOP_LEFT,old_neighbors[TOP_LEFT]);
-        T.setNeighbor(other_id, TOP_RIGHT, top_id);      //the top right neighbor is the trapezoid above the segment
-        T.setNeighbor(other_id,BOTTOM_LEFT,old_neighbors[BOTTOM_LEFT]);
-        T.setNeighbor(other_id,BOTTOM_RIGHT,bottom_id);  //the bottom right neighbor is the trapezoid below the segment
-        //top-left and bottom-left are the same of the old trapezoid
-
-        //set neighbors of top trapezoid
-        T.setNeighbor(top_id,TOP_LEFT,other_id);         //the top left neighbor is the trapezoid to the left of the segment
-        //T.setNeighbor(top_id,TOP_RIGHT,old_neighbors[TOP_RIGHT]);       //the top right neighbor is the trapezoid to the right of the segment
-        T.setNeighbor(top_id,BOTTOM_LEFT,other_id);      //the bottom left neighbor is the trapezoid to the left of the segment
-        //T.setNeighbor(top_id,BOTTOM_RIGHT,old_neighbors[BOTTOM_RIGHT]);    //the bottom right neighbor is the trapezoid to the right of the segment
-
-        //set neighbors of bottom trapezoid
-        T.setNeighbor(bottom_id,TOP_LEFT,other_id);      //the top left neighbor is the trapezoid to the left of the segment
-        //T.setNeighbor(bottom_id,TOP_RIGHT,old_neighbors[TOP_RIGHT]);    //the top right neighbor is the trapezoid to the right of the segment
-        T.setNeighbor(bottom_id,BOTTOM_LEFT,other_id);   //the bottom left neighbor is the trapezoid to the left of the segment
-        //T.setNeighbor(bottom_id,BOTTOM_RIGHT,old_neighbors[BOTTOM_RIGHT]); //the bottom right neighbor is the trapezoid to the right of the segment
-        }
-        else{
-            if(coincident_above){
-                T.setNeighbor(top_id,TOP_LEFT,SIZE_MAX);
-                T.setNeighbor(top_id,BOTTOM_LEFT,SIZE_MAX);
-            }
-            else if(side_coincident && coincidence == LEFT){
-                T.setNeighbor(top_id,TOP_LEFT,old_neighbors[TOP_LEFT]);
-                T.setNeighbor(top_id,BOTTOM_LEFT,SIZE_MAX);
-                T.setNeighbor(bottom_id,TOP_LEFT,SIZE_MAX);
-                T.setNeighbor(bottom_id,BOTTOM_LEFT,old_neighbors[BOTTOM_LEFT]);
-            }
-            else{
-                T.setNeighbor(bottom_id,TOP_LEFT,SIZE_MAX);
-                T.setNeighbor(bottom_id,BOTTOM_LEFT,SIZE_MAX);
-            }
-
-        }
-
-    }
-    else{
-        if(coincidence == NONE){
-        //set neighbors of top trapezoid
-        //T.setNeighbor(top_id,TOP_LEFT,old_neighbors[TOP_LEFT]);         //the top left neighbor is the trapezoid to the left of the segment
-        T.setNeighbor(top_id,TOP_RIGHT,other_id);       //the top right neighbor is the trapezoid to the right of the segment
-        //T.setNeighbor(top_id,BOTTOM_LEFT,old_neighbors[BOTTOM_LEFT]);      //the bottom left neighbor is the trapezoid to the left of the segment
-        T.setNeighbor(top_id,BOTTOM_RIGHT,other_id);    //the bottom right neighbor is the trapezoid to the right of the segment
-
-        //set neighbors of right trapezoid;
-        T.setNeighbor(other_id, TOP_LEFT, top_id);      //the top right neighbor is the trapezoid above the segment
-        T.setNeighbor(other_id,TOP_RIGHT,old_neighbors[TOP_RIGHT]);
-        T.setNeighbor(other_id,BOTTOM_LEFT,bottom_id);  //the bottom right neighbor is the trapezoid below the segment
-        T.setNeighbor(other_id,BOTTOM_RIGHT,old_neighbors[BOTTOM_RIGHT]);
-        //top-right and bottom-right are the same of the old trapezoid
-
-        //set neighbors of bottom trapezoid
-        //T.setNeighbor(bottom_id,TOP_LEFT,old_neighbors[TOP_LEFT]);      //the top left neighbor is the trapezoid to the left of the segment
-        T.setNeighbor(bottom_id,TOP_RIGHT,other_id);    //the top right neighbor is the trapezoid to the right of the segment
-        //T.setNeighbor(bottom_id,BOTTOM_LEFT,old_neighbors[BOTTOM_LEFT]);   //the bottom left neighbor is the trapezoid to the left of the segment
-        T.setNeighbor(bottom_id,BOTTOM_RIGHT,other_id); //the bottom right neighbor is the trapezoid to the right of the segment
-        }
-        else{
-            if(coincident_above){
-                T.setNeighbor(top_id,TOP_RIGHT,SIZE_MAX);
-                T.setNeighbor(top_id,BOTTOM_RIGHT,SIZE_MAX);
-            }
-            else if(side_coincident && coincidence == RIGHT){
-                T.setNeighbor(top_id,TOP_RIGHT,old_neighbors[TOP_RIGHT]);
-                T.setNeighbor(top_id,BOTTOM_RIGHT,SIZE_MAX);
-                T.setNeighbor(bottom_id,TOP_RIGHT,SIZE_MAX);
-                T.setNeighbor(bottom_id,BOTTOM_RIGHT,old_neighbors[BOTTOM_RIGHT]);
-            }
-            else{
-                T.setNeighbor(bottom_id,TOP_RIGHT,SIZE_MAX);
-                T.setNeighbor(bottom_id,BOTTOM_RIGHT,SIZE_MAX);
-            }
-        }
-
-        if(merge_above){
-            if(utility::isAbove(T.getTrapezoid(t_prev).getBottom(),tbottom.getTop().p1())){
-                T.setNeighbor(bottom_id,TOP_LEFT,t_prev);
-            }
-            if(!utility::isAbove(tbottom.getBottom(),T.getTrapezoid(t_prev).getBottom().p2())){
-                T.setNeighbor(bottom_id,BOTTOM_LEFT,t_prev);
-            }
-            if(!utility::isAbove(tbottom.getBottom(),T.getTrapezoid(t_prev).getTop().p2())){
-                T.setNeighbor(t_prev,TOP_RIGHT,bottom_id);
-            }
-            if(utility::isAbove(tbottom.getBottom(),T.getTrapezoid(t_prev).getBottom().p2())){
-                T.setNeighbor(t_prev,BOTTOM_RIGHT,bottom_id);
-            }
-
-        }
-        else{
-            if(utility::isAbove(ttop.getTop(),T.getTrapezoid(t_prev).getTop().p2())){
-                T.setNeighbor(top_id,TOP_LEFT,t_prev);
-            }
-            if(utility::isAbove(T.getTrapezoid(t_prev).getBottom(),ttop.getBottom().p1()) || T.getTrapezoid(t_prev).getBottom().p2() == ttop.getBottom().p1()){
-                T.setNeighbor(top_id,BOTTOM_LEFT,t_prev);
-            }
-            if(!utility::isAbove(ttop.getTop(),T.getTrapezoid(t_prev).getTop().p2()) ){
-                T.setNeighbor(t_prev,TOP_RIGHT,top_id);
-            }
-            if(utility::isAbove(ttop.getBottom(),T.getTrapezoid(t_prev).getBottom().p2())){
-                T.setNeighbor(t_prev,BOTTOM_RIGHT,top_id);
-            }
-        }
-    }
-
-    if(left){
-        if(coincidence == NONE){
-            if(merge_above){
-                if(!utility::pointEqual(t_split.getBottom().p2(),t_split.getRightp())){
-                    T.updateOldNeighbors(left,old_neighbors[BOTTOM_RIGHT],trap_id,bottom_id);
-                }
-            }
-            else{
-                if(!utility::pointEqual(t_split.getTop().p2(),t_split.getRightp())){
-                    T.updateOldNeighbors(left,old_neighbors[TOP_RIGHT],trap_id,top_id);
-                }
-            }
-        }
-        else{
-            if(utility::pointEqual(ttop.getBottom().p1(),t_split.getTop().p1())){
-                if(merge_above){
-                    if(!utility::pointEqual(t_split.getBottom().p2(),t_split.getRightp())){
-                        T.setNeighbor(bottom_id,BOTTOM_RIGHT,old_neighbors[BOTTOM_RIGHT]);
-                        T.updateOldNeighbors(true,old_neighbors[BOTTOM_RIGHT],trap_id,bottom_id);
-                    }
-                    T.setNeighbor(bottom_id,TOP_LEFT,old_neighbors[TOP_LEFT]);
-                    T.updateOldNeighbors(false,old_neighbors[TOP_LEFT],trap_id,bottom_id);
-                }
-                else{
-                    if(!utility::pointEqual(t_split.getTop().p2(),t_split.getRightp())){
-                        T.setNeighbor(top_id,TOP_RIGHT,old_neighbors[TOP_RIGHT]);
-                        T.updateOldNeighbors(true,old_neighbors[TOP_RIGHT],trap_id,top_id);
-                    }
-                    T.setNeighbor(bottom_id,TOP_LEFT,old_neighbors[BOTTOM_LEFT]);
-                    T.setNeighbor(bottom_id,BOTTOM_LEFT,old_neighbors[BOTTOM_LEFT]);
-                    T.updateOldNeighbors(false,old_neighbors[BOTTOM_LEFT],trap_id,bottom_id);
-                }
-            }
-            else if(utility::pointEqual(tbottom.getTop().p1(), t_split.getBottom().p1())){
-                if(merge_above){
-                    if(!utility::pointEqual(t_split.getBottom().p2(),t_split.getRightp())){
-                        T.setNeighbor(bottom_id,BOTTOM_RIGHT,old_neighbors[BOTTOM_RIGHT]);
-                        T.updateOldNeighbors(true,old_neighbors[BOTTOM_RIGHT],trap_id,bottom_id);
-                    }
-                    T.updateOldNeighbors(false,old_neighbors[TOP_LEFT],trap_id,top_id);
-                }
-                else{
-                    if(!utility::pointEqual(t_split.getTop().p2(),t_split.getRightp())){
-                        T.setNeighbor(top_id,TOP_RIGHT,old_neighbors[TOP_RIGHT]);
-                        T.updateOldNeighbors(true,old_neighbors[TOP_RIGHT],trap_id,top_id);
-                    }
-                    T.setNeighbor(top_id,BOTTOM_LEFT,old_neighbors[TOP_LEFT]);
-                    T.updateOldNeighbors(false,old_neighbors[BOTTOM_LEFT],trap_id,bottom_id);
-                }
-            }
-            else{
-                if(merge_above){
-                    if(!utility::pointEqual(t_split.getBottom().p2(),t_split.getRightp())){
-                        T.updateOldNeighbors(true,old_neighbors[BOTTOM_RIGHT],trap_id,bottom_id);
-                    }
-                    T.updateOldNeighbors(false,old_neighbors[TOP_LEFT],trap_id,top_id);
-                }
-                else{
-                    if(!utility::pointEqual(t_split.getTop().p2(),t_split.getRightp())){
-                        T.updateOldNeighbors(true,old_neighbors[TOP_RIGHT],trap_id,top_id);
-                    }
-                    T.updateOldNeighbors(false,old_neighbors[BOTTOM_LEFT],trap_id,bottom_id);
-                }
-            }
-
-        }
-    }
-    else{
-        if(coincidence == NONE){
-            if(merge_above){
-                if(!utility::pointEqual(t_split.getBottom().p1(),t_split.getRightp())){
-                    T.updateOldNeighbors(false,old_neighbors[BOTTOM_LEFT],trap_id,bottom_id);
-                }
-            }
-            else{
-                if(!utility::pointEqual(t_split.getTop().p1(),t_split.getRightp())){
-                    T.updateOldNeighbors(false,old_neighbors[TOP_LEFT],trap_id,top_id);
-                }
-            }
-            T.updateOldNeighbors(true,old_neighbors[TOP_RIGHT],trap_id,other_id);
-            T.updateOldNeighbors(true,old_neighbors[BOTTOM_RIGHT],trap_id,other_id);
-        }
-        else{
-            if(merge_above){
-                if(!utility::pointEqual(t_split.getBottom().p1(),T.getTrapezoid(t_prev).getRightp())){
-                    T.updateOldNeighbors(false,old_neighbors[BOTTOM_LEFT],trap_id,bottom_id);
-                }
-            }
-            else{
-                if(!utility::pointEqual(t_split.getTop().p1(),T.getTrapezoid(t_prev).getRightp())){
-                    T.updateOldNeighbors(false,old_neighbors[TOP_LEFT],trap_id,top_id);
-                }
-            }
-
-            if(utility::pointEqual(ttop.getTop().p2(),ttop.getBottom().p2())){
-                T.updateOldNeighbors(true,old_neighbors[TOP_RIGHT],trap_id,bottom_id);
-                T.updateOldNeighbors(true,old_neighbors[BOTTOM_RIGHT],trap_id,bottom_id);
-            }
-            else if(utility::pointEqual(tbottom.getTop().p2(),tbottom.getBottom().p2())){
-                T.updateOldNeighbors(true,old_neighbors[TOP_RIGHT],trap_id,top_id);
-                T.updateOldNeighbors(true,old_neighbors[BOTTOM_RIGHT],trap_id,top_id);
-            }
-            else{
-                T.updateOldNeighbors(true,old_neighbors[TOP_RIGHT],trap_id,top_id);
-                T.updateOldNeighbors(true,old_neighbors[BOTTOM_RIGHT],trap_id,bottom_id);
-            }
-        }
-    }
-
-
-    if(left){
-        if(utility::isAbove(s,t_split.getRightp())){
-            t_merge = T.getTrapezoid(bottom_id);
-            merge_above = false;
-            t_prev = top_id;
-            first = false;
-        }else{
-            t_merge = T.getTrapezoid(top_id);
-            merge_above = true;
-            t_prev = bottom_id;
-            first = false;
-        }
-    }
+size_t algorithms::queryTrapezoid(const PackedDag& dag, const cg3::Point2d& p){
+    return queryPacked(dag.getNodes(),dag.getSegments(),p);
 }
 
 /**
- * @brief algorithms::splitin4
- * This method performs a split in 4. The intersecting face is removed from the trapezoidal map and the
- * 4 new trapezoid generated are inserted. Then, the updateDag() method is called in order to
- * reflect the changes in the trapezoidal map in the DAG as well.
- * @param T a reference to the TrapezoidalMap
- * @param s a reference to the segment that caused the split in 4
- * @param D a refernece to the Dag
- * @param trap_id the id of the trapezoid intersected by the segment
+ * @brief algorithms::queryPoints
+ * This override locates a batch of points in the packed dag, as the batch query on the Dag does
+ * @param dag the packed dag to use for the query
+ * @param points the query points
+ * @param[out] out the ids of the trapezoids containing the points, in the same order of the input
  */
-void algorithms::splitin4(TrapezoidalMap& T, const cg3::Segment2d& s, Dag& D, size_t trap_id){
-    coincidence c = NONE;
-    bool coincident_above = false;
-    bool side_coincident = false;
-    char d1t, d1b, d2t, d2b;
-    bool topLeftDegen, topRightDegen, bottomLeftDegen, bottomRightDegen;
-    Trapezoid t_split = T.getTrapezoid(trap_id);
-    size_t dag_id = t_split.getDagId();
-    std::vector<size_t> dagVector;
-
-
-    //these 2 segments represent the projection on the x axis of the 2 endpoints of the segment
-    cg3::Segment2d proj1 = cg3::Segment2d(cg3::Point2d(s.p1().x(),BOUNDINGBOX),
-                                          cg3::Point2d(s.p1().x(), -BOUNDINGBOX));
-    cg3::Segment2d proj2 = cg3::Segment2d(cg3::Point2d(s.p2().x(),BOUNDINGBOX),
-                                          cg3::Point2d(s.p2().x(), -BOUNDINGBOX));
-
-    size_t left_id, right_id, top_id, bottom_id; //the id of the 4 trapezoids
-    size_t * old_neighbors = t_split.getNeighbors();
-
-    cg3::Point2d p1t, p1b, p2t, p2b;
-    //the four points of intersections: the intersection with top and bottom of the two projection segments
-
-    //calculate the intersections
-    cg3::checkSegmentIntersection2(t_split.getTop(),proj1,d1t,0,p1t);
-    cg3::checkSegmentIntersection2(t_split.getBottom(),proj1,d1b,0,p1b);
-    cg3::checkSegmentIntersection2(t_split.getTop(),proj2,d2t,0,p2t);
-    cg3::checkSegmentIntersection2(t_split.getBottom(),proj2,d2b,0,p2b);
-
-    if(d1t == '0'){
-        p1t = t_split.getTop().p1();
-    }
-
-    if(d1b == '0'){
-        p1b = t_split.getBottom().p1();
-    }
-
-    if(d2t == '0'){
-        p2t = t_split.getTop().p2();
-    }
-
-    if(d2b == '0'){
-        p2b = t_split.getBottom().p2();
-    }
-
-    //create the left trapezoid
-    Trapezoid tleft = Trapezoid(
-                t_split.getLeftp(),
-                s.p1(),
-                cg3::Segment2d(t_split.getTop().p1(),p1t),
-                cg3::Segment2d(t_split.getBottom().p1(),p1b)
-                );
-
-    //create the trapezoid above
-    Trapezoid ttop = Trapezoid(
-                s.p1(),
-                s.p2(),
-                cg3::Segment2d(p1t,p2t),
-                s
-                );
-
-    //create the trapezoid below
-    Trapezoid tbottom = Trapezoid(
-                s.p1(),
-                s.p2(),
-                s,
-                cg3::Segment2d(p1b,p2b)
-                );
-
-    //create the right trapezoid
-    Trapezoid tright = Trapezoid(
-                s.p2(),
-                t_split.getRightp(),
-                cg3::Segment2d(p2t,t_split.getTop().p2()),
-                cg3::Segment2d(p2b,t_split.getBottom().p2())
-                );
-
-    if(utility::pointEqual(ttop.getTop().p1(),ttop.getBottom().p1())){
-        c = LEFT;
-        coincident_above = true;
-    }
-    else if(utility::pointEqual(tbottom.getTop().p1(),tbottom.getBottom().p1())){
-        c = LEFT;
-        coincident_above = false;
-    }
-
-
-    if(utility::pointEqual(t_split.getTop().p1(),p1t)){
-        c = LEFT;
-        coincident_above = true;
-        side_coincident = true;
-    }
-
-    if(utility::pointEqual(t_split.getBottom().p1(),p1b)){
-        c = LEFT;
-        coincident_above = false;
-        side_coincident = true;
-    }
-
-    if(utility::pointEqual(p2t,t_split.getTop().p2())){
-        c = RIGHT;
-        coincident_above = true;
-        side_coincident = true;
-    }
+void algorithms::queryPoints(const PackedDag& dag, const std::vector<cg3::Point2d>& points, std::vector<size_t>& out){
+    out.resize(points.size());
+    queryPoints(dag,points,0,points.size(),out);
+}
 
-    if(utility::pointEqual(p2b,t_split.getBottom().p2())){
-        c = RIGHT;
-        coincident_above = false;
-        side_coincident = true;
-    }
+/**
+ * @brief algorithms::queryPoints
+ * This override locates the points in the range [begin, end) of the input vector in the packed dag.
+ * The output vector must already contain a position for every input point.
+ * @param dag the packed dag to use for the query
+ * @param points the query points
+ * @param begin the position of the first point of the range
+ * @param end the position after the last point of the range
+ * @param[out] out the ids of the trapezoids containing the points, in the same order of the input
+ */
+void algorithms::queryPoints(const PackedDag& dag, const std::vector<cg3::Point2d>& points, size_t begin, size_t end, std::vector<size_t>& out){
+    queryPackedPoints(dag.getNodes(),dag.getSegments(),points,begin,end,out);
+}
 
-    if(utility::pointEqual(ttop.getTop().p2(),ttop.getBottom().p2())){
-        if(c != LEFT){
-            c = RIGHT;
-        }
-        else{
-            c = BOTH;
-        }
-        coincident_above = true;
-    }
-    else if(utility::pointEqual(tbottom.getTop().p2(),tbottom.getBottom().p2())){
-        if(c != LEFT){
-            c = RIGHT;
-        }
-        else{
-            c = BOTH;
-        }
-        coincident_above = false;
-    }
+/**
+ * @brief algorithms::queryTrapezoid
+ * This override locates a point in the packed dag of a map file
+ * @param map the map file to use for the query
+ * @param p the query point
+ * @return the id of the trapezoid in the map file that contains the point
+ */
+size_t algorithms::queryTrapezoid(const MappedTrapezoidalMap& map, const cg3::Point2d& p){
+    return queryPacked(map.getNodes(),map.getDagSegments(),p);
+}
 
-    if(c != LEFT){
-        left_id = trap_id;
-        T.replaceTrapezoid(trap_id,tleft);//replace the old trapezoid in the trapezoidal map with tleft
-        top_id = T.insertTrapezoid(ttop);
-    }
-    else{
-        top_id = trap_id;
-        T.replaceTrapezoid(trap_id,ttop);
-    }
+/**
+ * @brief algorithms::queryPoints
+ * This override locates a batch of points in the packed dag of a map file
+ * @param map the map file to use for the query
+ * @param points the query points
+ * @param[out] out the ids of the trapezoids containing the points, in the same order of the input
+ */
+void algorithms::queryPoints(const MappedTrapezoidalMap& map, const std::vector<cg3::Point2d>& points, std::vector<size_t>& out){
+    out.resize(points.size());
+    queryPoints(map,points,0,points.size(),out);
+}
 
-    //insert the other trapezoids in the trapezoidal map
-    bottom_id = T.insertTrapezoid(tbottom);
+/**
+ * @brief algorithms::queryPoints
+ * This override locates the points in the range [begin, end) of the input vector in the packed dag of a map file.
+ * The output vector must already contain a position for every input point.
+ * @param map the map file to use for the query
+ * @param points the query points
+ * @param begin the position of the first point of the range
+ * @param end the position after the last point of the range
+ * @param[out] out the ids of the trapezoids containing the points, in the same order of the input
+ */
+void algorithms::queryPoints(const MappedTrapezoidalMap& map, const std::vector<cg3::Point2d>& points, size_t begin, size_t end, std::vector<size_t>& out){
+    queryPackedPoints(map.getNodes(),map.getDagSegments(),points,begin,end,out);
+}
 
-    if(c != RIGHT && c != BOTH){
-        right_id = T.insertTrapezoid(tright);
-    }
+/**
+ * @brief algorithms::shootUp
+ * This method shoots a vertical ray up from a point and returns the first segment it hits, which is the top of
+ * the trapezoid containing the point. It costs one point location.
+ * @param T the trapezoidal map
+ * @param dag the dag of the map
+ * @param p the query point
+ * @return the id of the segment above the point, NO_SEGMENT if the ray reaches the bounding box
+ */
+size_t algorithms::shootUp(const TrapezoidalMap& T, const Dag& dag, const cg3::Point2d& p){
+    return datasetSegment(T.getTrapezoid(queryTrapezoid(dag, p)).getTopId());
+}
 
-    if(c != LEFT && c != BOTH){
-    //set neighbors of left trapezoid;
-        T.setNeighbor(left_id,TOP_LEFT,old_neighbors[TOP_LEFT]);
-        T.setNeighbor(left_id, TOP_RIGHT, top_id);      //the top right neighbor is the trapezoid above the segment
-        T.setNeighbor(left_id,BOTTOM_LEFT,old_neighbors[BOTTOM_LEFT]);
-        T.setNeighbor(left_id,BOTTOM_RIGHT,bottom_id);  //the bottom right neighbor is the trapezoid below the segment
-    //top-left and bottom-left are the same of the old trapezoid
-    }
-    else{
-        if(coincident_above){
-            T.setNeighbor(top_id,TOP_LEFT,SIZE_MAX);
-            T.setNeighbor(top_id,BOTTOM_LEFT,SIZE_MAX);
-        }
-        else{
-            T.setNeighbor(bottom_id,TOP_LEFT,SIZE_MAX);
-            T.setNeighbor(bottom_id,BOTTOM_LEFT,SIZE_MAX);
-        }
-    }
+/**
+ * @brief algorithms::shootDown
+ * This method shoots a vertical ray down from a point and returns the first segment it hits, which is the bottom
+ * of the trapezoid containing the point. It costs one point location.
+ * @param T the trapezoidal map
+ * @param dag the dag of the map
+ * @param p the query point
+ * @return the id of the segment below the point, NO_SEGMENT if the ray reaches the bounding box
+ */
+size_t algorithms::shootDown(const TrapezoidalMap& T, const Dag& dag, const cg3::Point2d& p){
+    return datasetSegment(T.getTrapezoid(queryTrapezoid(dag, p)).getBottomId());
+}
 
-    if(c!= RIGHT && c!= BOTH){
-    //set neighbors of right trapezoid;
-        T.setNeighbor(right_id, TOP_LEFT, top_id);      //the top right neighbor is the trapezoid above the segment
-        T.setNeighbor(right_id,TOP_RIGHT,old_neighbors[TOP_RIGHT]);
-        T.setNeighbor(right_id,BOTTOM_LEFT,bottom_id);  //the bottom right neighbor is the trapezoid below the segment
-        T.setNeighbor(right_id,BOTTOM_RIGHT,old_neighbors[BOTTOM_RIGHT]);
-    //top-right and bottom-right are the same of the old trapezoid
+/**
+ * @brief algorithms::shootUp
+ * This override shoots the rays of a batch of points with the batch query, the ids of the located trapezoids
+ * are replaced in place by the ids of the segments above them
+ * @param T the trapezoidal map
+ * @param dag the dag of the map
+ * @param points the query points
+ * @param[out] out the ids of the segments above the points, NO_SEGMENT for the bounding box
+ */
+void algorithms::shootUp(const TrapezoidalMap& T, const Dag& dag, const std::vector<cg3::Point2d>& points, std::vector<size_t>& out){
+    queryPoints(dag, points, out);
+    for(size_t& id : out){
+        id = datasetSegment(T.getTrapezoid(id).getTopId());
     }
+}
 
-    //set neighbors of top trapezoid
-    if(c!= LEFT && c != BOTH){
-        T.setNeighbor(top_id,TOP_LEFT,left_id);         //the top left neighbor is the trapezoid to the left of the segment
-    }
-    if(c!= RIGHT && c != BOTH){
-        T.setNeighbor(top_id,TOP_RIGHT,right_id); //the top right neighbor is the trapezoid to the right of the segment
-    }
-    if(c!= LEFT && c != BOTH){
-        T.setNeighbor(top_id,BOTTOM_LEFT,left_id);      //the bottom left neighbor is the trapezoid to the left of the segment
-    }
-    if(c!= RIGHT && c != BOTH){
-        T.setNeighbor(top_id,BOTTOM_RIGHT,right_id);    //the bottom right neighbor is the trapezoid to the right of the segment
+/**
+ * @brief algorithms::shootDown
+ * This override shoots the rays of a batch of points with the batch query, the ids of the located trapezoids
+ * are replaced in place by the ids of the segments below them
+ * @param T the trapezoidal map
+ * @param dag the dag of the map
+ * @param points the query points
+ * @param[out] out the ids of the segments below the points, NO_SEGMENT for the bounding box
+ */
+void algorithms::shootDown(const TrapezoidalMap& T, const Dag& dag, const std::vector<cg3::Point2d>& points, std::vector<size_t>& out){
+    queryPoints(dag, points, out);
+    for(size_t& id : out){
+        id = datasetSegment(T.getTrapezoid(id).getBottomId());
     }
+}
 
-    //set neighbors of bottom trapezoid
-    if(c!= LEFT && c != BOTH){
-        T.setNeighbor(bottom_id,TOP_LEFT,left_id);      //the top left neighbor is the trapezoid to the left of the segment
-    }
-    if(c!= RIGHT && c != BOTH){
-        T.setNeighbor(bottom_id,TOP_RIGHT,right_id);    //the top right neighbor is the trapezoid to the right of the segment
-    }
-    if(c!= LEFT && c != BOTH){
-        T.setNeighbor(bottom_id,BOTTOM_LEFT,left_id);   //the bottom left neighbor is the trapezoid to the left of the segment
-    }
-    if(c!= RIGHT && c != BOTH){
-        T.setNeighbor(bottom_id,BOTTOM_RIGHT,right_id); //the bottom right neighbor is the trapezoid to the right of the segment
-    }
+/**
+ * @brief algorithms::shootUp
+ * This override shoots a vertical ray up from a point in a map file
+ * @param map the map file
+ * @param p the query point
+ * @return the id of the segment above the point, NO_SEGMENT if the ray reaches the bounding box
+ */
+size_t algorithms::shootUp(const MappedTrapezoidalMap& map, const cg3::Point2d& p){
+    return datasetSegment(MappedTrapezoidalMap::toId(map.getTrapezoid(queryTrapezoid(map, p)).top));
+}
 
-    topLeftDegen = utility::pointEqual(ttop.getTop().p1(), ttop.getBottom().p1());
-    topRightDegen = utility::pointEqual(ttop.getTop().p2(), ttop.getBottom().p2());
-    bottomLeftDegen = utility::pointEqual(tbottom.getTop().p1(), tbottom.getBottom().p1());
-    bottomRightDegen = utility::pointEqual(tbottom.getTop().p2(), tbottom.getBottom().p2());
+/**
+ * @brief algorithms::shootDown
+ * This override shoots a vertical ray down from a point in a map file
+ * @param map the map file
+ * @param p the query point
+ * @return the id of the segment below the point, NO_SEGMENT if the ray reaches the bounding box
+ */
+size_t algorithms::shootDown(const MappedTrapezoidalMap& map, const cg3::Point2d& p){
+    return datasetSegment(MappedTrapezoidalMap::toId(map.getTrapezoid(queryTrapezoid(map, p)).bottom));
+}
 
-    //all trapezoids that had tsplit as lower/upper left neighbor now have tright
-    if(T.getTsize() > 4 && c== NONE){
-        T.updateOldNeighbors(true,old_neighbors[TOP_RIGHT],trap_id,right_id);
-        T.updateOldNeighbors(true,old_neighbors[BOTTOM_RIGHT],trap_id,right_id);
+/**
+ * @brief algorithms::shootUp
+ * This override shoots the rays of a batch of points in a map file
+ * @param map the map file
+ * @param points the query points
+ * @param[out] out the ids of the segments above the points, NO_SEGMENT for the bounding box
+ */
+void algorithms::shootUp(const MappedTrapezoidalMap& map, const std::vector<cg3::Point2d>& points, std::vector<size_t>& out){
+    queryPoints(map, points, out);
+    for(size_t& id : out){
+        id = datasetSegment(MappedTrapezoidalMap::toId(map.getTrapezoid(id).top));
     }
-    else if(c == LEFT){
-        if(bottomLeftDegen){
-            T.setNeighbor(bottom_id,TOP_LEFT,SIZE_MAX);
-            T.setNeighbor(bottom_id,TOP_RIGHT,right_id);
-            T.setNeighbor(bottom_id,BOTTOM_LEFT,SIZE_MAX);
-            T.setNeighbor(bottom_id,BOTTOM_RIGHT,right_id);
-
-            T.setNeighbor(top_id,TOP_LEFT,old_neighbors[TOP_LEFT]);
-            T.setNeighbor(top_id,TOP_RIGHT,right_id);
-            T.setNeighbor(top_id,BOTTOM_LEFT,old_neighbors[BOTTOM_LEFT]);
-            T.setNeighbor(top_id,BOTTOM_RIGHT,right_id);
+}
 
-            T.updateOldNeighbors(false,old_neighbors[TOP_LEFT],trap_id, top_id);
-            T.updateOldNeighbors(false,old_neighbors[BOTTOM_LEFT],trap_id, top_id);
-        }
-        else if(topLeftDegen){
-            T.setNeighbor(top_id,TOP_LEFT,SIZE_MAX);
-            T.setNeighbor(top_id,TOP_RIGHT,right_id);
-            T.setNeighbor(top_id,BOTTOM_LEFT,SIZE_MAX);
-            T.setNeighbor(top_id,BOTTOM_RIGHT,right_id);
-
-            T.setNeighbor(bottom_id,TOP_LEFT,old_neighbors[TOP_LEFT]);
-            T.setNeighbor(bottom_id,TOP_RIGHT,right_id);
-            T.setNeighbor(bottom_id,BOTTOM_LEFT,old_neighbors[BOTTOM_LEFT]);
-            T.setNeighbor(bottom_id,BOTTOM_RIGHT,right_id);
-
-            T.updateOldNeighbors(false,old_neighbors[TOP_LEFT],trap_id,bottom_id);
-            T.updateOldNeighbors(false,old_neighbors[BOTTOM_LEFT],trap_id,bottom_id);
-        }
-        else{
-            T.setNeighbor(top_id,TOP_LEFT,old_neighbors[TOP_LEFT]);
-            T.setNeighbor(top_id,TOP_RIGHT,right_id);
-            T.setNeighbor(top_id,BOTTOM_LEFT,old_neighbors[TOP_LEFT]);
-            T.setNeighbor(top_id,BOTTOM_RIGHT,right_id);
-
-            T.setNeighbor(bottom_id,TOP_LEFT,old_neighbors[BOTTOM_LEFT]);
-            T.setNeighbor(bottom_id,TOP_RIGHT,right_id);
-            T.setNeighbor(bottom_id,BOTTOM_LEFT,old_neighbors[BOTTOM_LEFT]);
-            T.setNeighbor(bottom_id,BOTTOM_RIGHT,right_id);
-
-            T.updateOldNeighbors(false,old_neighbors[TOP_LEFT],trap_id,top_id);
-            T.updateOldNeighbors(false,old_neighbors[BOTTOM_LEFT],trap_id,bottom_id);
-        }
+/**
+ * @brief algorithms::shootDown
+ * This override shoots the rays of a batch of points in a map file
+ * @param map the map file
+ * @param points the query points
+ * @param[out] out the ids of the segments below the points, NO_SEGMENT for the bounding box
+ */
+void algorithms::shootDown(const MappedTrapezoidalMap& map, const std::vector<cg3::Point2d>& points, std::vector<size_t>& out){
+    queryPoints(map, points, out);
+    for(size_t& id : out){
+        id = datasetSegment(MappedTrapezoidalMap::toId(map.getTrapezoid(id).bottom));
     }
-    else if(c == RIGHT){
-        if(bottomRightDegen){
-            T.setNeighbor(bottom_id,TOP_LEFT,left_id);
-            T.setNeighbor(bottom_id,TOP_RIGHT,SIZE_MAX);
-            T.setNeighbor(bottom_id,BOTTOM_LEFT,left_id);
-            T.setNeighbor(bottom_id,BOTTOM_RIGHT,SIZE_MAX);
-
-            T.setNeighbor(top_id,TOP_LEFT,left_id);
-            T.setNeighbor(top_id,TOP_RIGHT,old_neighbors[TOP_RIGHT]);
-            T.setNeighbor(top_id,BOTTOM_LEFT,left_id);
-            T.setNeighbor(top_id,BOTTOM_RIGHT,old_neighbors[BOTTOM_RIGHT]);
-
+}
 
-            T.updateOldNeighbors(true,old_neighbors[TOP_RIGHT],trap_id,top_id);
-            T.updateOldNeighbors(true,old_neighbors[BOTTOM_RIGHT],trap_id,top_id);
-        }
-        else if(topRightDegen){
-            T.setNeighbor(top_id,TOP_LEFT,left_id);
-            T.setNeighbor(top_id,TOP_RIGHT,SIZE_MAX);
-            T.setNeighbor(top_id,BOTTOM_LEFT,left_id);
-            T.setNeighbor(top_id,BOTTOM_RIGHT,SIZE_MAX);
-
-            T.setNeighbor(bottom_id,TOP_LEFT,left_id);
-            T.setNeighbor(bottom_id,TOP_RIGHT,old_neighbors[TOP_RIGHT]);
-            T.setNeighbor(bottom_id,BOTTOM_LEFT,left_id);
-            T.setNeighbor(bottom_id,BOTTOM_RIGHT,old_neighbors[BOTTOM_RIGHT]);
-
-            T.updateOldNeighbors(true,old_neighbors[TOP_RIGHT],trap_id,bottom_id);
-            T.updateOldNeighbors(true,old_neighbors[BOTTOM_RIGHT],trap_id,bottom_id);
-        }
-        else{
-            T.setNeighbor(top_id,TOP_LEFT,left_id);
-            T.setNeighbor(top_id,TOP_RIGHT,old_neighbors[TOP_RIGHT]);
-            T.setNeighbor(top_id,BOTTOM_LEFT,left_id);
-            T.setNeighbor(top_id,BOTTOM_RIGHT,old_neighbors[TOP_RIGHT]);
-
-            T.setNeighbor(bottom_id,TOP_LEFT,left_id);
-            T.setNeighbor(bottom_id,TOP_RIGHT,old_neighbors[BOTTOM_RIGHT]);
-            T.setNeighbor(bottom_id,BOTTOM_LEFT,left_id);
-            T.setNeighbor(bottom_id,BOTTOM_RIGHT,old_neighbors[BOTTOM_RIGHT]);
-
-            T.updateOldNeighbors(true,old_neighbors[TOP_RIGHT],trap_id,top_id);
-            T.updateOldNeighbors(true,old_neighbors[BOTTOM_RIGHT],trap_id,bottom_id);
+/**
+ * @brief algorithms::optimizeDagLayout
+ * This method renumbers the nodes of a finished dag in a cache friendly order and updates the ids of the leaves
+ * stored in the trapezoids of the map. The queries return the same trapezoids, and segments can still be inserted.
+ * @param T the trapezoidal map of the dag
+ * @param D the dag to renumber
+ * @param layout BFS_LAYOUT or VEB_LAYOUT
+ */
+void algorithms::optimizeDagLayout(TrapezoidalMap& T, Dag& D, dagLayout layout){
+    D.relayout(layout);
+    for(size_t i = 0; i < D.getVectorSize(DAGNODE); i++){
+        const DagNode& n = D.getElementInDVector(i);
+        if(n.getNodeType() == TRAPEZOID){
+            T.setDagId(n.getEntityId(), i);
         }
     }
-    else if(c == BOTH){
-
-        if(bottomLeftDegen && topRightDegen){
-            T.setNeighbor(top_id,TOP_LEFT, old_neighbors[TOP_LEFT]);
-            T.setNeighbor(top_id,TOP_RIGHT, SIZE_MAX);
-            T.setNeighbor(top_id,BOTTOM_LEFT, old_neighbors[TOP_LEFT]);
-            T.setNeighbor(top_id,BOTTOM_RIGHT, SIZE_MAX);
-
-            T.setNeighbor(bottom_id,TOP_LEFT, SIZE_MAX);
-            T.setNeighbor(bottom_id,TOP_RIGHT, old_neighbors[BOTTOM_RIGHT]);
-            T.setNeighbor(bottom_id,BOTTOM_LEFT, SIZE_MAX);
-            T.setNeighbor(bottom_id,BOTTOM_RIGHT, old_neighbors[BOTTOM_RIGHT]);
+}
 
-            T.updateOldNeighbors(false,old_neighbors[TOP_LEFT],trap_id,top_id);
-            T.updateOldNeighbors(true,old_neighbors[BOTTOM_RIGHT],trap_id,bottom_id);
-        }
-        else if(bottomRightDegen && topLeftDegen){
-            if(bottomLeftDegen && topRightDegen){
-                T.setNeighbor(top_id,TOP_LEFT, SIZE_MAX);
-                T.setNeighbor(top_id,TOP_RIGHT, old_neighbors[TOP_RIGHT]);
-                T.setNeighbor(top_id,BOTTOM_LEFT, SIZE_MAX);
-                T.setNeighbor(top_id,BOTTOM_RIGHT, old_neighbors[TOP_RIGHT]);
-
-                T.setNeighbor(bottom_id,TOP_LEFT, old_neighbors[BOTTOM_LEFT]);
-                T.setNeighbor(bottom_id,TOP_RIGHT, SIZE_MAX);
-                T.setNeighbor(bottom_id,BOTTOM_LEFT, old_neighbors[BOTTOM_LEFT]);
-                T.setNeighbor(bottom_id,BOTTOM_RIGHT, SIZE_MAX);
-
-                T.updateOldNeighbors(false,old_neighbors[TOP_LEFT],trap_id,bottom_id);
-                T.updateOldNeighbors(true,old_neighbors[TOP_RIGHT],trap_id,top_id);
+/**
+ * @brief algorithms::averageCacheLines
+ * This method measures the layout of a dag: it walks the points from the root, as queryPoint does, and counts the
+ * distinct cache lines of the nodes of every path, for a table of nodes of nodeSize bytes starting at a cache line.
+ * The packed dag has the same ids of the dag, so its layout is measured with sizeof(PackedDagNode).
+ * @param dag the dag to measure
+ * @param points the query points
+ * @param nodeSize the size of a node in bytes
+ * @return the average number of cache lines of nodes touched by a query
+ */
+double algorithms::averageCacheLines(const Dag& dag, const std::vector<cg3::Point2d>& points, size_t nodeSize){
+    if(points.empty()){
+        return 0;
+    }
+    size_t total = 0;
+    std::vector<size_t> lines; //the cache lines touched by the current query
+    for(const cg3::Point2d& p : points){
+        lines.clear();
+        size_t id = 0;
+        while(true){
+            size_t line = id * nodeSize / CACHE_LINE;
+            if(std::find(lines.begin(), lines.end(), line) == lines.end()){
+                lines.push_back(line);
             }
-        }
-        else if(bottomLeftDegen || bottomRightDegen){
-                T.setNeighbor(top_id,TOP_LEFT,old_neighbors[TOP_LEFT]);
-                T.setNeighbor(top_id,TOP_RIGHT,old_neighbors[TOP_RIGHT]);
-                T.setNeighbor(top_id,BOTTOM_LEFT,old_neighbors[TOP_LEFT]);
-                T.setNeighbor(top_id,BOTTOM_RIGHT,old_neighbors[TOP_RIGHT]);
-
-                T.updateOldNeighbors(false,old_neighbors[TOP_LEFT],trap_id,top_id);
-                T.updateOldNeighbors(true,old_neighbors[TOP_RIGHT],trap_id,top_id);
-
-                if(bottomLeftDegen){
-                    T.setNeighbor(bottom_id,TOP_LEFT,SIZE_MAX);
-                    T.setNeighbor(bottom_id,TOP_RIGHT,old_neighbors[BOTTOM_RIGHT]);
-                    T.setNeighbor(bottom_id,BOTTOM_LEFT,SIZE_MAX);
-                    T.setNeighbor(bottom_id,BOTTOM_RIGHT,old_neighbors[BOTTOM_RIGHT]);
-
-                    T.updateOldNeighbors(true,old_neighbors[BOTTOM_RIGHT],trap_id,bottom_id);
-                }else{
-                    T.setNeighbor(bottom_id,TOP_LEFT,old_neighbors[BOTTOM_LEFT]);
-                    T.setNeighbor(bottom_id,TOP_RIGHT,SIZE_MAX);
-                    T.setNeighbor(bottom_id,BOTTOM_LEFT,old_neighbors[BOTTOM_LEFT]);
-                    T.setNeighbor(bottom_id,BOTTOM_RIGHT,SIZE_MAX);
-
-                    T.updateOldNeighbors(false,old_neighbors[BOTTOM_LEFT],trap_id,bottom_id);
-                }
-        }
-        else if(topLeftDegen || topRightDegen){
-            T.setNeighbor(bottom_id,TOP_LEFT,old_neighbors[BOTTOM_LEFT]);
-            T.setNeighbor(bottom_id,TOP_RIGHT,old_neighbors[BOTTOM_RIGHT]);
-            T.setNeighbor(bottom_id,BOTTOM_LEFT,old_neighbors[BOTTOM_LEFT]);
-            T.setNeighbor(bottom_id,BOTTOM_RIGHT,old_neighbors[BOTTOM_RIGHT]);
-
-            T.updateOldNeighbors(false,old_neighbors[BOTTOM_LEFT],trap_id,bottom_id);
-            T.updateOldNeighbors(false,old_neighbors[BOTTOM_RIGHT],trap_id,bottom_id);
-
-            if(topLeftDegen){
-                T.setNeighbor(top_id,TOP_LEFT,SIZE_MAX);
-                T.setNeighbor(top_id,TOP_RIGHT,old_neighbors[TOP_RIGHT]);
-                T.setNeighbor(top_id,BOTTOM_LEFT,SIZE_MAX);
-                T.setNeighbor(top_id,BOTTOM_RIGHT,old_neighbors[TOP_RIGHT]);
-
-                T.updateOldNeighbors(true,old_neighbors[TOP_RIGHT],trap_id,top_id);
+            const DagNode& d = dag.getElementInDVector(id);
+            if(d.getNodeType() == TRAPEZOID){
+                break;
+            }
+            bool left;
+            if(d.getNodeType() == POINT){
+                left = p.x() < dag.getElementInPVector(d.getEntityId()).x();
             }
             else{
-                T.setNeighbor(top_id,TOP_LEFT,old_neighbors[TOP_LEFT]);
-                T.setNeighbor(top_id,TOP_RIGHT,SIZE_MAX);
-                T.setNeighbor(top_id,BOTTOM_LEFT,old_neighbors[TOP_LEFT]);
-                T.setNeighbor(top_id,BOTTOM_RIGHT,SIZE_MAX);
-
-                T.updateOldNeighbors(false,old_neighbors[TOP_LEFT],trap_id,top_id);
+                left = goesLeft(dag.getElementInSVector(d.getEntityId()),p,p);
             }
+            id = left ? d.getLeftC() : d.getRightC();
         }
-
-
-
+        total += lines.size();
     }
-
-    switch(c){
-    case NONE:
-        dagVector = updateDag(T,D,s,dag_id,left_id,right_id,top_id,bottom_id); //update the Dag
-        T.setDagId(left_id,dagVector[0]);
-        T.setDagId(top_id,dagVector[1]);
-        T.setDagId(bottom_id,dagVector[2]);
-        T.setDagId(right_id,dagVector[3]);
-        break;
-    case LEFT:
-        dagVector = updateDag(T,D,s,c,dag_id,right_id,top_id,bottom_id);
-        T.setDagId(top_id,dagVector[0]);
-        T.setDagId(bottom_id,dagVector[1]);
-        T.setDagId(right_id,dagVector[2]);
-        break;
-    case RIGHT:
-        dagVector = updateDag(T,D,s,c,dag_id,left_id,top_id,bottom_id);
-        T.setDagId(left_id,dagVector[0]);
-        T.setDagId(top_id,dagVector[1]);
-        T.setDagId(bottom_id,dagVector[2]);
-        break;
-    case BOTH:
-        dagVector = updateDag(T,D,s,c,dag_id,top_id,bottom_id);
-        T.setDagId(top_id,dagVector[0]);
-        T.setDagId(bottom_id,dagVector[1]);
-        break;
-    }
-
+    return double(total) / points.size();
 }
-
-/**
- * @brief algorithms::multipleSplit
- * This method performs a multiple split when a segment intersects more than a trapezoid.
- * A split in 3 to the left is called for the first trapezoid, a split in 3 to the right is called for the last trapezoid and, if
- * there are more than 2 elements, a split in 2 is called for all of the middle trapezoids.
- * @param T a reference to the trapezoidal map containing the trapezoids
- * @param s a reference to the segment inserted
- * @param D a reference to the dag to use as a search structure
- * @param delta the list of trapezoids intersected by the segment s
- */
-void algorithms::multipleSplit(TrapezoidalMap& T, const cg3::Segment2d& s, Dag& D, std::vector<Trapezoid> delta){
-    bool merge_above = false;
-    bool first = true;
-    size_t t_prev;
-    Trapezoid t_merge;
-    for(size_t i = 0; i < delta.size(); i++){
-        if(i == 0){
-            splitin3(T,s,D,delta[0].getId(),true,merge_above,t_merge,t_prev,delta[1].getId(),first);
-        }
-        else if(i == delta.size() - 1){
-            splitin3(T,s,D,delta[delta.size()-1].getId(),false,merge_above,t_merge,t_prev,delta[i+1].getId(),first);
-        }
-        else{
-            splitin2(T,s,D,delta[i].getId(),merge_above,t_merge,t_prev,delta[i+1].getId(),first);
-        }
-    }
-
-
-}
-
@@ -3,29 +3,74 @@
 
 #include "data_structures/trapezoidalmap.h"
 #include "data_structures/dag.h"
+#include "data_structures/packed_dag.h"
+#include "data_structures/mapped_trapezoidalmap.h"
 #include <iostream>
 #include "cg3/geometry/intersections2.h"
 
+#define WALK_MAX_STEPS 16 // the trapezoids a walking query crosses before it falls back to the dag
+#define NO_SEGMENT SIZE_MAX // the result of a ray shooting query whose ray reaches the bounding box
+
 namespace algorithms{
-   std::vector<Trapezoid> followSegment(TrapezoidalMap T, Dag D, cg3::Segment2d s);
+   //construction methods
+   void addSegment(TrapezoidalMap& T, Dag& D, const cg3::Segment2d& segment);
+   void insertSegment(TrapezoidalMap& T, Dag& D, size_t s);
+   std::vector<size_t> randomInsertionOrder(size_t n, unsigned long seed);
+   void buildTrapezoidalMap(TrapezoidalMap& T, Dag& D, const std::vector<cg3::Segment2d>& segments, unsigned long seed);
+
+   std::vector<size_t> followSegment(const TrapezoidalMap& T, const Dag& D, size_t s);
 
-   template<typename T>
-   size_t getIndex(std::vector<T> v, T K);
+   //removal methods, they merge the trapezoids of a segment without building the map again
+   bool removeSegment(TrapezoidalMap& T, Dag& D, size_t s);
+   bool isCompactionDue(const TrapezoidalMap& T, const Dag& D);
+   void compactTrapezoidalMap(TrapezoidalMap& T, Dag& D, unsigned long seed);
 
    //dag-related methods
-   std::vector<size_t> updateDag(TrapezoidalMap& T, Dag& D, cg3::Segment2d s, size_t tsplit, size_t tleft, size_t tright, size_t ttop, size_t tbottom);
-   std::vector<size_t> updateDag(TrapezoidalMap& T, Dag& D, cg3::Segment2d s, size_t tsplit, size_t ttop, size_t tbottom, size_t tother, bool left);
-   std::vector<size_t> updateDag(TrapezoidalMap& T, Dag& D, cg3::Segment2d s, size_t tsplit, size_t ttop, size_t tbottom);
-   std::vector<size_t> updateDag(TrapezoidalMap& T, Dag& D, cg3::Segment2d s, coincidence coincidence, size_t tsplit, size_t tother, size_t ttop, size_t tbottom);
-   std::vector<size_t> updateDag(TrapezoidalMap& T, Dag& D, cg3::Segment2d s, coincidence coincidence, size_t tsplit, size_t ttop, size_t tbottom);
-   size_t queryPoint(Dag dag, cg3::Point2d p);
-   size_t queryPoint(Dag dag, cg3::Point2d p1, cg3::Point2d p2);
+   void updateDag(TrapezoidalMap& T, Dag& D, size_t s, const std::vector<size_t>& leaves, size_t tleft, size_t tright,
+                  const std::vector<size_t>& tupper, const std::vector<size_t>& tlower);
+
+   //query methods, they work on the live structures without copying them
+   size_t queryPoint(const Dag& dag, const cg3::Point2d& p);
+   size_t queryPoint(const Dag& dag, const cg3::Point2d& p1, const cg3::Point2d& p2);
+   const DagNode& queryPoint(const Dag& dag, const cg3::Point2d& p, size_t& depth);
+   const DagNode& queryPoint(const Dag& dag, const cg3::Point2d& p1, const cg3::Point2d& p2, size_t& depth);
+   size_t queryTrapezoid(const Dag& dag, const cg3::Point2d& p);
+   void queryPoints(const Dag& dag, const std::vector<cg3::Point2d>& points, std::vector<size_t>& out);
+   void queryPoints(const Dag& dag, const std::vector<cg3::Point2d>& points, size_t begin, size_t end, std::vector<size_t>& out);
+
+   //walking query methods, they start from a trapezoid near the point and fall back to the dag
+   bool walkToPoint(const TrapezoidalMap& T, const cg3::Point2d& p, size_t start, size_t maxSteps, size_t& trapezoid);
+   size_t queryTrapezoid(const TrapezoidalMap& T, const Dag& dag, const cg3::Point2d& p, size_t hint,
+                         size_t maxSteps = WALK_MAX_STEPS);
+   void queryPointsWalking(const TrapezoidalMap& T, const Dag& dag, const std::vector<cg3::Point2d>& points,
+                           std::vector<size_t>& out, size_t maxSteps = WALK_MAX_STEPS);
+
+   //query methods on the packed dag, they return the same trapezoids of the queries on the Dag
+   size_t queryTrapezoid(const PackedDag& dag, const cg3::Point2d& p);
+   void queryPoints(const PackedDag& dag, const std::vector<cg3::Point2d>& points, std::vector<size_t>& out);
+   void queryPoints(const PackedDag& dag, const std::vector<cg3::Point2d>& points, size_t begin, size_t end, std::vector<size_t>& out);
+
+   //query methods on a map file, they return the same trapezoids of the map that has been saved
+   size_t queryTrapezoid(const MappedTrapezoidalMap& map, const cg3::Point2d& p);
+   void queryPoints(const MappedTrapezoidalMap& map, const std::vector<cg3::Point2d>& points, std::vector<size_t>& out);
+   void queryPoints(const MappedTrapezoidalMap& map, const std::vector<cg3::Point2d>& points, size_t begin, size_t end, std::vector<size_t>& out);
+
+   //ray shooting methods, they return the id of the segment hit by a vertical ray from the point
+   size_t shootUp(const TrapezoidalMap& T, const Dag& dag, const cg3::Point2d& p);
+   size_t shootDown(const TrapezoidalMap& T, const Dag& dag, const cg3::Point2d& p);
+   void shootUp(const TrapezoidalMap& T, const Dag& dag, const std::vector<cg3::Point2d>& points, std::vector<size_t>& out);
+   void shootDown(const TrapezoidalMap& T, const Dag& dag, const std::vector<cg3::Point2d>& points, std::vector<size_t>& out);
+   size_t shootUp(const MappedTrapezoidalMap& map, const cg3::Point2d& p);
+   size_t shootDown(const MappedTrapezoidalMap& map, const cg3::Point2d& p);
+   void shootUp(const MappedTrapezoidalMap& map, const std::vector<cg3::Point2d>& points, std::vector<size_t>& out);
+   void shootDown(const MappedTrapezoidalMap& map, const std::vector<cg3::Point2d>& points, std::vector<size_t>& out);
+
+   //layout methods, they store the nodes of a finished dag in a cache friendly order
+   void optimizeDagLayout(TrapezoidalMap& T, Dag& D, dagLayout layout);
+   double averageCacheLines(const Dag& dag, const std::vector<cg3::Point2d>& points, size_t nodeSize);
 
    //split methods
-   void splitin2(TrapezoidalMap& T, const cg3::Segment2d& s, Dag & D, size_t trap_id, bool& merge_above, Trapezoid& t_merge, size_t & t_prev, size_t next, bool& first);
-   void splitin3(TrapezoidalMap& T, const cg3::Segment2d& s, Dag& D, size_t trap_id, bool left, bool& merge_above, Trapezoid & t_merge, size_t & t_prev, size_t next, bool& first);
-   void splitin4(TrapezoidalMap& T, const cg3::Segment2d& s, Dag& D, size_t trap_id);
-   void multipleSplit(TrapezoidalMap& T, const cg3::Segment2d& s, Dag& D, std::vector<Trapezoid> delta);
+   void splitTrapezoids(TrapezoidalMap& T, Dag& D, size_t s, const std::vector<size_t>& delta);
 
 
 
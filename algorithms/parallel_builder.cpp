@@ -0,0 +1,478 @@
+#include "parallel_builder.h"
+#include "algorithms.h"
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <thread>
+
+#define TOP_LEFT 0
+#define TOP_RIGHT 1
+#define BOTTOM_LEFT 2
+#define BOTTOM_RIGHT 3
+#define PARALLEL_MIN_SLAB_SEGMENTS 1024 // the minimum number of segments of a slab, smaller inputs use fewer slabs
+#define PARALLEL_BOUNDARY_SAMPLES 65536 // the endpoints sampled to choose the boundaries of the slabs
+
+namespace {
+
+/**
+ * @brief The Slab struct
+ * A vertical slab of the bounding box with the trapezoidal map of the segments that touch it. The segments are not
+ * clipped, so the map of the slab has no new points, and inside the slab it is the same as the map of all the
+ * segments: the walls inside the slab come from the endpoints inside it, and they end on segments that cross it.
+ */
+struct Slab{
+    double left;                    //the x coordinate of the left boundary, -infinity for the first slab
+    double right;                   //the x coordinate of the right boundary, +infinity for the last slab
+    std::vector<size_t> segments;   //the id in the whole map of every segment of the slab, by its id in the slab
+    std::vector<size_t> points;     //the id in the whole map of every point of the slab, by its id in the slab
+    TrapezoidalMap map;             //the trapezoidal map of the segments of the slab
+    Dag dag;                        //the dag of the map of the slab
+
+    std::vector<size_t> trapezoid;  //the id in the whole map of every trapezoid that overlaps the slab, SIZE_MAX otherwise
+    std::vector<size_t> next;       //the trapezoid of the next slab that continues a trapezoid crossing the right boundary
+    std::vector<size_t> starting;   //the trapezoids that start in the slab, in the order of their ids in the whole map
+    std::vector<size_t> crossingLeft;   //the trapezoids that cross the left boundary
+    std::vector<size_t> crossingRight;  //the trapezoids that cross the right boundary
+    std::vector<size_t> atLeft;     //the trapezoids that start on the left boundary, to the right of its point
+    std::vector<size_t> atRight;    //the trapezoids that end on the right boundary, to the left of its point
+    size_t firstTrapezoid;          //the id in the whole map of the first trapezoid that starts in the slab
+
+    std::vector<size_t> node;       //the id in the whole dag of every inner node kept, SIZE_MAX otherwise
+    std::vector<size_t> kept;       //the inner nodes that can be reached by the points of the slab
+    size_t firstNode;               //the id in the whole dag of the first node kept
+};
+
+/**
+ * @brief parallelFor
+ * Runs task(i) for every i in [0, n) on several threads, every thread takes the next i when it finishes one
+ * @param n the number of tasks
+ * @param threads the number of threads
+ * @param task the function called for every task
+ */
+template<typename Task>
+void parallelFor(size_t n, size_t threads, const Task& task){
+    std::atomic<size_t> next(0);
+    auto worker = [&](){
+        for(size_t i = next++; i < n; i = next++){
+            task(i);
+        }
+    };
+    std::vector<std::thread> pool;
+    for(size_t t = 1; t < std::min(threads, n); t++){
+        pool.push_back(std::thread(worker));
+    }
+    worker(); //the calling thread works as well
+    for(std::thread& t : pool){
+        t.join();
+    }
+}
+
+/**
+ * @brief globalSegment
+ * @return the id in the whole map of a segment of the slab, the sides of the bounding box keep their ids
+ */
+inline size_t globalSegment(const Slab& slab, size_t id){
+    return id < slab.segments.size() ? slab.segments[id] : id;
+}
+
+/**
+ * @brief globalPoint
+ * @return the id in the whole map of a point of the slab, the points of the bounding box keep their ids
+ */
+inline size_t globalPoint(const Slab& slab, size_t id){
+    return id < slab.points.size() ? slab.points[id] : id;
+}
+
+/**
+ * @brief sameSides
+ * @return true if a trapezoid of the slab a and one of the slab b lie between the same segments
+ */
+inline bool sameSides(const Slab& a, const Trapezoid& ta, const Slab& b, const Trapezoid& tb){
+    return globalSegment(a, ta.getTopId()) == globalSegment(b, tb.getTopId()) &&
+           globalSegment(a, ta.getBottomId()) == globalSegment(b, tb.getBottomId());
+}
+
+/**
+ * @brief resolve
+ * Finds the id in the whole map of a trapezoid of the map of a slab. A trapezoid that overlaps the slab has one,
+ * a neighbor of a trapezoid of the slab can also lie beyond a boundary, next to the wall of the point of the
+ * boundary: then it is the trapezoid of the next slab that touches the wall and lies between the same segments.
+ * @param slabs the slabs
+ * @param i the slab of the trapezoid
+ * @param id the id of the trapezoid in the map of the slab, SIZE_MAX if there is none
+ * @return the id of the trapezoid in the whole map, SIZE_MAX if there is none
+ */
+size_t resolve(const std::vector<Slab>& slabs, size_t i, size_t id){
+    if(id == SIZE_MAX || slabs[i].trapezoid[id] != SIZE_MAX){
+        return id == SIZE_MAX ? SIZE_MAX : slabs[i].trapezoid[id];
+    }
+    const Slab& slab = slabs[i];
+    const Trapezoid& t = slab.map.getTrapezoid(id);
+    bool toTheLeft = slab.map.getRightp(t).x() <= slab.left;
+    if(toTheLeft ? i == 0 : i + 1 == slabs.size()){
+        return SIZE_MAX;
+    }
+    const Slab& other = slabs[toTheLeft ? i - 1 : i + 1];
+    for(size_t candidate : toTheLeft ? other.atRight : other.atLeft){
+        if(sameSides(slab, t, other, other.map.getTrapezoid(candidate))){
+            return other.trapezoid[candidate];
+        }
+    }
+    return SIZE_MAX;
+}
+
+/**
+ * @brief follow
+ * Skips the point nodes of a slab whose point lies outside the slab: the points of the slab always go to the same
+ * child, so the node is replaced by that child
+ * @param slab the slab
+ * @param id a node of the dag of the slab
+ * @return the first node that is not skipped
+ */
+size_t follow(const Slab& slab, size_t id){
+    while(true){
+        const DagNode& n = slab.dag.getElementInDVector(id);
+        if(n.getNodeType() != POINT){
+            return id;
+        }
+        double x = slab.dag.getElementInPVector(n.getEntityId()).x();
+        if(x <= slab.left){
+            id = n.getRightC();
+        }
+        else if(x >= slab.right){
+            id = n.getLeftC();
+        }
+        else{
+            return id;
+        }
+    }
+}
+
+/**
+ * @brief buildSlab
+ * Builds the trapezoidal map of the segments of a slab with the randomized incremental algorithm, then it lists the
+ * trapezoids that overlap the slab and the ones that cross or touch its boundaries
+ * @param T the whole map, with all the segments
+ * @param slab the slab
+ * @param seed the seed of the random insertion order of the slab
+ */
+void buildSlab(const TrapezoidalMap& T, Slab& slab, unsigned long seed){
+    slab.map.reserve(slab.segments.size());
+    slab.dag.reserve(slab.segments.size());
+    for(size_t s : slab.segments){
+        size_t id = slab.map.addSegment(T.getSegment(s));
+        slab.points.resize(slab.map.getPointsSize());
+        slab.points[slab.map.getSegmentLeftpId(id)] = T.getSegmentLeftpId(s);
+        slab.points[slab.map.getSegmentRightpId(id)] = T.getSegmentRightpId(s);
+    }
+    for(size_t i : algorithms::randomInsertionOrder(slab.segments.size(), seed)){
+        algorithms::insertSegment(slab.map, slab.dag, i);
+    }
+
+    slab.trapezoid.assign(slab.map.getTsize(), SIZE_MAX);
+    slab.next.assign(slab.map.getTsize(), SIZE_MAX);
+    for(size_t id = 0; id < slab.map.getTsize(); id++){
+        const Trapezoid& t = slab.map.getTrapezoid(id);
+        double left = slab.map.getLeftp(t).x(), right = slab.map.getRightp(t).x();
+        if(left >= slab.right || right <= slab.left){
+            continue; //the trapezoid doesn't overlap the slab
+        }
+        if(left < slab.left){
+            slab.crossingLeft.push_back(id);
+        }
+        else{
+            slab.starting.push_back(id);
+        }
+        if(right > slab.right){
+            slab.crossingRight.push_back(id);
+        }
+        if(left == slab.left){
+            slab.atLeft.push_back(id);
+        }
+        if(right == slab.right){
+            slab.atRight.push_back(id);
+        }
+    }
+}
+
+/**
+ * @brief matchBoundary
+ * Pairs the trapezoids that cross the boundary between two slabs: on both sides they are the trapezoids between
+ * the same consecutive segments that cross the boundary, so they are matched by their top and bottom segments.
+ * @param a the slab to the left of the boundary
+ * @param b the slab to the right of the boundary
+ * @return false if the trapezoids can't be paired, it happens only if the segments are not in general position
+ */
+bool matchBoundary(Slab& a, Slab& b){
+    if(a.crossingRight.size() != b.crossingLeft.size()){
+        return false;
+    }
+    auto byAOrder = [&](size_t x, size_t y){
+        const Trapezoid& tx = a.map.getTrapezoid(x);
+        const Trapezoid& ty = a.map.getTrapezoid(y);
+        return std::make_pair(globalSegment(a, tx.getTopId()), globalSegment(a, tx.getBottomId())) <
+               std::make_pair(globalSegment(a, ty.getTopId()), globalSegment(a, ty.getBottomId()));
+    };
+    auto byBOrder = [&](size_t x, size_t y){
+        const Trapezoid& tx = b.map.getTrapezoid(x);
+        const Trapezoid& ty = b.map.getTrapezoid(y);
+        return std::make_pair(globalSegment(b, tx.getTopId()), globalSegment(b, tx.getBottomId())) <
+               std::make_pair(globalSegment(b, ty.getTopId()), globalSegment(b, ty.getBottomId()));
+    };
+    std::sort(a.crossingRight.begin(), a.crossingRight.end(), byAOrder);
+    std::sort(b.crossingLeft.begin(), b.crossingLeft.end(), byBOrder);
+    for(size_t i = 0; i < a.crossingRight.size(); i++){
+        size_t x = a.crossingRight[i], y = b.crossingLeft[i];
+        if(!sameSides(a, a.map.getTrapezoid(x), b, b.map.getTrapezoid(y))){
+            return false;
+        }
+        a.next[x] = y;
+    }
+    return true;
+}
+
+/**
+ * @brief buildSequentially
+ * Inserts the segments of the map one by one in a random order, as buildTrapezoidalMap() does
+ * @param T the trapezoidal map, its tables contain all the segments and it has no trapezoids but the bounding box
+ * @param D the empty Dag of the trapezoidal map
+ * @param seed the seed of the random insertion order
+ */
+void buildSequentially(TrapezoidalMap& T, Dag& D, unsigned long seed){
+    D.reserve(T.getSegmentsSize());
+    for(size_t s : algorithms::randomInsertionOrder(T.getSegmentsSize(), seed)){
+        algorithms::insertSegment(T, D, s);
+    }
+}
+
+/**
+ * @brief leafOf
+ * @return the id in the whole dag of the leaf reached from a node of a slab
+ */
+size_t leafOf(const std::vector<Slab>& slabs, size_t i, size_t id, size_t firstLeaf){
+    size_t trapezoid = resolve(slabs, i, slabs[i].dag.getElementInDVector(id).getEntityId());
+    //a trapezoid outside the slab can't contain a point of the slab, any leaf of the slab can replace it
+    return firstLeaf + (trapezoid != SIZE_MAX ? trapezoid : slabs[i].firstTrapezoid);
+}
+
+/**
+ * @brief childOf
+ * @return the id in the whole dag of the node reached from a node of a slab, after skipping the useless point nodes
+ */
+size_t childOf(const std::vector<Slab>& slabs, size_t i, size_t id, size_t firstLeaf){
+    id = follow(slabs[i], id);
+    if(slabs[i].dag.getElementInDVector(id).getNodeType() == TRAPEZOID){
+        return leafOf(slabs, i, id, firstLeaf);
+    }
+    return slabs[i].node[id];
+}
+
+/**
+ * @brief buildSlabTree
+ * Inserts the top of the dag, a balanced search on the x coordinate of the boundaries among the slabs first..last
+ * @param D the whole dag, the nodes of the top are its first nodes
+ * @param slabs the slabs
+ * @param boundaries the ids of the points on the boundaries, the boundary i is to the left of the slab i + 1
+ * @param first the first slab
+ * @param last the last slab
+ * @param firstLeaf the id of the first leaf of the whole dag
+ * @param[in,out] count the number of nodes of the top already inserted
+ * @return the id of the root of the search
+ */
+size_t buildSlabTree(Dag& D, const std::vector<Slab>& slabs, const std::vector<size_t>& boundaries, size_t first,
+                     size_t last, size_t firstLeaf, size_t& count){
+    if(first == last){
+        return childOf(slabs, first, 0, firstLeaf);
+    }
+    size_t middle = (first + last + 1) / 2;
+    size_t id = count++;
+    DagNode root = DagNode(POINT, boundaries[middle - 1]);
+    root.setLeftc(buildSlabTree(D, slabs, boundaries, first, middle - 1, firstLeaf, count));
+    root.setRightc(buildSlabTree(D, slabs, boundaries, middle, last, firstLeaf, count));
+    D.replaceNode(id, root);
+    return id;
+}
+
+}
+
+/**
+ * @brief algorithms::parallelBuildTrapezoidalMap
+ * This method builds the trapezoidal map on several threads. The bounding box is divided in vertical slabs at
+ * quantiles of the x coordinates of the endpoints, and the map of the segments that touch every slab is built on
+ * its own thread with the randomized incremental algorithm. The segments are not clipped: the map of a slab is the
+ * same as the whole map inside the slab, so the trapezoids cut by a boundary are stitched back by pairing the
+ * pieces between the same segments. The map is the same of a sequential construction, only the ids of the
+ * trapezoids change. The dags of the slabs are put under a balanced search on the boundaries, and their point
+ * nodes outside the slab are skipped. Segments can be inserted and removed later as in a sequential map.
+ * The map and the dag must be empty, otherwise the segments are inserted one by one as buildTrapezoidalMap() does;
+ * the same happens when the input is too small for more than one slab or is not in general position.
+ * @param T the trapezoidal map to build
+ * @param D the Dag of the trapezoidal map
+ * @param segments the segments to insert, the id of a segment is its position in the vector
+ * @param seed the seed of the random insertion orders
+ * @param threads the number of threads and of slabs, 0 to use all the cores of the machine
+ */
+void algorithms::parallelBuildTrapezoidalMap(TrapezoidalMap& T, Dag& D, const std::vector<cg3::Segment2d>& segments,
+                                             unsigned long seed, size_t threads){
+    if(threads == 0){
+        threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+    }
+    size_t k = std::min(threads, segments.size() / PARALLEL_MIN_SLAB_SEGMENTS);
+    if(k <= 1 || T.getSegmentsSize() > 0 || T.getTsize() > 1 || D.getVectorSize(DAGNODE) > 1){
+        buildTrapezoidalMap(T, D, segments, seed);
+        return;
+    }
+    T.reserve(segments.size());
+    for(const cg3::Segment2d& s : segments){
+        T.addSegment(s);
+    }
+
+    //the boundaries are endpoints at the quantiles of a sample of the endpoints
+    std::vector<std::pair<double,size_t>> sample;
+    size_t samples = std::min(T.getPointsSize(), size_t(PARALLEL_BOUNDARY_SAMPLES));
+    for(size_t i = 0; i < samples; i++){
+        size_t id = i * T.getPointsSize() / samples;
+        sample.push_back(std::make_pair(T.getPoint(id).x(), id));
+    }
+    std::sort(sample.begin(), sample.end());
+    std::vector<size_t> boundaries;
+    std::vector<double> bx;
+    for(size_t i = 1; i < k; i++){
+        const std::pair<double,size_t>& b = sample[i * samples / k];
+        if(bx.empty() || b.first > bx.back()){
+            boundaries.push_back(b.second);
+            bx.push_back(b.first);
+        }
+    }
+    k = boundaries.size() + 1;
+    if(k == 1){
+        buildSequentially(T, D, seed);
+        return;
+    }
+
+    //a segment belongs to every slab it touches, the boundaries included
+    std::vector<Slab> slabs(k);
+    for(size_t i = 0; i < k; i++){
+        slabs[i].left = i == 0 ? -std::numeric_limits<double>::infinity() : bx[i - 1];
+        slabs[i].right = i == k - 1 ? std::numeric_limits<double>::infinity() : bx[i];
+    }
+    for(size_t s = 0; s < T.getSegmentsSize(); s++){
+        const cg3::Segment2d& segment = T.getSegment(s);
+        size_t first = std::lower_bound(bx.begin(), bx.end(), segment.p1().x()) - bx.begin();
+        size_t last = std::upper_bound(bx.begin(), bx.end(), segment.p2().x()) - bx.begin();
+        for(size_t i = first; i <= last; i++){
+            slabs[i].segments.push_back(s);
+        }
+    }
+
+    parallelFor(k, threads, [&](size_t i){
+        buildSlab(T, slabs[i], seed + i);
+    });
+
+    //the pieces of a trapezoid cut by the boundaries are paired from left to right, so a trapezoid that crosses
+    //several slabs takes the id of its first piece
+    for(size_t i = 0; i + 1 < k; i++){
+        if(!matchBoundary(slabs[i], slabs[i + 1])){
+            slabs.clear();
+            buildSequentially(T, D, seed);
+            return;
+        }
+    }
+    size_t trapezoids = 0;
+    for(Slab& slab : slabs){
+        slab.firstTrapezoid = trapezoids;
+        for(size_t j = 0; j < slab.starting.size(); j++){
+            slab.trapezoid[slab.starting[j]] = trapezoids + j;
+        }
+        trapezoids += slab.starting.size();
+    }
+    for(size_t i = 0; i + 1 < k; i++){
+        for(size_t id : slabs[i].crossingRight){
+            slabs[i + 1].trapezoid[slabs[i].next[id]] = slabs[i].trapezoid[id];
+        }
+    }
+
+    //the inner nodes of every slab that can be reached by its points
+    parallelFor(k, threads, [&](size_t i){
+        Slab& slab = slabs[i];
+        slab.node.assign(slab.dag.getVectorSize(DAGNODE), SIZE_MAX);
+        std::vector<size_t> stack(1, follow(slab, 0));
+        while(!stack.empty()){
+            size_t id = stack.back();
+            stack.pop_back();
+            const DagNode& n = slab.dag.getElementInDVector(id);
+            if(n.getNodeType() == TRAPEZOID || slab.node[id] != SIZE_MAX){
+                continue;
+            }
+            slab.node[id] = slab.kept.size();
+            slab.kept.push_back(id);
+            stack.push_back(follow(slab, n.getRightC()));
+            stack.push_back(follow(slab, n.getLeftC()));
+        }
+    });
+
+    //the whole dag: the search among the slabs, the leaves of the trapezoids, then the inner nodes of every slab
+    size_t firstLeaf = k - 1;
+    size_t nodes = firstLeaf + trapezoids;
+    for(Slab& slab : slabs){
+        slab.firstNode = nodes;
+        nodes += slab.kept.size();
+    }
+    T.resizeTrapezoids(trapezoids);
+    D.getdVector().resize(nodes);
+    D.getpVector().resize(T.getPointsSize());
+    D.getsVector().resize(T.getSegmentsSize());
+
+    parallelFor(k, threads, [&](size_t i){
+        Slab& slab = slabs[i];
+        for(size_t& id : slab.node){
+            if(id != SIZE_MAX){
+                id += slab.firstNode;
+            }
+        }
+    });
+
+    parallelFor(k, threads, [&](size_t i){
+        const Slab& slab = slabs[i];
+        //the trapezoids that start in the slab, their neighbors to the right are the ones of their last piece
+        for(size_t id : slab.starting){
+            size_t last = id, lastSlab = i;
+            while(slabs[lastSlab].next[last] != SIZE_MAX){
+                last = slabs[lastSlab].next[last];
+                lastSlab++;
+            }
+            const Trapezoid& a = slab.map.getTrapezoid(id);
+            const Trapezoid& b = slabs[lastSlab].map.getTrapezoid(last);
+            Trapezoid t = Trapezoid(globalPoint(slab, a.getLeftpId()), globalPoint(slabs[lastSlab], b.getRightpId()),
+                                    globalSegment(slab, a.getTopId()), globalSegment(slab, a.getBottomId()));
+            t.setNeighbor(TOP_LEFT, resolve(slabs, i, a.getNeighbor(TOP_LEFT)));
+            t.setNeighbor(BOTTOM_LEFT, resolve(slabs, i, a.getNeighbor(BOTTOM_LEFT)));
+            t.setNeighbor(TOP_RIGHT, resolve(slabs, lastSlab, b.getNeighbor(TOP_RIGHT)));
+            t.setNeighbor(BOTTOM_RIGHT, resolve(slabs, lastSlab, b.getNeighbor(BOTTOM_RIGHT)));
+            size_t g = slab.trapezoid[id];
+            t.setDagId(firstLeaf + g);
+            T.replaceTrapezoid(g, t);
+            D.replaceNode(firstLeaf + g, DagNode(TRAPEZOID, g));
+        }
+        //the inner nodes refer to the points and the segments of the whole map
+        for(size_t id : slab.kept){
+            const DagNode& n = slab.dag.getElementInDVector(id);
+            DagNode copy = DagNode(n.getNodeType(), n.getNodeType() == POINT ? globalPoint(slab, n.getEntityId()) :
+                                                                               globalSegment(slab, n.getEntityId()));
+            copy.setLeftc(childOf(slabs, i, n.getLeftC(), firstLeaf));
+            copy.setRightc(childOf(slabs, i, n.getRightC(), firstLeaf));
+            D.replaceNode(slab.node[id], copy);
+        }
+        //the geometry of the points and of the segments, every thread copies a range
+        for(size_t p = T.getPointsSize() * i / k; p < T.getPointsSize() * (i + 1) / k; p++){
+            D.setPoint(p, T.getPoint(p));
+        }
+        for(size_t s = T.getSegmentsSize() * i / k; s < T.getSegmentsSize() * (i + 1) / k; s++){
+            D.setSegment(s, T.getSegment(s));
+        }
+    });
+
+    size_t count = 0;
+    buildSlabTree(D, slabs, boundaries, 0, k - 1, firstLeaf, count);
+}
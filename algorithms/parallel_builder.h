@@ -0,0 +1,13 @@
+#ifndef PARALLEL_BUILDER_H
+#define PARALLEL_BUILDER_H
+
+#include "data_structures/trapezoidalmap.h"
+#include "data_structures/dag.h"
+
+namespace algorithms{
+
+    void parallelBuildTrapezoidalMap(TrapezoidalMap& T, Dag& D, const std::vector<cg3::Segment2d>& segments,
+                                     unsigned long seed, size_t threads = 0);
+}
+
+#endif // PARALLEL_BUILDER_H
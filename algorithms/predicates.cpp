@@ -0,0 +1,74 @@
+#include "predicates.h"
+
+#define PRODUCT_TERMS 6 // the products of two coordinates in the expansion of the orientation determinant
+
+namespace {
+
+/**
+ * @brief twoProduct
+ * Computes the product of two doubles as the rounded product and its rounding error, so that a * b = x + y exactly
+ */
+inline void twoProduct(double a, double b, double& x, double& y){
+    x = a * b;
+    y = std::fma(a, b, -x);
+}
+
+/**
+ * @brief twoSum
+ * Computes the sum of two doubles as the rounded sum and its rounding error, so that a + b = x + y exactly
+ */
+inline void twoSum(double a, double b, double& x, double& y){
+    x = a + b;
+    double bVirtual = x - a;
+    double aVirtual = x - bVirtual;
+    y = (a - aVirtual) + (b - bVirtual);
+}
+
+/**
+ * @brief growExpansion
+ * Adds a double to an expansion, a sum of doubles sorted by increasing magnitude that don't overlap.
+ * The zero components are removed, so the last component has the sign of the expansion.
+ * @param e the components of the expansion
+ * @param length the number of components
+ * @param b the double to add
+ * @param[out] h the components of the sum, at most length + 1, it can be e itself
+ * @return the number of components of the sum
+ */
+size_t growExpansion(const double * e, size_t length, double b, double * h){
+    double q = b;
+    size_t n = 0;
+    for(size_t i = 0; i < length; i++){
+        double sum, error;
+        twoSum(q, e[i], sum, error);
+        q = sum;
+        if(error != 0){
+            h[n++] = error;
+        }
+    }
+    if(q != 0 || n == 0){
+        h[n++] = q;
+    }
+    return n;
+}
+
+}
+
+/**
+ * @brief predicates::orientationExact
+ * This method computes the orientation determinant without rounding errors, as the expansion of the sum
+ * ax*by - ay*bx + bx*cy - by*cx + cx*ay - cy*ax, in which every product is split in two doubles.
+ * It is only called by orientation() when the floating point determinant is too small to be trusted.
+ * @return a value with the sign of the orientation of abc
+ */
+double predicates::orientationExact(double ax, double ay, double bx, double by, double cx, double cy){
+    const double factors[PRODUCT_TERMS][2] = {{ax, by}, {-ay, bx}, {bx, cy}, {-by, cx}, {cx, ay}, {-cy, ax}};
+    double expansion[2 * PRODUCT_TERMS];
+    size_t length = 0;
+    for(size_t i = 0; i < PRODUCT_TERMS; i++){
+        double product, error;
+        twoProduct(factors[i][0], factors[i][1], product, error);
+        length = growExpansion(expansion, length, error, expansion);
+        length = growExpansion(expansion, length, product, expansion);
+    }
+    return expansion[length - 1];
+}
@@ -0,0 +1,59 @@
+#ifndef PREDICATES_H
+#define PREDICATES_H
+
+#include <cg3/geometry/point2.h>
+#include <cfloat>
+#include <cmath>
+
+//the relative error bound of the floating point orientation, (3 + 16e)e with e = 2^-53 the unit roundoff
+#define ORIENTATION_ERROR_BOUND ((3.0 + 8.0 * DBL_EPSILON) * DBL_EPSILON / 2)
+
+namespace predicates{
+    double orientationExact(double ax, double ay, double bx, double by, double cx, double cy);
+
+    /**
+     * @brief predicates::orientation
+     * Twice the signed area of the triangle abc: positive if c is to the left of the line from a to b, negative if
+     * it is to the right, zero if the three points are aligned. The sign is always exact: the floating point
+     * determinant is returned when it is larger than its error bound, which is the common case, otherwise the
+     * determinant is computed without rounding errors. The coordinates must not overflow or underflow.
+     * @return a value with the sign of the orientation of abc
+     */
+    inline double orientation(double ax, double ay, double bx, double by, double cx, double cy){
+        double detleft = (ax - cx) * (by - cy);
+        double detright = (ay - cy) * (bx - cx);
+        double det = detleft - detright;
+        double detsum;
+        //when the two products have different signs the subtraction can't change the sign of the determinant
+        if(detleft > 0){
+            if(detright <= 0){
+                return det;
+            }
+            detsum = detleft + detright;
+        }
+        else if(detleft < 0){
+            if(detright >= 0){
+                return det;
+            }
+            detsum = -detleft - detright;
+        }
+        else{
+            return det;
+        }
+        if(std::abs(det) >= ORIENTATION_ERROR_BOUND * detsum){
+            return det;
+        }
+        return orientationExact(ax, ay, bx, by, cx, cy);
+    }
+
+    /**
+     * @brief predicates::orientation
+     * This override takes the three points
+     * @return a value with the sign of the orientation of abc
+     */
+    inline double orientation(const cg3::Point2d& a, const cg3::Point2d& b, const cg3::Point2d& c){
+        return orientation(a.x(), a.y(), b.x(), b.y(), c.x(), c.y());
+    }
+}
+
+#endif // PREDICATES_H
@@ -0,0 +1,118 @@
+#include "query_executor.h"
+#include "algorithms.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <new>
+#include <thread>
+
+#define QUERY_CHUNK 4096 // the number of points located together by a thread
+#define CACHE_LINE 64    // the size of a cache line, used to keep the queues of the threads apart
+
+namespace {
+
+/**
+ * @brief The ChunkQueue struct
+ * The queue of chunks assigned to a thread. The owner and the thieves take chunks from the same atomic
+ * cursor, so every chunk is processed exactly once. Every queue is aligned to its own cache line, so the
+ * cursors of different threads don't share one.
+ */
+struct alignas(CACHE_LINE) ChunkQueue{
+    std::atomic<size_t> next;
+    size_t end;
+};
+
+}
+
+/**
+ * @brief algorithms::QueryThreadStats::throughput
+ * @return the number of points located per second by the thread
+ */
+double algorithms::QueryThreadStats::throughput() const{
+    return seconds > 0 ? queries / seconds : 0;
+}
+
+/**
+ * @brief algorithms::parallelQueryPoints
+ * This method locates a batch of points on several threads. The batch is divided in chunks and every thread
+ * receives a contiguous range of chunks, which it locates with the batch query. When a thread empties its own
+ * queue it steals the remaining chunks from the queues of the other threads, so the threads stay busy even
+ * when some regions of the map are deeper than others.
+ * @param snapshot the frozen trapezoidal map, shared by all the threads
+ * @param points the query points
+ * @param[out] out the ids of the trapezoids containing the points, in the same order of the input
+ * @param threads the number of threads to use, 0 to use all the cores of the machine
+ * @param[out] stats the statistics of every thread
+ */
+void algorithms::parallelQueryPoints(const TrapezoidalMapSnapshot& snapshot, const std::vector<cg3::Point2d>& points,
+                                     std::vector<size_t>& out, size_t threads, std::vector<QueryThreadStats>& stats){
+    if(threads == 0){
+        threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+    }
+    out.resize(points.size());
+
+    size_t chunks = (points.size() + QUERY_CHUNK - 1) / QUERY_CHUNK;
+    threads = std::max<size_t>(1, std::min(threads, chunks));
+    stats.assign(threads, QueryThreadStats());
+
+    //every thread receives the same number of chunks. new doesn't align beyond the alignment of the fundamental
+    //types before C++17, so the queues are placed at the first cache line boundary of a buffer one line longer
+    size_t space = (threads + 1) * sizeof(ChunkQueue);
+    std::unique_ptr<char[]> storage(new char[space]);
+    void * base = storage.get();
+    ChunkQueue * queues = static_cast<ChunkQueue*>(std::align(alignof(ChunkQueue), threads * sizeof(ChunkQueue), base, space));
+    for(size_t t = 0; t < threads; t++){
+        new (&queues[t]) ChunkQueue();
+        queues[t].next = chunks * t / threads;
+        queues[t].end = chunks * (t + 1) / threads;
+    }
+
+    const PackedDag& dag = snapshot.getPackedDag();
+    auto worker = [&](size_t id){
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        QueryThreadStats& s = stats[id];
+        for(size_t i = 0; i < threads; i++){
+            size_t victim = (id + i) % threads; //the own queue first, then the queues of the others
+            while(true){
+                size_t chunk = queues[victim].next.fetch_add(1);
+                if(chunk >= queues[victim].end){
+                    break;
+                }
+                size_t begin = chunk * QUERY_CHUNK;
+                size_t end = std::min(points.size(), begin + QUERY_CHUNK);
+                queryPoints(dag, points, begin, end, out);
+                s.queries += end - begin;
+                s.chunks++;
+                if(victim != id){
+                    s.stolenChunks++;
+                }
+            }
+        }
+        s.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    std::vector<std::thread> pool;
+    for(size_t t = 1; t < threads; t++){
+        pool.push_back(std::thread(worker, t));
+    }
+    worker(0); //the calling thread works as well
+    for(std::thread& t : pool){
+        t.join();
+    }
+}
+
+/**
+ * @brief algorithms::parallelQueryPoints
+ * This override locates a batch of points on several threads without collecting the statistics
+ * @param snapshot the frozen trapezoidal map, shared by all the threads
+ * @param points the query points
+ * @param[out] out the ids of the trapezoids containing the points, in the same order of the input
+ * @param threads the number of threads to use, 0 to use all the cores of the machine
+ */
+void algorithms::parallelQueryPoints(const TrapezoidalMapSnapshot& snapshot, const std::vector<cg3::Point2d>& points,
+                                     std::vector<size_t>& out, size_t threads){
+    std::vector<QueryThreadStats> stats;
+    parallelQueryPoints(snapshot, points, out, threads, stats);
+}
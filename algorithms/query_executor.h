@@ -0,0 +1,27 @@
+#ifndef QUERY_EXECUTOR_H
+#define QUERY_EXECUTOR_H
+
+#include "data_structures/trapezoidalmap_snapshot.h"
+
+namespace algorithms{
+
+    /**
+     * @brief The QueryThreadStats struct
+     * The statistics collected by a thread of the parallel query executor
+     */
+    struct QueryThreadStats{
+        size_t queries = 0;      //the number of points located by the thread
+        size_t chunks = 0;       //the number of chunks processed by the thread
+        size_t stolenChunks = 0; //the number of chunks taken from the queue of another thread
+        double seconds = 0;      //the time spent by the thread
+
+        double throughput() const;
+    };
+
+    void parallelQueryPoints(const TrapezoidalMapSnapshot& snapshot, const std::vector<cg3::Point2d>& points,
+                             std::vector<size_t>& out, size_t threads, std::vector<QueryThreadStats>& stats);
+    void parallelQueryPoints(const TrapezoidalMapSnapshot& snapshot, const std::vector<cg3::Point2d>& points,
+                             std::vector<size_t>& out, size_t threads = 0);
+}
+
+#endif // QUERY_EXECUTOR_H
@@ -0,0 +1,288 @@
+#include "range_queries.h"
+#include "algorithms.h"
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+#include <unordered_set>
+
+#define TOP_RIGHT 1
+#define BOTTOM_RIGHT 3
+#define CROSSED_UP 1    // the trapezoids above the segment have been reached from below
+#define CROSSED_DOWN 2  // the trapezoids below the segment have been reached from above
+
+namespace {
+
+/**
+ * @brief restrictRange
+ * Restricts the range [lo, hi] to the part in which a linear function is not positive
+ * @param flo the value of the function at lo
+ * @param fhi the value of the function at hi
+ * @param[in,out] lo the beginning of the range
+ * @param[in,out] hi the end of the range
+ * @return false if the function is positive in the whole range
+ */
+bool restrictRange(double flo, double fhi, double& lo, double& hi){
+    if(flo <= 0 && fhi <= 0){
+        return true;
+    }
+    if(flo > 0 && fhi > 0){
+        return false;
+    }
+    double x = lo + (hi - lo) * flo / (flo - fhi);
+    if(flo > 0){
+        lo = x;
+    }
+    else{
+        hi = x;
+    }
+    return true;
+}
+
+/**
+ * @brief clipSegment
+ * Restricts an x range to the part in which a segment is inside the window
+ * @param s the segment, it must span the whole range
+ * @param window the window
+ * @param[in,out] lo the beginning of the range, already inside the window
+ * @param[in,out] hi the end of the range, already inside the window
+ * @return false if the segment is outside the window in the whole range
+ */
+bool clipSegment(const cg3::Segment2d& s, const cg3::BoundingBox2& window, double& lo, double& hi){
+    if(!restrictRange(utility::yAtX(s, lo) - window.max().y(), utility::yAtX(s, hi) - window.max().y(), lo, hi)){
+        return false;
+    }
+    return restrictRange(window.min().y() - utility::yAtX(s, lo), window.min().y() - utility::yAtX(s, hi), lo, hi);
+}
+
+/**
+ * @brief clipTrapezoid
+ * Computes the x range of a trapezoid inside the window. The trapezoid and the window are closed, so a trapezoid
+ * that only touches the window intersects it.
+ * @param T the trapezoidal map
+ * @param t the trapezoid
+ * @param window the window
+ * @param[out] lo the beginning of the range
+ * @param[out] hi the end of the range
+ * @return true if the trapezoid intersects the window
+ */
+bool clipTrapezoid(const TrapezoidalMap& T, const Trapezoid& t, const cg3::BoundingBox2& window, double& lo, double& hi){
+    lo = std::max(T.getLeftp(t).x(), window.min().x());
+    hi = std::min(T.getRightp(t).x(), window.max().x());
+    if(lo > hi){
+        return false;
+    }
+    //the bottom must be below the top of the window and the top above the bottom of the window at the same x
+    const cg3::Segment2d& top = T.getSegment(t.getTopId());
+    const cg3::Segment2d& bottom = T.getSegment(t.getBottomId());
+    if(!restrictRange(utility::yAtX(bottom, lo) - window.max().y(), utility::yAtX(bottom, hi) - window.max().y(), lo, hi)){
+        return false;
+    }
+    return restrictRange(window.min().y() - utility::yAtX(top, lo), window.min().y() - utility::yAtX(top, hi), lo, hi);
+}
+
+/**
+ * @brief locateBeside
+ * Locates the trapezoid above or below a segment at the given x, by walking the dag with the point of the segment
+ * and choosing the side at the node of the segment
+ * @param D the dag
+ * @param segment the segment
+ * @param s the id of the segment
+ * @param x the x coordinate, inside the segment
+ * @param above true for the trapezoid above the segment, false for the one below it
+ * @return the id of the trapezoid
+ */
+size_t locateBeside(const Dag& D, const cg3::Segment2d& segment, size_t s, double x, bool above){
+    cg3::Point2d p(x, utility::yAtX(segment, x));
+    const DagNode * d = &D.getElementInDVector(0);
+    while(d->getNodeType() != TRAPEZOID){
+        bool left;
+        if(d->getNodeType() == POINT){
+            left = p.x() < D.getElementInPVector(d->getEntityId()).x();
+        }
+        else if(d->getEntityId() == s){
+            left = above;
+        }
+        else{
+            left = utility::isAbove(D.getElementInSVector(d->getEntityId()), p);
+        }
+        d = &D.getElementInDVector(left ? d->getLeftC() : d->getRightC());
+    }
+    return d->getEntityId();
+}
+
+/**
+ * @brief locateStart
+ * Locates the trapezoid in which a query segment starts. When the first endpoint lies on a segment of the map,
+ * the query segment starts on the side of its second endpoint.
+ * @param D the dag
+ * @param a the first endpoint of the query segment
+ * @param b the second endpoint of the query segment
+ * @return the id of the trapezoid
+ */
+size_t locateStart(const Dag& D, const cg3::Point2d& a, const cg3::Point2d& b){
+    const DagNode * d = &D.getElementInDVector(0);
+    while(d->getNodeType() != TRAPEZOID){
+        bool left;
+        if(d->getNodeType() == POINT){
+            left = a.x() < D.getElementInPVector(d->getEntityId()).x();
+        }
+        else{
+            const cg3::Segment2d& s = D.getElementInSVector(d->getEntityId());
+            left = utility::isAbove(s, a) || (!utility::isBelow(s, a) && utility::isAbove(s, b));
+        }
+        d = &D.getElementInDVector(left ? d->getLeftC() : d->getRightC());
+    }
+    return d->getEntityId();
+}
+
+}
+
+/**
+ * @brief algorithms::windowQuery
+ * This method finds the trapezoids and the segments that intersect a window. It locates a corner of the window
+ * and visits the trapezoids inside the window through their neighbors. The neighbors only connect the trapezoids
+ * through their walls, so the trapezoids on the other side of a segment are located in the dag the first time the
+ * segment is reached from that side: the trapezoids along a segment inside the window are then connected by their
+ * neighbors. The cost is proportional to the output, with a point location for every side of a segment.
+ * @param T the trapezoidal map
+ * @param D the dag of the map
+ * @param window the window, the trapezoids and the segments that touch its boundary intersect it
+ * @param[out] trapezoids the ids of the trapezoids intersecting the window, in increasing order
+ * @param[out] segments the ids of the segments intersecting the window, in increasing order
+ */
+void algorithms::windowQuery(const TrapezoidalMap& T, const Dag& D, const cg3::BoundingBox2& window,
+                             std::vector<size_t>& trapezoids, std::vector<size_t>& segments){
+    trapezoids.clear();
+    segments.clear();
+    std::unordered_set<size_t> visited;
+    std::unordered_map<size_t, char> crossed; //the sides from which every segment in the window has been crossed
+    std::vector<size_t> stack;
+    double lo, hi;
+    auto visit = [&](size_t t){
+        if(t != SIZE_MAX && clipTrapezoid(T, T.getTrapezoid(t), window, lo, hi) && visited.insert(t).second){
+            stack.push_back(t);
+        }
+    };
+
+    //the corner is moved inside the bounding box, so that a window larger than the box is located too
+    cg3::Point2d corner(std::max(-BOUNDINGBOX, std::min(BOUNDINGBOX, window.min().x())),
+                        std::max(-BOUNDINGBOX, std::min(BOUNDINGBOX, window.min().y())));
+    visit(queryTrapezoid(D, corner));
+    while(!stack.empty()){
+        const Trapezoid& t = T.getTrapezoid(stack.back());
+        stack.pop_back();
+        trapezoids.push_back(t.getId());
+        for(size_t i = 0; i < 4; i++){
+            visit(t.getNeighbor(i));
+        }
+        for(bool up : {true, false}){
+            size_t s = up ? t.getTopId() : t.getBottomId();
+            if(s == BOUNDINGBOX_TOP || s == BOUNDINGBOX_BOTTOM){
+                continue;
+            }
+            const cg3::Segment2d& segment = T.getSegment(s);
+            clipTrapezoid(T, t, window, lo, hi);
+            if(!clipSegment(segment, window, lo, hi)){
+                continue;
+            }
+            char& sides = crossed[s];
+            if(sides == 0){
+                segments.push_back(s);
+            }
+            char side = up ? CROSSED_UP : CROSSED_DOWN;
+            if(!(sides & side)){
+                sides |= side;
+                visit(locateBeside(D, segment, s, (lo + hi) / 2, up));
+            }
+        }
+    }
+    std::sort(trapezoids.begin(), trapezoids.end());
+    std::sort(segments.begin(), segments.end());
+}
+
+/**
+ * @brief algorithms::stabSegment
+ * This method finds the trapezoids crossed by a query segment, which is not in the map and can cross its segments.
+ * Like followSegment(), it locates the left endpoint and walks to the right through the neighbors; when the query
+ * segment crosses the top or the bottom of a trapezoid, the trapezoid on the other side is located in the dag,
+ * since the neighbors only connect the trapezoids through their walls. A vertical query segment is walked upwards.
+ * The cost is O(log n + k), plus a point location for every crossed segment, and the only memory used is the output.
+ * @param T the trapezoidal map
+ * @param D the dag of the map
+ * @param query the query segment, its endpoints can be in any order and inside the trapezoids
+ * @param[out] trapezoids the ids of the crossed trapezoids, from the left (or the lower) endpoint to the other one
+ * @param[out] segments the ids of the crossed segments of the map, in the same order
+ */
+void algorithms::stabSegment(const TrapezoidalMap& T, const Dag& D, const cg3::Segment2d& query,
+                             std::vector<size_t>& trapezoids, std::vector<size_t>& segments){
+    trapezoids.clear();
+    segments.clear();
+    bool forward = query.p1().x() < query.p2().x() || (query.p1().x() == query.p2().x() && query.p1().y() <= query.p2().y());
+    cg3::Point2d a = forward ? query.p1() : query.p2();
+    cg3::Point2d b = forward ? query.p2() : query.p1();
+    bool vertical = a.x() == b.x();
+
+    //the query segment is clipped to the bounding box, the parts outside it don't cross any trapezoid
+    if(vertical){
+        if(std::abs(a.x()) > BOUNDINGBOX || a.y() > BOUNDINGBOX || b.y() < -BOUNDINGBOX){
+            return;
+        }
+        a.setYCoord(std::max(a.y(), -BOUNDINGBOX));
+        b.setYCoord(std::min(b.y(), BOUNDINGBOX));
+    }
+    else{
+        double lo = std::max(a.x(), -BOUNDINGBOX), hi = std::min(b.x(), BOUNDINGBOX);
+        const cg3::Segment2d line(a, b);
+        if(lo > hi || !clipSegment(line, cg3::BoundingBox2(cg3::Point2d(-BOUNDINGBOX, -BOUNDINGBOX), cg3::Point2d(BOUNDINGBOX, BOUNDINGBOX)), lo, hi)){
+            return;
+        }
+        a = cg3::Point2d(lo, utility::yAtX(line, lo));
+        b = cg3::Point2d(hi, utility::yAtX(line, hi));
+    }
+    const cg3::Segment2d oriented(a, b);
+
+    size_t t = locateStart(D, a, b);
+    size_t entered = SIZE_MAX;  //the segment crossed to enter the trapezoid, it is not crossed again
+    double x = a.x();           //the x coordinate at which the query segment enters the trapezoid
+    while(true){
+        trapezoids.push_back(t);
+        const Trapezoid& trapezoid = T.getTrapezoid(t);
+        const cg3::Point2d& rightp = T.getRightp(trapezoid);
+        double end = std::min(b.x(), rightp.x());
+        cg3::Point2d exit = vertical ? b : cg3::Point2d(end, a.y() + (b.y() - a.y()) * (end - a.x()) / (b.x() - a.x()));
+
+        //the query segment leaves the trapezoid through its top or its bottom before the end of the slab
+        bool up = trapezoid.getTopId() != entered && trapezoid.getTopId() != BOUNDINGBOX_TOP &&
+                  utility::isAbove(T.getSegment(trapezoid.getTopId()), exit);
+        bool down = !up && trapezoid.getBottomId() != entered && trapezoid.getBottomId() != BOUNDINGBOX_BOTTOM &&
+                    utility::isBelow(T.getSegment(trapezoid.getBottomId()), exit);
+        if(up || down){
+            size_t s = up ? trapezoid.getTopId() : trapezoid.getBottomId();
+            const cg3::Segment2d& segment = T.getSegment(s);
+            if(!vertical){
+                //the crossing is where the vertical distance between the two segments changes sign
+                double yx = a.y() + (b.y() - a.y()) * (x - a.x()) / (b.x() - a.x());
+                double before = yx - utility::yAtX(segment, x);
+                double after = exit.y() - utility::yAtX(segment, end);
+                x += (end - x) * before / (before - after);
+            }
+            segments.push_back(s);
+            entered = s;
+            t = locateBeside(D, segment, s, x, up);
+            continue;
+        }
+        if(vertical || b.x() <= rightp.x()){
+            break;
+        }
+
+        //the query segment crosses the right wall above or below rightp, like in followSegment()
+        size_t next = utility::isAbove(oriented, rightp) ? trapezoid.getNeighbor(BOTTOM_RIGHT) : trapezoid.getNeighbor(TOP_RIGHT);
+        if(next == SIZE_MAX){
+            break;
+        }
+        entered = SIZE_MAX;
+        x = rightp.x();
+        t = next;
+    }
+}
@@ -0,0 +1,16 @@
+#ifndef RANGE_QUERIES_H
+#define RANGE_QUERIES_H
+
+#include "data_structures/trapezoidalmap.h"
+#include "data_structures/dag.h"
+#include <cg3/geometry/bounding_box2.h>
+
+namespace algorithms{
+
+    void windowQuery(const TrapezoidalMap& T, const Dag& D, const cg3::BoundingBox2& window,
+                     std::vector<size_t>& trapezoids, std::vector<size_t>& segments);
+    void stabSegment(const TrapezoidalMap& T, const Dag& D, const cg3::Segment2d& query,
+                     std::vector<size_t>& trapezoids, std::vector<size_t>& segments);
+}
+
+#endif // RANGE_QUERIES_H
@@ -0,0 +1,261 @@
+#include "simd_predicates.h"
+#include "predicates.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+#define SIMD_MIN_POINTS 64 // the shorter ranges use the scalar kernels, the vector ones don't pay off on them
+
+//the vector kernels are compiled with the target attribute of GCC and Clang, the other compilers use the scalar ones
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define PREDICATES_X86
+#include <immintrin.h>
+#endif
+
+namespace {
+
+std::atomic<int> activeLevel(-1); //the level used by the kernels, -1 until it is detected
+
+/**
+ * @brief classifyXScalar
+ * Compares the x coordinates of the points with x, one point at a time
+ */
+void classifyXScalar(double x, const double * xs, size_t n, unsigned char * side){
+    for(size_t i = 0; i < n; i++){
+        side[i] = xs[i] < x ? SIDE_LEFT : SIDE_RIGHT;
+    }
+}
+
+/**
+ * @brief classifyAboveScalar
+ * Computes the side of the points with respect to the segment from (x1, y1) to (x2, y2), one point at a time.
+ * It is the floating point stage of predicates::orientation(): a point is SIDE_UNSURE when the determinant is
+ * zero or smaller than its error bound.
+ */
+void classifyAboveScalar(double x1, double y1, double x2, double y2, const double * xs, const double * ys, size_t n, unsigned char * side){
+    for(size_t i = 0; i < n; i++){
+        double detleft = (x1 - xs[i]) * (y2 - ys[i]);
+        double detright = (y1 - ys[i]) * (x2 - xs[i]);
+        double det = detleft - detright;
+        if(std::abs(det) > ORIENTATION_ERROR_BOUND * (std::abs(detleft) + std::abs(detright))){
+            side[i] = det > 0 ? SIDE_LEFT : SIDE_RIGHT;
+        }
+        else{
+            side[i] = SIDE_UNSURE;
+        }
+    }
+}
+
+#ifdef PREDICATES_X86
+
+//the bytes of the sides of a group of points, one byte set to 1 for every bit of the mask of a vector comparison
+const uint16_t spread2[4] = {0x0000, 0x0001, 0x0100, 0x0101};
+const uint32_t spread4[16] = {0x00000000, 0x00000001, 0x00000100, 0x00000101, 0x00010000, 0x00010001, 0x00010100, 0x00010101,
+                              0x01000000, 0x01000001, 0x01000100, 0x01000101, 0x01010000, 0x01010001, 0x01010100, 0x01010101};
+
+#ifdef __SSE2__
+/**
+ * @brief classifyXSse2
+ * Compares the x coordinates of two points at a time with x
+ */
+void classifyXSse2(double x, const double * xs, size_t n, unsigned char * side){
+    const __m128d vx = _mm_set1_pd(x);
+    size_t i = 0;
+    for(; i + 2 <= n; i += 2){
+        int left = _mm_movemask_pd(_mm_cmplt_pd(_mm_loadu_pd(xs + i), vx));
+        std::memcpy(side + i, &spread2[left], 2);
+    }
+    classifyXScalar(x, xs + i, n - i, side + i);
+}
+
+/**
+ * @brief classifyAboveSse2
+ * Computes the side of two points at a time with respect to the segment, like classifyAboveScalar()
+ */
+void classifyAboveSse2(double x1, double y1, double x2, double y2, const double * xs, const double * ys, size_t n, unsigned char * side){
+    const __m128d ax = _mm_set1_pd(x1), ay = _mm_set1_pd(y1), bx = _mm_set1_pd(x2), by = _mm_set1_pd(y2);
+    const __m128d bound = _mm_set1_pd(ORIENTATION_ERROR_BOUND);
+    const __m128d sign = _mm_set1_pd(-0.0);
+    size_t i = 0;
+    for(; i + 2 <= n; i += 2){
+        __m128d cx = _mm_loadu_pd(xs + i), cy = _mm_loadu_pd(ys + i);
+        __m128d detleft = _mm_mul_pd(_mm_sub_pd(ax, cx), _mm_sub_pd(by, cy));
+        __m128d detright = _mm_mul_pd(_mm_sub_pd(ay, cy), _mm_sub_pd(bx, cx));
+        __m128d det = _mm_sub_pd(detleft, detright);
+        __m128d detsum = _mm_add_pd(_mm_andnot_pd(sign, detleft), _mm_andnot_pd(sign, detright));
+        int sure = _mm_movemask_pd(_mm_cmpgt_pd(_mm_andnot_pd(sign, det), _mm_mul_pd(bound, detsum)));
+        int above = _mm_movemask_pd(_mm_cmpgt_pd(det, _mm_setzero_pd()));
+        uint16_t sides = spread2[above & sure] + SIDE_UNSURE * spread2[~sure & 3];
+        std::memcpy(side + i, &sides, 2);
+    }
+    classifyAboveScalar(x1, y1, x2, y2, xs + i, ys + i, n - i, side + i);
+}
+#endif
+
+/**
+ * @brief classifyXAvx2
+ * Compares the x coordinates of four points at a time with x
+ */
+__attribute__((target("avx2")))
+void classifyXAvx2(double x, const double * xs, size_t n, unsigned char * side){
+    const __m256d vx = _mm256_set1_pd(x);
+    size_t i = 0;
+    for(; i + 4 <= n; i += 4){
+        int left = _mm256_movemask_pd(_mm256_cmp_pd(_mm256_loadu_pd(xs + i), vx, _CMP_LT_OQ));
+        std::memcpy(side + i, &spread4[left], 4);
+    }
+    classifyXScalar(x, xs + i, n - i, side + i);
+}
+
+/**
+ * @brief classifyAboveAvx2
+ * Computes the side of four points at a time with respect to the segment, like classifyAboveScalar()
+ */
+__attribute__((target("avx2")))
+void classifyAboveAvx2(double x1, double y1, double x2, double y2, const double * xs, const double * ys, size_t n, unsigned char * side){
+    const __m256d ax = _mm256_set1_pd(x1), ay = _mm256_set1_pd(y1), bx = _mm256_set1_pd(x2), by = _mm256_set1_pd(y2);
+    const __m256d bound = _mm256_set1_pd(ORIENTATION_ERROR_BOUND);
+    const __m256d sign = _mm256_set1_pd(-0.0);
+    size_t i = 0;
+    for(; i + 4 <= n; i += 4){
+        __m256d cx = _mm256_loadu_pd(xs + i), cy = _mm256_loadu_pd(ys + i);
+        __m256d detleft = _mm256_mul_pd(_mm256_sub_pd(ax, cx), _mm256_sub_pd(by, cy));
+        __m256d detright = _mm256_mul_pd(_mm256_sub_pd(ay, cy), _mm256_sub_pd(bx, cx));
+        __m256d det = _mm256_sub_pd(detleft, detright);
+        __m256d detsum = _mm256_add_pd(_mm256_andnot_pd(sign, detleft), _mm256_andnot_pd(sign, detright));
+        int sure = _mm256_movemask_pd(_mm256_cmp_pd(_mm256_andnot_pd(sign, det), _mm256_mul_pd(bound, detsum), _CMP_GT_OQ));
+        int above = _mm256_movemask_pd(_mm256_cmp_pd(det, _mm256_setzero_pd(), _CMP_GT_OQ));
+        uint32_t sides = spread4[above & sure] + SIDE_UNSURE * spread4[~sure & 15];
+        std::memcpy(side + i, &sides, 4);
+    }
+    classifyAboveScalar(x1, y1, x2, y2, xs + i, ys + i, n - i, side + i);
+}
+
+#endif
+
+/**
+ * @brief currentLevel
+ * @return the level used by the kernels, the best supported one unless another one has been set
+ */
+inline simdLevel currentLevel(){
+    int level = activeLevel.load(std::memory_order_relaxed);
+    if(level < 0){
+        level = predicates::getSupportedSimdLevel();
+        activeLevel.store(level, std::memory_order_relaxed);
+    }
+    return simdLevel(level);
+}
+
+}
+
+/**
+ * @brief predicates::classifyX
+ * This method compares the x coordinates of a range of points with the x of a POINT node: the points to the
+ * left of x get SIDE_LEFT, the others SIDE_RIGHT. The points are compared several at a time with the
+ * instruction set chosen at runtime.
+ * @param x the x coordinate of the point of the node
+ * @param xs the x coordinates of the points
+ * @param n the number of points
+ * @param[out] side the side of every point
+ */
+void predicates::classifyX(double x, const double * xs, size_t n, unsigned char * side){
+    switch(n < SIMD_MIN_POINTS ? SIMD_SCALAR : currentLevel()){
+#ifdef PREDICATES_X86
+        case SIMD_AVX2:
+            classifyXAvx2(x, xs, n, side);
+        break;
+#ifdef __SSE2__
+        case SIMD_SSE2:
+            classifyXSse2(x, xs, n, side);
+        break;
+#endif
+#endif
+        default:
+            classifyXScalar(x, xs, n, side);
+        break;
+    }
+}
+
+/**
+ * @brief predicates::classifyAbove
+ * This method computes the side of a range of points with respect to the segment of a SEGMENT node, with the
+ * floating point filter of predicates::orientation(): the points above the segment get SIDE_LEFT, the points
+ * below it SIDE_RIGHT. The points on the line of the segment and the ones too close to it for the filter get
+ * SIDE_UNSURE, and the caller decides them with the scalar exact predicate and its tie-break.
+ * @param x1 the x coordinate of the left endpoint of the segment
+ * @param y1 the y coordinate of the left endpoint of the segment
+ * @param x2 the x coordinate of the right endpoint of the segment
+ * @param y2 the y coordinate of the right endpoint of the segment
+ * @param xs the x coordinates of the points
+ * @param ys the y coordinates of the points
+ * @param n the number of points
+ * @param[out] side the side of every point
+ */
+void predicates::classifyAbove(double x1, double y1, double x2, double y2, const double * xs, const double * ys, size_t n, unsigned char * side){
+    switch(n < SIMD_MIN_POINTS ? SIMD_SCALAR : currentLevel()){
+#ifdef PREDICATES_X86
+        case SIMD_AVX2:
+            classifyAboveAvx2(x1, y1, x2, y2, xs, ys, n, side);
+        break;
+#ifdef __SSE2__
+        case SIMD_SSE2:
+            classifyAboveSse2(x1, y1, x2, y2, xs, ys, n, side);
+        break;
+#endif
+#endif
+        default:
+            classifyAboveScalar(x1, y1, x2, y2, xs, ys, n, side);
+        break;
+    }
+}
+
+/**
+ * @brief predicates::getSupportedSimdLevel
+ * @return the best instruction set of the kernels supported by the processor
+ */
+simdLevel predicates::getSupportedSimdLevel(){
+#ifdef PREDICATES_X86
+    if(__builtin_cpu_supports("avx2")){
+        return SIMD_AVX2;
+    }
+#ifdef __SSE2__
+    return SIMD_SSE2;
+#endif
+#endif
+    return SIMD_SCALAR;
+}
+
+/**
+ * @brief predicates::getSimdLevel
+ * @return the instruction set used by the kernels
+ */
+simdLevel predicates::getSimdLevel(){
+    return currentLevel();
+}
+
+/**
+ * @brief predicates::setSimdLevel
+ * This method chooses the instruction set of the kernels, e.g. to compare them in the benchmark.
+ * A level that is not supported by the processor is lowered to the best supported one.
+ * @param level the instruction set
+ */
+void predicates::setSimdLevel(simdLevel level){
+    activeLevel.store(std::min(level, getSupportedSimdLevel()), std::memory_order_relaxed);
+}
+
+/**
+ * @brief predicates::getSimdLevelName
+ * @return the name of the instruction set, as written in the JSON of the benchmark
+ */
+const char * predicates::getSimdLevelName(simdLevel level){
+    switch(level){
+        case SIMD_AVX2:
+            return "avx2";
+        case SIMD_SSE2:
+            return "sse2";
+        default:
+            return "scalar";
+    }
+}
@@ -0,0 +1,24 @@
+#ifndef SIMD_PREDICATES_H
+#define SIMD_PREDICATES_H
+
+#include <cstddef>
+
+//the sides computed by the predicate kernels for a point against a node of the dag
+#define SIDE_RIGHT 0   // the point goes to the right child: it is to the right of the x or below the segment
+#define SIDE_LEFT 1    // the point goes to the left child: it is to the left of the x or above the segment
+#define SIDE_UNSURE 2  // the point is on the line of the segment, or too close to decide: the scalar predicate decides
+
+//the instruction sets of the predicate kernels, the best one supported by the processor is chosen at runtime
+enum simdLevel {SIMD_SCALAR, SIMD_SSE2, SIMD_AVX2};
+
+namespace predicates{
+    void classifyX(double x, const double * xs, size_t n, unsigned char * side);
+    void classifyAbove(double x1, double y1, double x2, double y2, const double * xs, const double * ys, size_t n, unsigned char * side);
+
+    simdLevel getSupportedSimdLevel();
+    simdLevel getSimdLevel();
+    void setSimdLevel(simdLevel level);
+    const char * getSimdLevelName(simdLevel level);
+}
+
+#endif // SIMD_PREDICATES_H
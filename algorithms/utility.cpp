@@ -1,4 +1,5 @@
 #include "utility.h"
+#include "predicates.h"
 /**
  * @brief algorithms::isAbove
  * This method checks if a point p is Above a segment s
@@ -6,29 +7,61 @@
  * @param p the point to check
  * @return true if the point is above the segment, false otherwise
  */
-bool utility::isAbove(cg3::Segment2d s, cg3::Point2d p){
-    double v1[] {s.p2().x() - s.p1().x(), s.p2().y() - s.p1().y()};
-    double v2[] = {s.p2().x()-p.x(), s.p2().y() -p.y()};
-    double xp = v1[0]*v2[1] - v1[1]*v2[0]; //prodotto scalare
-    if (xp < 0){
-        return true;
-    }
-    else{
-        return false;
-    }
+bool utility::isAbove(const cg3::Segment2d& s, const cg3::Point2d& p){
+    return isAbove(s.p1().x(), s.p1().y(), s.p2().x(), s.p2().y(), p.x(), p.y());
+}
 
+/**
+ * @brief utility::isAbove
+ * This override checks if a point is above a segment given by the coordinates of its endpoints.
+ * It is used by the structures that don't store cg3::Segment2d objects.
+ * @param x1 the x coordinate of the first endpoint of the segment
+ * @param y1 the y coordinate of the first endpoint of the segment
+ * @param x2 the x coordinate of the second endpoint of the segment
+ * @param y2 the y coordinate of the second endpoint of the segment
+ * @param px the x coordinate of the point
+ * @param py the y coordinate of the point
+ * @return true if the point is above the segment, false otherwise
+ */
+bool utility::isAbove(double x1, double y1, double x2, double y2, double px, double py){
+    return predicates::orientation(x1, y1, x2, y2, px, py) > 0;
 }
 
-bool utility::pointEqual(cg3::Point2d p1, cg3::Point2d p2){
-    return (fabs(p1.x() - p2.x()) < 0.005f  && fabs(p1.y() - p2.y()) < 0.005f);
+/**
+ * @brief utility::isBelow
+ * This method checks if a point p is below a segment s. Like isAbove, a point on the segment is not below it
+ * @param s the segment to check
+ * @param p the point to check
+ * @return true if the point is below the segment, false otherwise
+ */
+bool utility::isBelow(const cg3::Segment2d& s, const cg3::Point2d& p){
+    return predicates::orientation(s.p1(), s.p2(), p) < 0;
 }
 
+bool utility::pointEqual(const cg3::Point2d& p1, const cg3::Point2d& p2){
+    return pointEqual(p1.x(), p1.y(), p2.x(), p2.y());
+}
 
-float utility::slope(cg3::Point2d p1, cg3::Point2d p2){
-    cg3::Line2 slope_line = cg3::Line2(p1,p2);
-    return slope_line.m();
+/**
+ * @brief utility::pointEqual
+ * This override checks if two points given by their coordinates are the same point. The comparison is exact:
+ * the map stores every point once, so the endpoints shared by two segments have the same coordinates
+ * @return true if the two points have the same coordinates
+ */
+bool utility::pointEqual(double x1, double y1, double x2, double y2){
+    return x1 == x2 && y1 == y2;
 }
 
-float utility::slope(cg3::Segment2d s){
-    return slope(s.p1(),s.p2());
+/**
+ * @brief utility::yAtX
+ * This method computes the y coordinate of the point of the line through the segment with the given x coordinate
+ * @param s a non vertical segment, oriented from left to right
+ * @param x the x coordinate of the point
+ * @return the y coordinate of the point, the y of an endpoint if x is the x of that endpoint
+ */
+double utility::yAtX(const cg3::Segment2d& s, double x){
+    if(x == s.p2().x()){
+        return s.p2().y();
+    }
+    return s.p1().y() + (s.p2().y() - s.p1().y()) * (x - s.p1().x()) / (s.p2().x() - s.p1().x());
 }
@@ -3,14 +3,15 @@
 
 #include <cg3/geometry/point2.h>
 #include <cg3/geometry/segment2.h>
-#include "cg3/geometry/line2.h"
 
 namespace utility{
-    bool isAbove(cg3::Segment2d s, cg3::Point2d p);
-    bool pointEqual(cg3::Point2d p1, cg3::Point2d p2);
+    bool isAbove(const cg3::Segment2d& s, const cg3::Point2d& p);
+    bool isAbove(double x1, double y1, double x2, double y2, double px, double py);
+    bool isBelow(const cg3::Segment2d& s, const cg3::Point2d& p);
+    bool pointEqual(const cg3::Point2d& p1, const cg3::Point2d& p2);
+    bool pointEqual(double x1, double y1, double x2, double y2);
     bool segmentGoesUp(cg3::Point2d p1, cg3::Point2d p2);
-    float slope(cg3::Point2d p1, cg3::Point2d p2);
-    float slope(cg3::Segment2d s);
+    double yAtX(const cg3::Segment2d& s, double x);
 
 }
 
@@ -0,0 +1,744 @@
+#include "algorithms/algorithms.h"
+#include "algorithms/parallel_builder.h"
+#include "algorithms/query_executor.h"
+#include "algorithms/range_queries.h"
+#include "algorithms/simd_predicates.h"
+#include "data_structures/trapezoidalmap_dataset.h"
+#include "data_structures/trapezoidalmap_snapshot.h"
+#include "utils/fileutils.h"
+#include "utils/randomutils.h"
+#include "utils/segmentgenerator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <tuple>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+//Limits for the bounding box, the same of the GUI
+#define BOUNDINGBOX 1e+6
+#define LAYOUT_SAMPLES 100000 // the query points used to count the cache lines touched by a query
+#define REMOVAL_FRACTION 10   // one segment out of REMOVAL_FRACTION is removed after the queries
+#define REMOVAL_SAMPLES 10000 // the maximum number of segments removed after the queries
+#define TRACK_STEP 100        // the length of a step of the track located by the walking queries
+#define WINDOW_SIDE 20000     // the side of the square windows of the window queries
+#define WINDOW_SAMPLES 1000   // the number of window queries
+#define KERNEL_ROUNDS 10      // the times the predicate kernels classify all the query points
+#define BATCH_TARGET_SPEEDUP 5 // the target of the batch queries over a loop of single queries
+#define VERIFY_SEGMENTS 2000  // the segments validated by addSegments() and by addSegment() to compare them
+#define VERIFY_GRID 1000      // the step of the grid of the crossing segments, so that many points share an x
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+/**
+ * @brief The Options struct
+ * The parameters of a run of the benchmark, read from the command line
+ */
+struct Options{
+    std::vector<size_t> sizes;         //the number of random segments of every random dataset
+    std::vector<std::string> files;    //the segment files used as datasets
+    std::string distribution;          //the distribution of SegmentGenerator of the random datasets, empty for RandomUtils
+    bool inputOrder = false;           //if the segments are inserted in the order of the dataset instead of a random order
+    bool hugePages = false;            //if the tables of the map and of the dag are backed by huge pages
+    bool verify = false;               //if the map is compared with a sequential construction of the same segments
+    std::string layout = "insertion";  //the layout of the dag after the construction: insertion, bfs or veb
+    size_t queries = 1000000;          //the number of points of the batch queries
+    size_t latencySamples = 100000;    //the number of single queries timed one by one
+    size_t threads = 0;                //the threads of the parallel queries, 0 for all the cores
+    size_t buildThreads = 1;           //the threads and the slabs of the construction, 1 for the sequential one
+    unsigned long seed = 1;            //the seed of the segments, of the insertion order and of the queries
+    std::string output;                //the JSON file to write, the standard output if empty
+};
+
+/**
+ * @brief The Dataset struct
+ * A set of segments on which the scenarios are run
+ */
+struct Dataset{
+    std::string source;                  //"random", "generator" or the name of the file
+    std::string description;             //the parameters of the generator, or the metadata of the file
+    std::vector<cg3::Segment2d> segments;
+    double loadSeconds;                  //the time spent to generate or to read the segments
+};
+
+/**
+ * @brief seconds
+ * @return the seconds elapsed from start to end
+ */
+double seconds(Clock::time_point start, Clock::time_point end){
+    return std::chrono::duration<double>(end - start).count();
+}
+
+/**
+ * @brief peakRss
+ * @return the peak resident set size of the process in kilobytes, 0 if it isn't available on this system
+ */
+long peakRss(){
+#if defined(__unix__) || defined(__APPLE__)
+    struct rusage usage;
+    if(getrusage(RUSAGE_SELF, &usage) != 0){
+        return 0;
+    }
+#if defined(__APPLE__)
+    return usage.ru_maxrss / 1024; //bytes on macOS
+#else
+    return usage.ru_maxrss;        //kilobytes on Linux
+#endif
+#else
+    return 0;
+#endif
+}
+
+/**
+ * @brief generateTrack
+ * Generates a coherent stream of query points, as a GPS track: every point is a step from the previous one in a
+ * direction that slowly turns. The track bounces on the sides of the bounding box.
+ * @param n the number of points
+ * @param step the length of a step
+ * @param seed the seed of the random directions
+ * @return the points of the track
+ */
+std::vector<cg3::Point2d> generateTrack(size_t n, double step, unsigned long seed){
+    std::mt19937_64 rng(seed);
+    std::uniform_real_distribution<double> turn(-0.1, 0.1);
+    std::vector<cg3::Point2d> track;
+    track.reserve(n);
+    double x = 0, y = 0, angle = 0;
+    for(size_t i = 0; i < n; i++){
+        track.push_back(cg3::Point2d(x, y));
+        angle += turn(rng);
+        double nx = x + step * std::cos(angle), ny = y + step * std::sin(angle);
+        if(std::abs(nx) >= BOUNDINGBOX - 1){
+            angle = M_PI - angle;
+            nx = x;
+        }
+        if(std::abs(ny) >= BOUNDINGBOX - 1){
+            angle = -angle;
+            ny = y;
+        }
+        x = nx;
+        y = ny;
+    }
+    return track;
+}
+
+/**
+ * @brief kernelSeconds
+ * Measures the predicate kernel of the SEGMENT nodes: the query points are classified against a diagonal of the
+ * bounding box KERNEL_ROUNDS times, with the instruction set chosen by predicates::setSimdLevel()
+ * @param xs the x coordinates of the points
+ * @param ys the y coordinates of the points
+ * @param[out] side the sides of the points
+ * @return the time of a round
+ */
+double kernelSeconds(const std::vector<double>& xs, const std::vector<double>& ys, std::vector<unsigned char>& side){
+    Clock::time_point start = Clock::now();
+    for(size_t i = 0; i < KERNEL_ROUNDS; i++){
+        predicates::classifyAbove(-BOUNDINGBOX, -BOUNDINGBOX + i, BOUNDINGBOX, BOUNDINGBOX, xs.data(), ys.data(), xs.size(), side.data());
+    }
+    return std::chrono::duration<double>(Clock::now() - start).count() / KERNEL_ROUNDS;
+}
+
+/**
+ * @brief The Verification struct
+ * The differences between a built map and a sequential construction of the same segments, and between the
+ * validation of a set of segments at once and one at a time
+ */
+struct Verification{
+    bool trapezoidsEqual = true;   //if the two maps have the same trapezoids, whatever their ids
+    size_t queryMismatches = 0;    //the query points whose trapezoid has a different top or bottom segment
+    bool validationEqual = true;   //if addSegments() keeps the same segments of addSegment() one at a time
+    bool parserChecked = true;     //if the corrupt segment files are rejected or truncated as expected
+};
+
+typedef std::tuple<double, double, double, double, size_t, size_t> TrapezoidKey; //leftp, rightp, top, bottom
+
+/**
+ * @brief trapezoidKeys
+ * @return the endpoints and the segments of the trapezoids of the map, sorted: they don't depend on the ids of the
+ * trapezoids, so they are the same for every construction of the same segments
+ */
+std::vector<TrapezoidKey> trapezoidKeys(const TrapezoidalMap& T){
+    std::vector<TrapezoidKey> keys;
+    keys.reserve(T.getTsize());
+    for(const Trapezoid& t : T.getMap()){
+        const cg3::Point2d& l = T.getLeftp(t);
+        const cg3::Point2d& r = T.getRightp(t);
+        keys.push_back(TrapezoidKey(l.x(), l.y(), r.x(), r.y(), t.getTopId(), t.getBottomId()));
+    }
+    std::sort(keys.begin(), keys.end());
+    return keys;
+}
+
+/**
+ * @brief sameValidation
+ * Validates the segments with TrapezoidalMapDataset::addSegments() and with addSegment() called on every segment
+ * in order, and compares the segments that are kept
+ * @param segments the segments to validate
+ * @return true if the two datasets have the same segments in the same order
+ */
+bool sameValidation(const std::vector<cg3::Segment2d>& segments){
+    TrapezoidalMapDataset bulk, sequential;
+    std::vector<TrapezoidalMapDataset::RejectedSegment> rejected = bulk.addSegments(segments);
+    for(const cg3::Segment2d& s : segments){
+        bool inserted;
+        sequential.addSegment(s, inserted);
+    }
+    return bulk.getSegments() == sequential.getSegments() && bulk.segmentNumber() + rejected.size() == segments.size();
+}
+
+/**
+ * @brief checkParser
+ * Parses some corrupt segment files: a number of segments that is negative, not a number, not an integer or too
+ * big, and malformed coordinates in the body
+ * @return true if the files with a corrupt number give no segments, and the segments are truncated before the
+ * first malformed one
+ */
+bool checkParser(){
+    const char * corruptHeaders[] = {"-1\n0 0 1 1\n", "nan\n0 0 1 1\n", "2.5\n0 0 1 1\n", "3x\n0 0 1 1\n", "inf\n0 0 1 1\n"};
+    std::string metadata;
+    for(const char * text : corruptHeaders){
+        if(!FileUtils::getSegmentsFromString(text, metadata).empty()){
+            return false;
+        }
+    }
+    //a huge number is not trusted for the allocation, the segments of the file are read
+    if(FileUtils::getSegmentsFromString("1e300\n0 0 1 1\n", metadata).size() != 1){
+        return false;
+    }
+    const cg3::Segment2d first(cg3::Point2d(0, 0), cg3::Point2d(1, 1));
+    const char * corruptBodies[] = {"3\n0 0 1 1\n2 2 x 3\n4 4 5 5\n", "3\n0 0 1 1\n2 2 3 3abc\n4 4 5 5\n", "2\n0 0 1 1\n2 2 -\n"};
+    for(const char * text : corruptBodies){
+        std::vector<cg3::Segment2d> segments = FileUtils::getSegmentsFromString(text, metadata);
+        if(segments.size() != 1 || segments[0] != first){
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief crossingSegments
+ * @return random segments with the endpoints on a grid, so that they cross each other, share endpoints and put
+ * different points on the same x: addSegments() rejects them for every reason
+ */
+std::vector<cg3::Segment2d> crossingSegments(size_t n, unsigned long seed){
+    std::vector<cg3::Point2d> points = RandomUtils::generateRandomPoints(2 * n, BOUNDINGBOX, seed);
+    std::vector<cg3::Segment2d> segments;
+    for(size_t i = 0; i + 1 < points.size(); i += 2){
+        cg3::Point2d p(std::round(points[i].x() / VERIFY_GRID) * VERIFY_GRID, std::round(points[i].y() / VERIFY_GRID) * VERIFY_GRID);
+        cg3::Point2d q(std::round(points[i + 1].x() / VERIFY_GRID) * VERIFY_GRID, std::round(points[i + 1].y() / VERIFY_GRID) * VERIFY_GRID);
+        if(p.x() != q.x()){
+            segments.push_back(cg3::Segment2d(p, q)); //the vertical segments are rejected only by addSegments()
+        }
+    }
+    return segments;
+}
+
+/**
+ * @brief verifyMap
+ * Compares a built map with the map of buildTrapezoidalMap() on the same segments: the trapezoidal map of a set of
+ * segments is unique, so the parallel construction and the insertion in the order of the dataset must give the same
+ * trapezoids, and the query points must fall between the same segments. The validation of the segments by
+ * TrapezoidalMapDataset::addSegments() is compared with addSegment() as well, on the first segments of the dataset
+ * and on segments that cross each other, and the parser is run on corrupt segment files.
+ * @param T the built map
+ * @param D the dag of the built map
+ * @param segments the segments of the map
+ * @param points the query points
+ * @param seed the seed of the sequential construction
+ * @return the differences between the two maps
+ */
+Verification verifyMap(const TrapezoidalMap& T, const Dag& D, const std::vector<cg3::Segment2d>& segments,
+                       const std::vector<cg3::Point2d>& points, unsigned long seed){
+    TrapezoidalMap sequentialT;
+    Dag sequentialD;
+    algorithms::buildTrapezoidalMap(sequentialT, sequentialD, segments, seed);
+
+    Verification verification;
+    verification.trapezoidsEqual = trapezoidKeys(T) == trapezoidKeys(sequentialT);
+    std::vector<cg3::Segment2d> first(segments.begin(), segments.begin() + std::min<size_t>(segments.size(), VERIFY_SEGMENTS));
+    verification.validationEqual = sameValidation(first) && sameValidation(crossingSegments(VERIFY_SEGMENTS, seed));
+    verification.parserChecked = checkParser();
+    for(const cg3::Point2d& p : points){
+        const Trapezoid& t = T.getTrapezoid(algorithms::queryTrapezoid(D, p));
+        const Trapezoid& u = sequentialT.getTrapezoid(algorithms::queryTrapezoid(sequentialD, p));
+        if(t.getTopId() != u.getTopId() || t.getBottomId() != u.getBottomId()){
+            verification.queryMismatches++;
+        }
+    }
+    return verification;
+}
+
+/**
+ * @brief percentile
+ * @param sorted the samples, sorted in increasing order
+ * @param p the percentile, between 0 and 100
+ * @return the sample of rank p (nearest rank method)
+ */
+double percentile(const std::vector<double>& sorted, double p){
+    if(sorted.empty()){
+        return 0;
+    }
+    size_t rank = size_t(p / 100 * sorted.size() + 0.5);
+    return sorted[std::min(sorted.size() - 1, rank == 0 ? 0 : rank - 1)];
+}
+
+/**
+ * @brief escape
+ * @return the string s escaped for a JSON string literal
+ */
+std::string escape(const std::string& s){
+    std::string out;
+    for(char c : s){
+        if(c == '\n'){
+            out += "\\n";
+            continue;
+        }
+        if(c == '"' || c == '\\'){
+            out += '\\';
+        }
+        out += (unsigned char) c < 0x20 ? ' ' : c;
+    }
+    return out;
+}
+
+/**
+ * @brief parseSizes
+ * @return the sizes in a comma separated list
+ */
+std::vector<size_t> parseSizes(const std::string& list){
+    std::vector<size_t> sizes;
+    std::stringstream ss(list);
+    std::string item;
+    while(std::getline(ss, item, ',')){
+        if(!item.empty()){
+            sizes.push_back(std::strtoull(item.c_str(), nullptr, 10));
+        }
+    }
+    return sizes;
+}
+
+/**
+ * @brief usage
+ * Prints the command line options of the benchmark
+ */
+void usage(const char * name){
+    std::cerr << "Usage: " << name << " [options]" << std::endl <<
+                 "  --sizes n1,n2,...   number of random segments of every random dataset (default 1000,2000,4000)" << std::endl <<
+                 "  --file path         add a segment file as a dataset, can be repeated" << std::endl <<
+                 "  --distribution name generate the random datasets with the segment generator: uniform, clustered," << std::endl <<
+                 "                      horizontal, roads or adversarial (default: the random segments of the GUI)" << std::endl <<
+                 "  --input-order       insert the segments in the order of the dataset instead of a random order" << std::endl <<
+                 "  --huge-pages        back the tables of the map and of the dag with huge pages" << std::endl <<
+                 "  --verify            compare every map with a sequential construction, and the validation of the" << std::endl <<
+                 "                      segments at once with the one at a time, exit with 2 if they differ" << std::endl <<
+                 "  --layout name       the layout of the dag after the construction: insertion, bfs or veb (default insertion)" << std::endl <<
+                 "  --queries n         number of points of the batch queries (default 1000000)" << std::endl <<
+                 "  --latency n         number of single queries timed one by one (default 100000)" << std::endl <<
+                 "  --threads n         threads of the parallel queries, 0 for all the cores (default 0)" << std::endl <<
+                 "  --build-threads n   threads of the construction, built by vertical slabs, 0 for all the cores (default 1)" << std::endl <<
+                 "  --seed s            seed of the segments, of the insertion order and of the queries (default 1)" << std::endl <<
+                 "  --output path       write the JSON results to a file instead of the standard output" << std::endl;
+}
+
+/**
+ * @brief parseOptions
+ * Reads the options of the benchmark from the command line
+ * @return false if the command line is not valid
+ */
+bool parseOptions(int argc, char * argv[], Options& options){
+    for(int i = 1; i < argc; i++){
+        std::string arg = argv[i];
+        if(arg == "--input-order"){
+            options.inputOrder = true;
+            continue;
+        }
+        if(arg == "--huge-pages"){
+            options.hugePages = true;
+            continue;
+        }
+        if(arg == "--verify"){
+            options.verify = true;
+            continue;
+        }
+        if(i + 1 >= argc){
+            return false; //every option has a value
+        }
+        std::string value = argv[++i];
+        if(arg == "--sizes"){
+            options.sizes = parseSizes(value);
+        }
+        else if(arg == "--file"){
+            options.files.push_back(value);
+        }
+        else if(arg == "--distribution"){
+            SegmentGenerator::Distribution distribution;
+            if(!SegmentGenerator::parseDistribution(value, distribution)){
+                return false;
+            }
+            options.distribution = value;
+        }
+        else if(arg == "--layout"){
+            if(value != "insertion" && value != "bfs" && value != "veb"){
+                return false;
+            }
+            options.layout = value;
+        }
+        else if(arg == "--queries"){
+            options.queries = std::strtoull(value.c_str(), nullptr, 10);
+        }
+        else if(arg == "--latency"){
+            options.latencySamples = std::strtoull(value.c_str(), nullptr, 10);
+        }
+        else if(arg == "--threads"){
+            options.threads = std::strtoull(value.c_str(), nullptr, 10);
+        }
+        else if(arg == "--build-threads"){
+            options.buildThreads = std::strtoull(value.c_str(), nullptr, 10);
+        }
+        else if(arg == "--seed"){
+            options.seed = std::strtoul(value.c_str(), nullptr, 10);
+        }
+        else if(arg == "--output"){
+            options.output = value;
+        }
+        else{
+            return false;
+        }
+    }
+    if(options.sizes.empty() && options.files.empty()){
+        options.sizes = {1000, 2000, 4000};
+    }
+    return true;
+}
+
+/**
+ * @brief runScenarios
+ * Runs all the scenarios on a dataset and writes their results as a JSON object:
+ * the construction time, the latency percentiles of the single queries, the throughput of the
+ * batch queries, the time to remove a segment and the peak memory of the process after the scenarios.
+ * With --verify the map is also compared with a sequential construction.
+ * @param dataset the segments of the dataset
+ * @param options the parameters of the run
+ * @param json the stream in which the results are written
+ * @return false if the verification found a difference
+ */
+bool runScenarios(const Dataset& dataset, const Options& options, std::ostream& json){
+    std::cerr << "Benchmarking " << dataset.source << " (" << dataset.segments.size() << " segments)..." << std::endl;
+
+    //build time
+    TrapezoidalMap T;
+    Dag D;
+    Clock::time_point start = Clock::now();
+    T.reserve(dataset.segments.size(), options.hugePages);
+    D.reserve(dataset.segments.size(), options.hugePages);
+    if(options.inputOrder){
+        for(const cg3::Segment2d& s : dataset.segments){
+            algorithms::addSegment(T, D, s);
+        }
+    }
+    else if(options.buildThreads != 1){
+        algorithms::parallelBuildTrapezoidalMap(T, D, dataset.segments, options.seed, options.buildThreads);
+    }
+    else{
+        algorithms::buildTrapezoidalMap(T, D, dataset.segments, options.seed);
+    }
+    double buildSeconds = seconds(start, Clock::now());
+
+    std::vector<cg3::Point2d> points = RandomUtils::generateRandomPoints(options.queries, BOUNDINGBOX, options.seed);
+
+    //verification, the map must be the same of a sequential construction
+    Verification verification;
+    if(options.verify){
+        verification = verifyMap(T, D, dataset.segments, points, options.seed);
+    }
+
+    //layout of the dag, the cache lines touched by a query are counted before and after the relayout
+    std::vector<cg3::Point2d> layoutPoints(points.begin(), points.begin() + std::min<size_t>(points.size(), LAYOUT_SAMPLES));
+    double dagLinesBefore = algorithms::averageCacheLines(D, layoutPoints, sizeof(DagNode));
+    double packedLinesBefore = algorithms::averageCacheLines(D, layoutPoints, sizeof(PackedDagNode));
+    start = Clock::now();
+    if(options.layout != "insertion"){
+        algorithms::optimizeDagLayout(T, D, options.layout == "bfs" ? BFS_LAYOUT : VEB_LAYOUT);
+    }
+    double layoutSeconds = seconds(start, Clock::now());
+    double dagLinesAfter = algorithms::averageCacheLines(D, layoutPoints, sizeof(DagNode));
+    double packedLinesAfter = algorithms::averageCacheLines(D, layoutPoints, sizeof(PackedDagNode));
+
+    //single query latency, every query is timed by itself
+    size_t samples = std::min(options.latencySamples, points.size());
+    std::vector<double> latencies(samples);
+    size_t checksum = 0; //it keeps the compiler from removing the queries
+    for(size_t i = 0; i < samples; i++){
+        Clock::time_point begin = Clock::now();
+        checksum += algorithms::queryTrapezoid(D, points[i]);
+        latencies[i] = std::chrono::duration<double, std::nano>(Clock::now() - begin).count();
+    }
+    double meanLatency = 0;
+    for(double l : latencies){
+        meanLatency += l;
+    }
+    meanLatency = samples > 0 ? meanLatency / samples : 0;
+    std::sort(latencies.begin(), latencies.end());
+
+    //batch query throughput
+    std::vector<size_t> out;
+    start = Clock::now();
+    for(const cg3::Point2d& p : points){
+        checksum += algorithms::queryTrapezoid(D, p);
+    }
+    double loopSeconds = seconds(start, Clock::now());
+
+    start = Clock::now();
+    algorithms::queryPoints(D, points, out);
+    double batchSeconds = seconds(start, Clock::now());
+
+    TrapezoidalMapSnapshot snapshot(T, D);
+    start = Clock::now();
+    algorithms::queryPoints(snapshot.getPackedDag(), points, out);
+    double packedSeconds = seconds(start, Clock::now());
+
+    //predicate kernels, the vector kernels chosen at runtime are compared with the scalar ones
+    simdLevel level = predicates::getSimdLevel();
+    std::vector<double> xs(points.size()), ys(points.size());
+    std::vector<unsigned char> side(points.size());
+    for(size_t i = 0; i < points.size(); i++){
+        xs[i] = points[i].x();
+        ys[i] = points[i].y();
+    }
+    double kernelVectorSeconds = kernelSeconds(xs, ys, side);
+    predicates::setSimdLevel(SIMD_SCALAR);
+    double kernelScalarSeconds = kernelSeconds(xs, ys, side);
+    start = Clock::now();
+    algorithms::queryPoints(snapshot.getPackedDag(), points, out);
+    double packedScalarSeconds = seconds(start, Clock::now());
+    predicates::setSimdLevel(level);
+    for(unsigned char c : side){
+        checksum += c;
+    }
+
+    std::vector<algorithms::QueryThreadStats> stats;
+    start = Clock::now();
+    algorithms::parallelQueryPoints(snapshot, points, out, options.threads, stats);
+    double parallelSeconds = seconds(start, Clock::now());
+    for(size_t id : out){
+        checksum += id;
+    }
+
+    //coherent stream, the points of a track are located by walking from the previous answer
+    std::vector<cg3::Point2d> track = generateTrack(samples, TRACK_STEP, options.seed);
+    start = Clock::now();
+    for(const cg3::Point2d& p : track){
+        checksum += algorithms::queryTrapezoid(D, p);
+    }
+    double trackDagSeconds = seconds(start, Clock::now());
+    start = Clock::now();
+    algorithms::queryPointsWalking(T, D, track, out);
+    double trackWalkSeconds = seconds(start, Clock::now());
+    size_t walked = 0;
+    for(size_t i = 1; i < track.size(); i++){
+        size_t trapezoid;
+        walked += algorithms::walkToPoint(T, track[i], out[i - 1], WALK_MAX_STEPS, trapezoid);
+    }
+    for(size_t id : out){
+        checksum += id;
+    }
+
+    //window queries, square windows centered in the query points
+    size_t windows = std::min<size_t>(WINDOW_SAMPLES, points.size());
+    size_t windowTrapezoids = 0, windowSegments = 0;
+    std::vector<size_t> trapezoidsInWindow, segmentsInWindow;
+    start = Clock::now();
+    for(size_t i = 0; i < windows; i++){
+        cg3::Point2d half(WINDOW_SIDE / 2, WINDOW_SIDE / 2);
+        algorithms::windowQuery(T, D, cg3::BoundingBox2(points[i] - half, points[i] + half), trapezoidsInWindow, segmentsInWindow);
+        windowTrapezoids += trapezoidsInWindow.size();
+        windowSegments += segmentsInWindow.size();
+    }
+    double windowSeconds = seconds(start, Clock::now());
+    checksum += windowTrapezoids + windowSegments;
+
+    //removal time, some random segments are removed from the map after the queries
+    size_t trapezoids = T.getTsize();
+    size_t dagNodes = D.getVectorSize(DAGNODE);
+    size_t dagDepth = D.getDepth();
+    size_t removals = std::min<size_t>(dataset.segments.size() / REMOVAL_FRACTION, REMOVAL_SAMPLES);
+    std::vector<size_t> removed = algorithms::randomInsertionOrder(dataset.segments.size(), options.seed + 1);
+    start = Clock::now();
+    for(size_t i = 0; i < removals; i++){
+        algorithms::removeSegment(T, D, removed[i]);
+    }
+    double removalSeconds = seconds(start, Clock::now());
+    if(algorithms::isCompactionDue(T, D)){
+        algorithms::compactTrapezoidalMap(T, D, options.seed); //the rebuild is explicit, outside the removal time
+    }
+
+    size_t n = points.size();
+    //the speedup of the batch queries over the loop of single queries, compared with BATCH_TARGET_SPEEDUP
+    double batchSpeedup = batchSeconds > 0 ? loopSeconds / batchSeconds : 0;
+    double packedSpeedup = packedSeconds > 0 ? loopSeconds / packedSeconds : 0;
+    json << "    {" << std::endl <<
+            "      \"source\": \"" << escape(dataset.source) << "\"," << std::endl <<
+            "      \"description\": \"" << escape(dataset.description) << "\"," << std::endl <<
+            "      \"segments\": " << dataset.segments.size() << "," << std::endl <<
+            "      \"load_seconds\": " << dataset.loadSeconds << "," << std::endl <<
+            "      \"build\": {" << std::endl <<
+            "        \"seconds\": " << buildSeconds << "," << std::endl <<
+            "        \"insertion_order\": \"" << (options.inputOrder ? "input" : "random") << "\"," << std::endl <<
+            "        \"threads\": " << (options.inputOrder ? 1 : options.buildThreads) << "," << std::endl <<
+            "        \"huge_pages\": " << (options.hugePages ? "true" : "false") << "," << std::endl <<
+            "        \"trapezoids\": " << trapezoids << "," << std::endl <<
+            "        \"dag_nodes\": " << dagNodes << "," << std::endl <<
+            "        \"dag_depth\": " << dagDepth << std::endl <<
+            "      }," << std::endl <<
+            "      \"verification\": {" << std::endl <<
+            "        \"enabled\": " << (options.verify ? "true" : "false") << "," << std::endl <<
+            "        \"trapezoids_equal\": " << (verification.trapezoidsEqual ? "true" : "false") << "," << std::endl <<
+            "        \"query_mismatches\": " << verification.queryMismatches << "," << std::endl <<
+            "        \"validation_equal\": " << (verification.validationEqual ? "true" : "false") << "," << std::endl <<
+            "        \"parser_checked\": " << (verification.parserChecked ? "true" : "false") << std::endl <<
+            "      }," << std::endl <<
+            "      \"layout\": {" << std::endl <<
+            "        \"order\": \"" << options.layout << "\"," << std::endl <<
+            "        \"seconds\": " << layoutSeconds << "," << std::endl <<
+            "        \"dag_cache_lines_before\": " << dagLinesBefore << "," << std::endl <<
+            "        \"dag_cache_lines_after\": " << dagLinesAfter << "," << std::endl <<
+            "        \"packed_dag_cache_lines_before\": " << packedLinesBefore << "," << std::endl <<
+            "        \"packed_dag_cache_lines_after\": " << packedLinesAfter << std::endl <<
+            "      }," << std::endl <<
+            "      \"query_latency_ns\": {" << std::endl <<
+            "        \"samples\": " << samples << "," << std::endl <<
+            "        \"mean\": " << meanLatency << "," << std::endl <<
+            "        \"p50\": " << percentile(latencies, 50) << "," << std::endl <<
+            "        \"p90\": " << percentile(latencies, 90) << "," << std::endl <<
+            "        \"p99\": " << percentile(latencies, 99) << "," << std::endl <<
+            "        \"p999\": " << percentile(latencies, 99.9) << "," << std::endl <<
+            "        \"max\": " << (latencies.empty() ? 0 : latencies.back()) << std::endl <<
+            "      }," << std::endl <<
+            "      \"batch_queries_per_second\": {" << std::endl <<
+            "        \"points\": " << n << "," << std::endl <<
+            "        \"single_query_loop\": " << (loopSeconds > 0 ? n / loopSeconds : 0) << "," << std::endl <<
+            "        \"dag_batch\": " << (batchSeconds > 0 ? n / batchSeconds : 0) << "," << std::endl <<
+            "        \"packed_dag_batch\": " << (packedSeconds > 0 ? n / packedSeconds : 0) << "," << std::endl <<
+            "        \"parallel\": " << (parallelSeconds > 0 ? n / parallelSeconds : 0) << "," << std::endl <<
+            "        \"parallel_threads\": " << stats.size() << std::endl <<
+            "      }," << std::endl <<
+            "      \"batch_speedup\": {" << std::endl <<
+            "        \"dag_batch\": " << batchSpeedup << "," << std::endl <<
+            "        \"packed_dag_batch\": " << packedSpeedup << "," << std::endl <<
+            "        \"target\": " << BATCH_TARGET_SPEEDUP << "," << std::endl <<
+            "        \"target_met\": " << (std::max(batchSpeedup, packedSpeedup) >= BATCH_TARGET_SPEEDUP ? "true" : "false") << std::endl <<
+            "      }," << std::endl <<
+            "      \"predicate_kernels\": {" << std::endl <<
+            "        \"simd\": \"" << predicates::getSimdLevelName(level) << "\"," << std::endl <<
+            "        \"scalar_ns_per_point\": " << (n > 0 ? kernelScalarSeconds * 1e9 / n : 0) << "," << std::endl <<
+            "        \"simd_ns_per_point\": " << (n > 0 ? kernelVectorSeconds * 1e9 / n : 0) << "," << std::endl <<
+            "        \"packed_dag_batch_scalar\": " << (packedScalarSeconds > 0 ? n / packedScalarSeconds : 0) << "," << std::endl <<
+            "        \"packed_dag_batch_simd\": " << (packedSeconds > 0 ? n / packedSeconds : 0) << std::endl <<
+            "      }," << std::endl <<
+            "      \"track_queries\": {" << std::endl <<
+            "        \"points\": " << track.size() << "," << std::endl <<
+            "        \"step\": " << TRACK_STEP << "," << std::endl <<
+            "        \"dag_mean_ns\": " << (track.empty() ? 0 : trackDagSeconds * 1e9 / track.size()) << "," << std::endl <<
+            "        \"walk_mean_ns\": " << (track.empty() ? 0 : trackWalkSeconds * 1e9 / track.size()) << "," << std::endl <<
+            "        \"walk_hit_rate\": " << (track.size() > 1 ? double(walked) / (track.size() - 1) : 0) << std::endl <<
+            "      }," << std::endl <<
+            "      \"window_queries\": {" << std::endl <<
+            "        \"windows\": " << windows << "," << std::endl <<
+            "        \"side\": " << WINDOW_SIDE << "," << std::endl <<
+            "        \"mean_us\": " << (windows > 0 ? windowSeconds * 1e6 / windows : 0) << "," << std::endl <<
+            "        \"mean_trapezoids\": " << (windows > 0 ? double(windowTrapezoids) / windows : 0) << "," << std::endl <<
+            "        \"mean_segments\": " << (windows > 0 ? double(windowSegments) / windows : 0) << std::endl <<
+            "      }," << std::endl <<
+            "      \"removal\": {" << std::endl <<
+            "        \"segments\": " << removals << "," << std::endl <<
+            "        \"mean_us\": " << (removals > 0 ? removalSeconds * 1e6 / removals : 0) << "," << std::endl <<
+            "        \"trapezoids_after\": " << T.getTsize() << std::endl <<
+            "      }," << std::endl <<
+            "      \"peak_rss_kb\": " << peakRss() << "," << std::endl <<
+            "      \"checksum\": " << checksum << std::endl <<
+            "    }";
+    return verification.trapezoidsEqual && verification.queryMismatches == 0 && verification.validationEqual &&
+           verification.parserChecked;
+}
+
+}
+
+/**
+ * The benchmark builds a trapezoidal map for every dataset (random segments of the given sizes and
+ * segment files) and measures the construction and the queries on it. The results are written in JSON,
+ * so that they can be compared between versions of the project.
+ */
+int main(int argc, char * argv[]) {
+    Options options;
+    if(!parseOptions(argc, argv, options)){
+        usage(argv[0]);
+        return 1;
+    }
+
+    std::ofstream file;
+    if(!options.output.empty()){
+        file.open(options.output);
+        if(!file){
+            std::cerr << "Cannot write " << options.output << std::endl;
+            return 1;
+        }
+    }
+    std::ostream& json = options.output.empty() ? std::cout : file;
+
+    json << "{" << std::endl <<
+            "  \"seed\": " << options.seed << "," << std::endl <<
+            "  \"queries\": " << options.queries << "," << std::endl <<
+            "  \"hardware_threads\": " << std::thread::hardware_concurrency() << "," << std::endl <<
+            "  \"datasets\": [" << std::endl;
+    //the datasets are loaded one at a time, so the peak memory of a dataset doesn't include the next ones
+    size_t count = options.sizes.size() + options.files.size();
+    bool verified = true;
+    for(size_t i = 0; i < count; i++){
+        Dataset dataset;
+        Clock::time_point start = Clock::now();
+        if(i < options.sizes.size() && !options.distribution.empty()){
+            SegmentGenerator::Parameters parameters;
+            SegmentGenerator::parseDistribution(options.distribution, parameters.distribution);
+            parameters.segments = options.sizes[i];
+            parameters.radius = BOUNDINGBOX;
+            parameters.seed = options.seed;
+            dataset.source = "generator";
+            dataset.description = SegmentGenerator::describe(parameters);
+            dataset.segments = SegmentGenerator::generateSegments(parameters);
+        }
+        else if(i < options.sizes.size()){
+            dataset.source = "random";
+            dataset.segments = RandomUtils::generateRandomNonIntersectingSegments(options.sizes[i], BOUNDINGBOX, options.seed);
+        }
+        else{
+            dataset.source = options.files[i - options.sizes.size()];
+            dataset.segments = FileUtils::getSegmentsFromFile(dataset.source, dataset.description);
+        }
+        dataset.loadSeconds = seconds(start, Clock::now());
+
+        if(!runScenarios(dataset, options, json)){
+            std::cerr << "The map of " << dataset.source << " differs from a sequential construction" << std::endl;
+            verified = false;
+        }
+        json << (i + 1 < count ? "," : "") << std::endl;
+    }
+    json << "  ]," << std::endl <<
+            "  \"peak_rss_kb\": " << peakRss() << std::endl <<
+            "}" << std::endl;
+
+    return verified ? 0 : 2;
+}
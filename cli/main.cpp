@@ -0,0 +1,347 @@
+#include "algorithms/algorithms.h"
+#include "algorithms/parallel_builder.h"
+#include "algorithms/range_queries.h"
+#include "data_structures/trapezoidalmap_dataset.h"
+#include "utils/fileutils.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+/**
+ * @brief The Options struct
+ * The parameters of the command line driver
+ */
+struct Options{
+    std::string segments;             //the segment file
+    std::string map;                  //the map file to load instead of building the map
+    std::string saveMap;              //the map file in which the built map is saved
+    std::string queries = "-";        //the file of the query points, "-" for the standard input
+    std::string output = "-";         //the file of the results, "-" for the standard output
+    unsigned long seed = 1;           //the seed of the random insertion order
+    size_t batch = 65536;             //the number of query points located together
+    size_t threads = 1;               //the threads of the construction, 1 for the sequential one, 0 for all the cores
+    bool validate = true;             //if the segments are checked by the dataset before the construction
+    bool verbose = false;             //if the statistics of the construction are printed
+    bool windows = false;             //if the queries are windows instead of points
+    std::string layout = "insertion"; //the layout of the dag after the construction: insertion, bfs or veb
+};
+
+/**
+ * @brief usage
+ * Prints the command line options of the driver
+ */
+void usage(const char * name){
+    std::cerr << "Usage: " << name << " (--segments path | --map path) [options]" << std::endl <<
+                 "  --segments path     the segment file, in the format of the GUI" << std::endl <<
+                 "  --map path          a map file saved with --save-map, it is used without building the map" << std::endl <<
+                 "  --save-map path     save the built map in a map file" << std::endl <<
+                 "  --queries path      the query points, one \"x y\" per line (default: standard input)" << std::endl <<
+                 "  --output path       the results, one line per query point (default: standard output)" << std::endl <<
+                 "  --seed s            the seed of the random insertion order (default 1)" << std::endl <<
+                 "  --batch n           the number of query points located together (default 65536)" << std::endl <<
+                 "  --build-threads n   build the map by vertical slabs on n threads, 0 for all the cores (default 1)" << std::endl <<
+                 "  --layout name       the layout of the dag after the construction: insertion, bfs or veb (default insertion)" << std::endl <<
+                 "  --no-validate       don't check the segments, they must be in general position and non intersecting" << std::endl <<
+                 "  --verbose           print the ignored segments and the statistics of the construction on the standard error" << std::endl <<
+                 "  --windows           the queries are windows, one \"x0 y0 x1 y1\" per line, it needs --segments" << std::endl <<
+                 "Every result line is \"trapezoid top bottom\": the id of the trapezoid containing the point and the ids" << std::endl <<
+                 "of the segments above and below it, -1 for a side of the bounding box. The result line of a window" << std::endl <<
+                 "lists the ids of the segments intersecting it, in increasing order." << std::endl;
+}
+
+/**
+ * @brief parseOptions
+ * Reads the options of the driver from the command line
+ * @return false if the command line is not valid
+ */
+bool parseOptions(int argc, char * argv[], Options& options){
+    for(int i = 1; i < argc; i++){
+        std::string arg = argv[i];
+        if(arg == "--no-validate"){
+            options.validate = false;
+            continue;
+        }
+        if(arg == "--verbose"){
+            options.verbose = true;
+            continue;
+        }
+        if(arg == "--windows"){
+            options.windows = true;
+            continue;
+        }
+        if(i + 1 >= argc){
+            return false;
+        }
+        std::string value = argv[++i];
+        if(arg == "--segments"){
+            options.segments = value;
+        }
+        else if(arg == "--map"){
+            options.map = value;
+        }
+        else if(arg == "--save-map"){
+            options.saveMap = value;
+        }
+        else if(arg == "--layout"){
+            if(value != "insertion" && value != "bfs" && value != "veb"){
+                return false;
+            }
+            options.layout = value;
+        }
+        else if(arg == "--queries"){
+            options.queries = value;
+        }
+        else if(arg == "--output"){
+            options.output = value;
+        }
+        else if(arg == "--seed"){
+            options.seed = std::strtoul(value.c_str(), nullptr, 10);
+        }
+        else if(arg == "--batch"){
+            options.batch = std::max<size_t>(1, std::strtoull(value.c_str(), nullptr, 10));
+        }
+        else if(arg == "--build-threads"){
+            options.threads = std::strtoull(value.c_str(), nullptr, 10);
+        }
+        else{
+            return false;
+        }
+    }
+    return options.segments.empty() != options.map.empty() && !(options.windows && !options.map.empty());
+}
+
+/**
+ * @brief segmentId
+ * @return the id of the segment s as printed in the results, -1 for a side of the bounding box
+ */
+long long segmentId(size_t segments, size_t s){
+    return s < segments ? (long long) s : -1;
+}
+
+/**
+ * @brief The BuiltMap struct
+ * A trapezoidal map built by the driver, with its dag
+ */
+struct BuiltMap{
+    const TrapezoidalMap& T;
+    const Dag& D;
+};
+
+/**
+ * @brief locate
+ * Locates a batch of points in the built map and writes the results
+ */
+void locate(const BuiltMap& map, const std::vector<cg3::Point2d>& points, std::vector<size_t>& ids, std::ostream& out){
+    algorithms::queryPoints(map.D, points, ids);
+    for(size_t id : ids){
+        const Trapezoid& t = map.T.getTrapezoid(id);
+        out << id << " " << segmentId(map.T.getSegmentsSize(), t.getTopId()) << " " <<
+               segmentId(map.T.getSegmentsSize(), t.getBottomId()) << "\n";
+    }
+}
+
+/**
+ * @brief locate
+ * Locates a batch of points in a map file and writes the results
+ */
+void locate(const MappedTrapezoidalMap& map, const std::vector<cg3::Point2d>& points, std::vector<size_t>& ids, std::ostream& out){
+    algorithms::queryPoints(map, points, ids);
+    for(size_t id : ids){
+        const MappedTrapezoid& t = map.getTrapezoid(id);
+        out << id << " " << segmentId(map.getSegmentsSize(), MappedTrapezoidalMap::toId(t.top)) << " " <<
+               segmentId(map.getSegmentsSize(), MappedTrapezoidalMap::toId(t.bottom)) << "\n";
+    }
+}
+
+/**
+ * @brief answerQueries
+ * Reads the query points in batches, locates every batch with the batch query and writes the results.
+ * The results of a batch are flushed before the next batch is read.
+ * @param map the built map or the map file
+ * @param batch the number of points of a batch
+ * @param in the stream of the query points
+ * @param out the stream of the results
+ * @return the number of query points
+ */
+template<typename Map>
+size_t answerQueries(const Map& map, size_t batch, std::istream& in, std::ostream& out){
+    std::vector<cg3::Point2d> points;
+    std::vector<size_t> ids;
+    size_t total = 0;
+    points.reserve(batch);
+    double x, y;
+    bool more = true;
+    while(more){
+        points.clear();
+        while(points.size() < batch && (more = bool(in >> x >> y))){
+            points.push_back(cg3::Point2d(x, y));
+        }
+        locate(map, points, ids, out);
+        out.flush();
+        total += points.size();
+    }
+    return total;
+}
+
+/**
+ * @brief answerWindows
+ * Reads the windows and writes the ids of the segments intersecting every window, a window per line
+ * @param T the trapezoidal map
+ * @param D the dag of the map
+ * @param in the stream of the windows
+ * @param out the stream of the results
+ * @return the number of windows
+ */
+size_t answerWindows(const TrapezoidalMap& T, const Dag& D, std::istream& in, std::ostream& out){
+    std::vector<size_t> trapezoids, segments;
+    size_t total = 0;
+    double x0, y0, x1, y1;
+    while(in >> x0 >> y0 >> x1 >> y1){
+        cg3::BoundingBox2 window(cg3::Point2d(std::min(x0, x1), std::min(y0, y1)), cg3::Point2d(std::max(x0, x1), std::max(y0, y1)));
+        algorithms::windowQuery(T, D, window, trapezoids, segments);
+        for(size_t i = 0; i < segments.size(); i++){
+            out << (i > 0 ? " " : "") << segments[i];
+        }
+        out << "\n";
+        total++;
+    }
+    return total;
+}
+
+/**
+ * @brief buildMap
+ * Loads and validates the segment file and builds the trapezoidal map, which is saved if requested
+ * @return false if the segment file can't be read
+ */
+bool buildMap(const Options& options, TrapezoidalMap& T, Dag& D){
+    std::ifstream segmentFile(options.segments);
+    if(!segmentFile){
+        std::cerr << "Cannot read " << options.segments << std::endl;
+        return false;
+    }
+    segmentFile.close();
+
+    //load the segments, they have the same ids of the dataset
+    Clock::time_point start = Clock::now();
+    std::vector<cg3::Segment2d> segments = FileUtils::getSegmentsFromFile(options.segments);
+    if(options.validate){
+        TrapezoidalMapDataset dataset;
+        std::vector<TrapezoidalMapDataset::RejectedSegment> rejected = dataset.addSegments(segments);
+        if(!rejected.empty()){
+            std::cerr << rejected.size() << " segments have been ignored." << std::endl;
+        }
+        if(options.verbose){
+            for(const TrapezoidalMapDataset::RejectedSegment& r : rejected){
+                std::cerr << "Segment " << r.index << " ignored: " << TrapezoidalMapDataset::rejectionReasonDescription(r.reason);
+                if(r.other != SIZE_MAX && !r.otherInDataset){
+                    std::cerr << " (segment " << r.other << ")";
+                }
+                std::cerr << std::endl;
+            }
+        }
+        segments = dataset.getSegments();
+    }
+    double loadSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    start = Clock::now();
+    if(options.threads != 1){
+        algorithms::parallelBuildTrapezoidalMap(T, D, segments, options.seed, options.threads);
+    }
+    else{
+        algorithms::buildTrapezoidalMap(T, D, segments, options.seed);
+    }
+    if(options.layout != "insertion"){
+        algorithms::optimizeDagLayout(T, D, options.layout == "bfs" ? BFS_LAYOUT : VEB_LAYOUT);
+    }
+    double buildSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    if(options.verbose){
+        std::cerr << "Segments: " << segments.size() << ", load: " << loadSeconds << " s, build: " << buildSeconds <<
+                     " s, trapezoids: " << T.getTsize() << ", DAG nodes: " << D.getVectorSize(DAGNODE) <<
+                     ", DAG depth: " << D.getDepth() << std::endl;
+    }
+
+    if(!options.saveMap.empty()){
+        MappedTrapezoidalMap::save(options.saveMap, T, D);
+    }
+    return true;
+}
+
+}
+
+/**
+ * The command line driver builds the trapezoidal map of a segment file, or opens a saved map file, and
+ * locates the query points read from a file or from the standard input. It only uses the algorithms and the data structures
+ * of the project, so it doesn't need Qt, a display or an OpenGL context.
+ */
+int main(int argc, char * argv[]) {
+    Options options;
+    if(!parseOptions(argc, argv, options)){
+        usage(argv[0]);
+        return 1;
+    }
+    std::ios::sync_with_stdio(false);
+
+    std::ifstream queryFile;
+    if(options.queries != "-"){
+        queryFile.open(options.queries);
+        if(!queryFile){
+            std::cerr << "Cannot read " << options.queries << std::endl;
+            return 1;
+        }
+    }
+    std::ofstream outputFile;
+    if(options.output != "-"){
+        outputFile.open(options.output);
+        if(!outputFile){
+            std::cerr << "Cannot write " << options.output << std::endl;
+            return 1;
+        }
+    }
+
+    std::istream& in = options.queries == "-" ? std::cin : queryFile;
+    std::ostream& out = options.output == "-" ? std::cout : outputFile;
+    size_t queries;
+    double querySeconds;
+    try{
+        if(!options.map.empty()){
+            Clock::time_point open = Clock::now();
+            MappedTrapezoidalMap map(options.map);
+            if(options.verbose){
+                std::cerr << "Map file: " << map.getTsize() << " trapezoids, " << map.getNodesSize() << " DAG nodes, opened in " <<
+                             std::chrono::duration<double>(Clock::now() - open).count() << " s" << std::endl;
+            }
+            Clock::time_point start = Clock::now();
+            queries = answerQueries(map, options.batch, in, out);
+            querySeconds = std::chrono::duration<double>(Clock::now() - start).count();
+        }
+        else{
+            TrapezoidalMap T;
+            Dag D;
+            if(!buildMap(options, T, D)){
+                return 1;
+            }
+            Clock::time_point start = Clock::now();
+            queries = options.windows ? answerWindows(T, D, in, out) : answerQueries(BuiltMap{T, D}, options.batch, in, out);
+            querySeconds = std::chrono::duration<double>(Clock::now() - start).count();
+        }
+    }
+    catch(const std::exception& e){
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    if(options.verbose){
+        std::cerr << "Queries: " << queries << ", time: " << querySeconds << " s" << std::endl;
+    }
+
+    return 0;
+}
@@ -1,11 +1,84 @@
 #include "dag.h"
 
+#include <algorithm>
+#include <utility>
+
+#define DAG_NODES_PER_SEGMENT 12 // the nodes reserved for every segment, the construction gives about 8-10 on average
+
+namespace {
+
+/**
+ * @brief bfsOrder
+ * This function lists the nodes reachable from the root in breadth first order, so the nodes of the first levels,
+ * visited by every query, are stored together at the start of the table
+ * @param nodes the nodes of the dag
+ * @return the ids of the nodes in the new order
+ */
+std::vector<size_t> bfsOrder(const Arena<DagNode>& nodes){
+    std::vector<size_t> order;
+    std::vector<char> visited(nodes.size(), 0);
+    order.push_back(0);
+    visited[0] = 1;
+    for(size_t i = 0; i < order.size(); i++){
+        const DagNode& n = nodes[order[i]];
+        if(n.getNodeType() == TRAPEZOID){
+            continue;
+        }
+        for(size_t child : {n.getLeftC(), n.getRightC()}){
+            if(!visited[child]){
+                visited[child] = 1;
+                order.push_back(child);
+            }
+        }
+    }
+    return order;
+}
+
+/**
+ * @brief vebOrder
+ * This function appends to order the nodes of the subdag of root that are less than height levels below it, in
+ * van Emde Boas order: the top half of the levels is laid out recursively, then every subdag hanging from it.
+ * In this way a query path crosses O(log_B n) blocks of B consecutive nodes, whatever B is.
+ * The nodes shared with a subdag laid out before are already in the order, so they are skipped.
+ * The recursion halves the height at every call, so its depth is logarithmic in the depth of the dag.
+ * @param nodes the nodes of the dag
+ * @param root the root of the subdag
+ * @param height the number of levels to lay out
+ * @param[out] order the ids of the nodes in the new order
+ * @param visited 1 for the nodes that are already in the order
+ */
+void vebOrder(const Arena<DagNode>& nodes, size_t root, size_t height, std::vector<size_t>& order, std::vector<char>& visited){
+    if(visited[root]){
+        return;
+    }
+    if(height <= 1 || nodes[root].getNodeType() == TRAPEZOID){
+        visited[root] = 1;
+        order.push_back(root);
+        return;
+    }
+    size_t top = (height + 1) / 2;
+    size_t first = order.size();
+    vebOrder(nodes, root, top, order, visited);
+    size_t last = order.size();
+    for(size_t i = first; i < last; i++){
+        const DagNode& n = nodes[order[i]];
+        if(n.getNodeType() != TRAPEZOID){
+            vebOrder(nodes, n.getLeftC(), height - top, order, visited);
+            vebOrder(nodes, n.getRightC(), height - top, order, visited);
+        }
+    }
+}
+
+}
+
 /**
  * @brief Dag::Dag
  * Constructor of the DAG. The first node inserted in the dag is the node that represent a trapezoid, i.e
  * the bounding box
  */
-Dag::Dag(){
+Dag::Dag() :
+    staleSegments(0)
+{
     insertBoundingBoxD();
 }
 
@@ -16,14 +89,14 @@ Dag::Dag(){
 void Dag::insertBoundingBoxD(){
     DagNode n = DagNode(TRAPEZOID, 0);
     n.setDagId(0);
-    dVector.push_back(n);
+    dVector.pushBack(n);
 }
 
 /**
  * @brief Dag::getdVector
- * @return A reference to the vector containing the DagNodes
+ * @return A reference to the table containing the DagNodes
  */
-std::vector<DagNode>& Dag::getdVector(){
+Arena<DagNode>& Dag::getdVector(){
     return dVector;
 }
 
@@ -35,58 +108,104 @@ std::vector<DagNode>& Dag::getdVector(){
  * @return the position in which the DagNode is inserted
  */
 size_t Dag::insertInVector(DagNode& K){
-        K.setDagId(dVector.size()); //the size of the vector is last index + 1.
-        //So if an element is added at the end, its id will be the old size of the vector
-        dVector.push_back(K); //the node is added to the vector
-        return dVector.size() - 1; //return the position in which the element has been added
+        K.setDagId(dVector.size()); //the size of the table is last index + 1.
+        //So if an element is added at the end, its id will be the old size of the table
+        return dVector.pushBack(K); //the node is added to the table, the nodes already inserted are never moved
 }
 
 /**
- * @brief Dag::insertInVector
- * This methods inserts the point passed as parameter
- * into the vector of the points and returns the position in which the point is added.
- * @param K a reference to the Point to insert into the vector
- * @return the position in which the Point is inserted
+ * @brief Dag::reserve
+ * This method plans the memory of the dag before the insertion of some segments. The randomized construction gives
+ * an expected linear number of nodes, DAG_NODES_PER_SEGMENT nodes for every segment are reserved. When the dag holds
+ * only the bounding box, the table of the nodes is allocated again as a single block and the bounding box is
+ * inserted back. When the estimate is exceeded, or the dag already has some segments, the table grows by new
+ * blocks, without moving the nodes already inserted.
+ * @param segments the number of segments that will be inserted
+ * @param hugePages true to back the tables with huge pages, where the system supports them
  */
-size_t Dag::insertInVector(cg3::Point2d K){
-        pVector.push_back(K); //the point is added to the vector of points
-        return pVector.size() - 1; //return the position in which the point has been added
+void Dag::reserve(size_t segments, bool hugePages){
+    size_t n = sVector.size() + segments;
+    size_t nodes = DAG_NODES_PER_SEGMENT * n + 1;
+    if(dVector.size() <= 1 && (dVector.capacity() < nodes || dVector.getHugePages() != hugePages)){
+        dVector.clear(); //the block allocated by the constructor for the bounding box is released
+        dVector.setHugePages(hugePages);
+        dVector.reserve(nodes);
+        insertBoundingBoxD();
+    }
+    else{
+        dVector.setHugePages(hugePages);
+        dVector.reserve(nodes);
+    }
+    pVector.setHugePages(hugePages);
+    sVector.setHugePages(hugePages);
+    pVector.reserve(2 * n);
+    sVector.reserve(n);
 }
 
 /**
- * @brief Dag::insertInVector
- * This method inserts the segment passed as parameter
- * into the vector of the segments and returns the position in which the segment is added.
- * @param K a reference to the Segment to insert into the vector
- * @return the position in which the Segment is inserted
+ * @brief Dag::relayout
+ * This method renumbers the nodes of a finished dag in a cache friendly order, the ids of the children are remapped.
+ * The root keeps the id 0, the nodes that can't be reached from the root are removed. The ids of the leaves stored
+ * in the trapezoids change, algorithms::optimizeDagLayout() updates them in the trapezoidal map.
+ * @param layout BFS_LAYOUT to store the nodes level by level, VEB_LAYOUT to store them in van Emde Boas order
  */
-size_t Dag::insertInVector(cg3::Segment2d K){
-        sVector.push_back(K); //the segment is added to the vector of segments
-        return sVector.size() - 1; //return the position in which the segment is inserted
+void Dag::relayout(dagLayout layout){
+    std::vector<size_t> order;
+    if(layout == BFS_LAYOUT){
+        order = bfsOrder(dVector);
+    }
+    else{
+        std::vector<char> visited(dVector.size(), 0);
+        vebOrder(dVector, 0, getDepth() + 1, order, visited);
+    }
+
+    std::vector<size_t> position(dVector.size(), SIZE_MAX); //the new id of every node
+    for(size_t i = 0; i < order.size(); i++){
+        position[order[i]] = i;
+    }
+
+    //the new table keeps the capacity of the old one, so the next insertions don't allocate
+    Arena<DagNode> nodes;
+    nodes.setHugePages(dVector.getHugePages());
+    nodes.reserve(dVector.capacity());
+    for(size_t id : order){
+        DagNode n = dVector[id];
+        n.setDagId(nodes.size());
+        if(n.getNodeType() != TRAPEZOID){
+            n.setLeftc(position[n.getLeftC()]);
+            n.setRightc(position[n.getRightC()]);
+        }
+        nodes.pushBack(n);
+    }
+    dVector = std::move(nodes);
 }
 
 /**
- * @brief Dag::deleteInVector
- * This method deletes the element in the position specified by the index from one of the vectors.
- * The vector chosen depends on the type parameter.
- * @param type the type of the vector where the element has to be deleted
- * @param index the position of the element to delete
+ * @brief Dag::setPoint
+ * This method stores the point with the given id in the vector of points, the id is the id of the point in the
+ * trapezoidal map. A point node of the dag refers to the point by this id.
+ * @param id the id of the point
+ * @param p the point
  */
-void Dag::deleteInVector(nodeType type, size_t index)
-{
-    switch(type){
-    case POINT:
-        pVector.erase(pVector.begin() + index); //if it's a point delete from the point vector
-        break;
-    case SEGMENT:
-        sVector.erase(sVector.begin() + index); //if it's a segment delete from the segment vector
-        break;
-    case TRAPEZOID:
-        break;
-    case DAGNODE: //if it's a dagNode, delete from the dagNode vector
-        dVector.erase(dVector.begin() + index);
-        break;
+void Dag::setPoint(size_t id, const cg3::Point2d& p){
+    if(pVector.size() <= id){
+        pVector.resize(id + 1);
     }
+    pVector[id] = p;
+}
+
+/**
+ * @brief Dag::setSegment
+ * This method stores the segment with the given id in the vector of segments, the id is the id of the segment in the
+ * trapezoidal map. A segment node of the dag refers to the segment by this id.
+ * @param id the id of the segment
+ * @param s the segment, oriented from left to right
+ */
+void Dag::setSegment(size_t id, const cg3::Segment2d& s){
+    if(sVector.size() <= id){
+        sVector.resize(id + 1);
+    }
+    sVector[id] = s;
 }
 
 /**
@@ -134,19 +253,49 @@ cg3::Segment2d& Dag::getElementInSVector(size_t index){
     return sVector[index];
 }
 
+/**
+ * @brief Dag::getElementInPVector
+ * Read-only version of getElementInPVector, it allows to query a const Dag without copying it
+ * @param index the position of the element to return
+ * @return a const reference to the point in the requested position
+ */
+const cg3::Point2d& Dag::getElementInPVector(size_t index) const{
+    return pVector[index];
+}
+
+/**
+ * @brief Dag::getElementInDVector
+ * Read-only version of getElementInDVector, it allows to query a const Dag without copying it
+ * @param index the position of the element to return
+ * @return a const reference to the DagNode in the requested position
+ */
+const DagNode& Dag::getElementInDVector(size_t index) const{
+    return dVector[index];
+}
+
+/**
+ * @brief Dag::getElementInSVector
+ * Read-only version of getElementInSVector, it allows to query a const Dag without copying it
+ * @param index the position of the element to return
+ * @return a const reference to the segment in the requested position
+ */
+const cg3::Segment2d& Dag::getElementInSVector(size_t index) const{
+    return sVector[index];
+}
+
 /**
  * @brief Dag::getsVector
- * @return A reference to the vector of segments
+ * @return A reference to the table of segments
  */
-std::vector<cg3::Segment2d>& Dag::getsVector(){
+Arena<cg3::Segment2d>& Dag::getsVector(){
     return sVector;
 }
 
 /**
  * @brief Dag::getpVector
- * @return A reference to the vector of points
+ * @return A reference to the table of points
  */
-std::vector<cg3::Point2d>& Dag::getpVector(){
+Arena<cg3::Point2d>& Dag::getpVector(){
     return pVector;
 }
 
@@ -156,7 +305,7 @@ std::vector<cg3::Point2d>& Dag::getpVector(){
  * @param type the type of the vector of which decide the size
  * @return the size of the vector chosen
  */
-size_t Dag::getVectorSize(nodeType type){
+size_t Dag::getVectorSize(nodeType type) const{
     switch(type){
     case POINT:
         return pVector.size();
@@ -173,50 +322,64 @@ size_t Dag::getVectorSize(nodeType type){
     }
 }
 
+/**
+ * @brief Dag::getDepth
+ * This method computes the depth of the Dag, the number of nodes visited by the longest query before reaching a leaf.
+ * The depth of every node is computed once with an iterative visit, so the method takes linear time
+ * and doesn't overflow the stack on deep Dags.
+ * @return the length of the longest path from the root to a leaf
+ */
+size_t Dag::getDepth() const{
+    std::vector<size_t> height(dVector.size(), SIZE_MAX); //the length of the longest path from the node to a leaf
+    std::vector<size_t> stack;
+    stack.push_back(0);
+    while(!stack.empty()){
+        const DagNode& n = dVector[stack.back()];
+        if(n.getNodeType() == TRAPEZOID){
+            height[stack.back()] = 0;
+            stack.pop_back();
+        }
+        else if(height[n.getLeftC()] == SIZE_MAX){
+            stack.push_back(n.getLeftC()); //visit the left child first
+        }
+        else if(height[n.getRightC()] == SIZE_MAX){
+            stack.push_back(n.getRightC()); //then the right child
+        }
+        else{
+            height[stack.back()] = std::max(height[n.getLeftC()], height[n.getRightC()]) + 1;
+            stack.pop_back();
+        }
+    }
+    return height[0];
+}
+
 /**
  * @brief Dag::clearDag
  * This method clears the Dag when the clear button is pressed on the interface.
- * The vector of dagNodes, points and segments are cleared and the boundingbox is reinserted in the DAG.
+ * The tables of dagNodes, points and segments are released without visiting their elements
+ * and the boundingbox is reinserted in the DAG.
  */
 void Dag::clearDag(){
     dVector.clear(); //remove all elements from dagNode vector
     pVector.clear(); //remove all elements from point vector
     sVector.clear(); //remove all elements from segment vector
+    staleSegments = 0;
     insertBoundingBoxD();
 }
 
 /**
- * @brief Dag::findSegment
- * This method checks if the segment s is present in the vector of segments and returns his position
- * @param[in] s the segment to check
- * @param[out] found a reference to a boolean that is set to true if the segment is found
- * @param[out] index a reference to a size_t that is set with the position in which the segment is found
+ * @brief Dag::addStaleSegment
+ * This method counts a segment removed from the map. Its nodes are not removed from the dag: they still divide
+ * the plane correctly, but they make the queries longer, so the dag is built again when they are too many.
  */
-void Dag::findSegment(cg3::Segment2d s, bool& found, size_t& index){
-    for (size_t i = 0; i < sVector.size(); i++){
-        if(utility::pointEqual(sVector[i].p1(),s.p1()) && utility::pointEqual(sVector[i].p2(),s.p2())){
-            index = i;
-            found = true;
-            return;
-        }
-    }
-    found = false;
+void Dag::addStaleSegment(){
+    staleSegments++;
 }
 
 /**
- * @brief Dag::findPoint
- * This method checks if the point p is present in the vector of points and returns his position
- * @param[in] p the point to check
- * @param[out] found a reference to a boolean that is set to true if the point is found
- * @param[out] index a reference to a size_t that is set with the position in which the point is found
+ * @brief Dag::getStaleSegmentsSize
+ * @return the number of removed segments whose nodes are still in the dag
  */
-void Dag::findPoint(cg3::Point2d p, bool& found, size_t& index){
-    for (size_t i = 0; i < sVector.size(); i++){
-        if(utility::pointEqual(pVector[i],p)){
-            index = i;
-            found = true;
-            return;
-        }
-    }
-    found = false;
+size_t Dag::getStaleSegmentsSize() const{
+    return staleSegments;
 }
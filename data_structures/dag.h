@@ -3,6 +3,10 @@
 
 #include "dag_node.h"
 #include "algorithms/utility.h"
+#include "utils/arena.h"
+
+//the orders in which relayout() stores the nodes of a finished dag
+enum dagLayout {BFS_LAYOUT, VEB_LAYOUT};
 
 class Dag
 {
@@ -11,31 +15,40 @@ class Dag
         Dag();
 
         //getter
-        std::vector<DagNode>& getdVector();
-        std::vector<cg3::Point2d>& getpVector();
-        std::vector<cg3::Segment2d>& getsVector();
+        Arena<DagNode>& getdVector();
+        Arena<cg3::Point2d>& getpVector();
+        Arena<cg3::Segment2d>& getsVector();
 
         //methods for managing the vectors in the dag
         size_t insertInVector(DagNode& K);
-        size_t insertInVector(cg3::Point2d K);
-        size_t insertInVector(cg3::Segment2d K);
+        void setPoint(size_t id, const cg3::Point2d& p);
+        void setSegment(size_t id, const cg3::Segment2d& s);
         size_t replaceNode(size_t old_index, DagNode n);
-        void deleteInVector(nodeType type, size_t index);
-        size_t getVectorSize(nodeType type);
+        size_t getVectorSize(nodeType type) const;
+        size_t getDepth() const;
         cg3::Point2d& getElementInPVector(size_t index);
         DagNode& getElementInDVector(size_t index);
         cg3::Segment2d& getElementInSVector(size_t index);
+
+        //read-only access, used by the queries
+        const cg3::Point2d& getElementInPVector(size_t index) const;
+        const DagNode& getElementInDVector(size_t index) const;
+        const cg3::Segment2d& getElementInSVector(size_t index) const;
         void clearDag();
         void insertBoundingBoxD();
-        void findSegment(cg3::Segment2d s, bool& found, size_t& index);
-        void findPoint(cg3::Point2d p, bool& found, size_t& index);
+        void reserve(size_t segments, bool hugePages = false);
+        void relayout(dagLayout layout);
+        void addStaleSegment();
+        size_t getStaleSegmentsSize() const;
 
 
     private:
-        //attributes of the dag: a vector of dagNodes, of points and segments
-        std::vector<DagNode> dVector;
-        std::vector<cg3::Point2d> pVector;
-        std::vector<cg3::Segment2d> sVector;
+        //attributes of the dag: a table of dagNodes, of points and segments.
+        //The points and the segments have the same ids they have in the trapezoidal map
+        Arena<DagNode> dVector;
+        Arena<cg3::Point2d> pVector;
+        Arena<cg3::Segment2d> sVector;
+        size_t staleSegments; //the segments removed from the map that are still tested by some nodes
 };
 
 #endif // DAG_H
@@ -78,7 +78,7 @@ void DagNode::setDagId(size_t index){
  * @brief DagNode::getDagId
  * @return the id of the node, i.e. its position in the DagNode vector in the Dag
  */
-size_t DagNode::getDagId(){
+size_t DagNode::getDagId() const{
     return dag_index;
 }
 
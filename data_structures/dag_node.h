@@ -25,7 +25,7 @@ class DagNode{
         //setters
         void setLeftc(size_t child);
         void setRightc(size_t child);
-        size_t getDagId();
+        size_t getDagId() const;
         void setDagId(size_t index);
 
     private:
@@ -0,0 +1,258 @@
+#include "mapped_trapezoidalmap.h"
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#define MAPPED_ALIGNMENT 64         // the alignment of the sections of the file, a cache line
+#define MAPPED_BYTE_ORDER 0x01020304 // the value used to check that the file has the byte order of the machine
+
+namespace {
+
+const char MAGIC[8] = {'T','R','A','P','M','A','P','\0'};
+
+/**
+ * @brief align
+ * @return the first offset not smaller than offset aligned to MAPPED_ALIGNMENT
+ */
+uint64_t align(uint64_t offset){
+    return (offset + MAPPED_ALIGNMENT - 1) / MAPPED_ALIGNMENT * MAPPED_ALIGNMENT;
+}
+
+/**
+ * @brief toMappedId
+ * Converts an id of the TrapezoidalMap to the 32 bit id of a map file, the inverse of MappedTrapezoidalMap::toId()
+ * @param id the id of a point, of a segment or of a trapezoid
+ * @return the id stored in the file
+ */
+uint32_t toMappedId(size_t id){
+    if(id >= SIZE_MAX - 2){
+        return uint32_t(UINT32_MAX - (SIZE_MAX - id)); //an id of the bounding box or a missing neighbor
+    }
+    if(id >= UINT32_MAX - 2){
+        throw std::length_error("MappedTrapezoidalMap: too many elements");
+    }
+    return uint32_t(id);
+}
+
+/**
+ * @brief writeSection
+ * Writes an array of records at the given offset of the file, the space before the offset is filled with zeros
+ * @param out the file
+ * @param offset the offset of the section
+ * @param data the first record
+ * @param bytes the size of the records
+ */
+void writeSection(std::ofstream& out, uint64_t offset, const void * data, size_t bytes){
+    static const char zeros[MAPPED_ALIGNMENT] = {};
+    out.write(zeros, std::streamsize(offset - uint64_t(out.tellp())));
+    out.write(static_cast<const char *>(data), std::streamsize(bytes));
+}
+
+/**
+ * @brief validSection
+ * @return true if a section of count records of the given size starting at offset is aligned and inside the file
+ */
+bool validSection(uint64_t offset, uint64_t count, size_t record, uint64_t size){
+    return offset % MAPPED_ALIGNMENT == 0 && offset <= size && count <= (size - offset) / record;
+}
+
+}
+
+/**
+ * @brief MappedTrapezoidalMap::MappedTrapezoidalMap
+ * Constructor of the mapped map: the file is mapped in memory, or read in a buffer if it can't be mapped.
+ * Only the header is checked, the records are not visited, so the time doesn't depend on the size of the map.
+ * @param filename the name of a file written by MappedTrapezoidalMap::save()
+ * @throws std::runtime_error if the file can't be read or it is not a valid map file of this version
+ */
+MappedTrapezoidalMap::MappedTrapezoidalMap(const std::string& filename){
+    if(!file.open(filename)){
+        throw std::runtime_error("MappedTrapezoidalMap: cannot read " + filename);
+    }
+    data = file.getData();
+    size_t size = file.getSize();
+
+    const char * error = nullptr;
+    if(size < sizeof(MappedMapHeader) || std::memcmp(header().magic, MAGIC, sizeof(MAGIC)) != 0){
+        error = "not a map file";
+    }
+    else if(header().version != MAPPED_MAP_VERSION){
+        error = "unsupported version";
+    }
+    else if(header().byteOrder != MAPPED_BYTE_ORDER){
+        error = "saved with a different byte order";
+    }
+    else if(header().fileSize != size || header().nodes == 0 ||
+            !validSection(header().nodesOffset, header().nodes, sizeof(PackedDagNode), size) ||
+            !validSection(header().dagSegmentsOffset, header().dagSegments, sizeof(PackedSegment), size) ||
+            !validSection(header().trapezoidsOffset, header().trapezoids, sizeof(MappedTrapezoid), size) ||
+            !validSection(header().pointsOffset, header().points, sizeof(MappedPoint), size) ||
+            !validSection(header().segmentsOffset, header().segments, sizeof(MappedSegment), size)){
+        error = "truncated or corrupted file";
+    }
+    if(error != nullptr){
+        file.close();
+        throw std::runtime_error("MappedTrapezoidalMap: " + filename + ": " + error);
+    }
+}
+
+/**
+ * @brief MappedTrapezoidalMap::save
+ * This method writes a built trapezoidal map and its dag in a map file. The dag is packed, so the file
+ * has the same node ids of the dag, and the trapezoids, the points and the segments keep their ids.
+ * @param filename the name of the file to write
+ * @param T the trapezoidal map
+ * @param D the dag of the trapezoidal map
+ * @throws std::runtime_error if the file can't be written
+ * @throws std::length_error if the map is too big for the 32 bit ids of the file
+ */
+void MappedTrapezoidalMap::save(const std::string& filename, const TrapezoidalMap& T, const Dag& D){
+    PackedDag P(D);
+
+    std::vector<MappedTrapezoid> trapezoids(T.getTsize());
+    for(size_t i = 0; i < trapezoids.size(); i++){
+        const Trapezoid& t = T.getTrapezoid(i);
+        MappedTrapezoid& m = trapezoids[i];
+        m.leftp = toMappedId(t.getLeftpId());
+        m.rightp = toMappedId(t.getRightpId());
+        m.top = toMappedId(t.getTopId());
+        m.bottom = toMappedId(t.getBottomId());
+        for(size_t j = 0; j < 4; j++){
+            m.neighbors[j] = toMappedId(t.getNeighbor(j));
+        }
+    }
+
+    std::vector<MappedPoint> points(T.getPointsSize());
+    for(size_t i = 0; i < points.size(); i++){
+        points[i] = {T.getPoint(i).x(), T.getPoint(i).y()};
+    }
+
+    std::vector<MappedSegment> segments(T.getSegmentsSize());
+    for(size_t i = 0; i < segments.size(); i++){
+        segments[i] = {toMappedId(T.getSegmentLeftpId(i)), toMappedId(T.getSegmentRightpId(i))};
+    }
+
+    MappedMapHeader h;
+    std::memset(&h, 0, sizeof(h));
+    std::memcpy(h.magic, MAGIC, sizeof(MAGIC));
+    h.version = MAPPED_MAP_VERSION;
+    h.byteOrder = MAPPED_BYTE_ORDER;
+    h.nodes = P.getNodesSize();
+    h.nodesOffset = align(sizeof(MappedMapHeader));
+    h.dagSegments = P.getSegmentsSize();
+    h.dagSegmentsOffset = align(h.nodesOffset + h.nodes * sizeof(PackedDagNode));
+    h.trapezoids = trapezoids.size();
+    h.trapezoidsOffset = align(h.dagSegmentsOffset + h.dagSegments * sizeof(PackedSegment));
+    h.points = points.size();
+    h.pointsOffset = align(h.trapezoidsOffset + h.trapezoids * sizeof(MappedTrapezoid));
+    h.segments = segments.size();
+    h.segmentsOffset = align(h.pointsOffset + h.points * sizeof(MappedPoint));
+    h.fileSize = h.segmentsOffset + h.segments * sizeof(MappedSegment);
+
+    std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+    if(!out){
+        throw std::runtime_error("MappedTrapezoidalMap: cannot write " + filename);
+    }
+    out.write(reinterpret_cast<const char *>(&h), sizeof(h));
+    writeSection(out, h.nodesOffset, P.getNodes(), h.nodes * sizeof(PackedDagNode));
+    writeSection(out, h.dagSegmentsOffset, P.getSegments(), h.dagSegments * sizeof(PackedSegment));
+    writeSection(out, h.trapezoidsOffset, trapezoids.data(), h.trapezoids * sizeof(MappedTrapezoid));
+    writeSection(out, h.pointsOffset, points.data(), h.points * sizeof(MappedPoint));
+    writeSection(out, h.segmentsOffset, segments.data(), h.segments * sizeof(MappedSegment));
+    out.close();
+    if(!out){
+        throw std::runtime_error("MappedTrapezoidalMap: cannot write " + filename);
+    }
+}
+
+/**
+ * @brief MappedTrapezoidalMap::header
+ * @return the header at the beginning of the file
+ */
+const MappedMapHeader& MappedTrapezoidalMap::header() const{
+    return *reinterpret_cast<const MappedMapHeader *>(data);
+}
+
+/**
+ * @brief MappedTrapezoidalMap::getNodes
+ * @return a pointer to the first packed node, the root of the dag
+ */
+const PackedDagNode* MappedTrapezoidalMap::getNodes() const{
+    return reinterpret_cast<const PackedDagNode *>(data + header().nodesOffset);
+}
+
+/**
+ * @brief MappedTrapezoidalMap::getDagSegments
+ * @return a pointer to the first segment of the packed dag
+ */
+const PackedSegment* MappedTrapezoidalMap::getDagSegments() const{
+    return reinterpret_cast<const PackedSegment *>(data + header().dagSegmentsOffset);
+}
+
+/**
+ * @brief MappedTrapezoidalMap::getTrapezoid
+ * @param index the id of the trapezoid
+ * @return a reference to the trapezoid with the given id
+ */
+const MappedTrapezoid& MappedTrapezoidalMap::getTrapezoid(size_t index) const{
+    return reinterpret_cast<const MappedTrapezoid *>(data + header().trapezoidsOffset)[index];
+}
+
+/**
+ * @brief MappedTrapezoidalMap::getPoint
+ * @param index the id of the point
+ * @return a reference to the point with the given id
+ */
+const MappedPoint& MappedTrapezoidalMap::getPoint(size_t index) const{
+    return reinterpret_cast<const MappedPoint *>(data + header().pointsOffset)[index];
+}
+
+/**
+ * @brief MappedTrapezoidalMap::getSegment
+ * @param index the id of the segment
+ * @return a reference to the ids of the endpoints of the segment with the given id
+ */
+const MappedSegment& MappedTrapezoidalMap::getSegment(size_t index) const{
+    return reinterpret_cast<const MappedSegment *>(data + header().segmentsOffset)[index];
+}
+
+/**
+ * @brief MappedTrapezoidalMap::getNodesSize
+ * @return the number of nodes of the packed dag
+ */
+size_t MappedTrapezoidalMap::getNodesSize() const{
+    return header().nodes;
+}
+
+/**
+ * @brief MappedTrapezoidalMap::getTsize
+ * @return the number of trapezoids of the map
+ */
+size_t MappedTrapezoidalMap::getTsize() const{
+    return header().trapezoids;
+}
+
+/**
+ * @brief MappedTrapezoidalMap::getPointsSize
+ * @return the number of points in the table of the points
+ */
+size_t MappedTrapezoidalMap::getPointsSize() const{
+    return header().points;
+}
+
+/**
+ * @brief MappedTrapezoidalMap::getSegmentsSize
+ * @return the number of segments in the table of the segments
+ */
+size_t MappedTrapezoidalMap::getSegmentsSize() const{
+    return header().segments;
+}
+
+/**
+ * @brief MappedTrapezoidalMap::isMemoryMapped
+ * @return true if the file is mapped in memory, false if it has been read in a buffer
+ */
+bool MappedTrapezoidalMap::isMemoryMapped() const{
+    return file.isMemoryMapped();
+}
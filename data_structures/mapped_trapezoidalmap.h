@@ -0,0 +1,109 @@
+#ifndef MAPPED_TRAPEZOIDALMAP_H
+#define MAPPED_TRAPEZOIDALMAP_H
+
+#include "trapezoidalmap.h"
+#include "packed_dag.h"
+#include "utils/mappedfile.h"
+
+#include <cstdint>
+#include <string>
+
+#define MAPPED_MAP_VERSION 1 // the version of the file format, increased at every incompatible change
+
+/**
+ * @brief The MappedTrapezoid struct
+ * A trapezoid stored in a map file, 32 bytes. The ids are 32 bits: the ids of the bounding box and of
+ * the missing neighbors keep their distance from the maximum value, see MappedTrapezoidalMap::toId()
+ */
+struct MappedTrapezoid{
+    uint32_t leftp;
+    uint32_t rightp;
+    uint32_t top;
+    uint32_t bottom;
+    uint32_t neighbors[4];
+};
+
+/**
+ * @brief The MappedPoint struct
+ * A point stored in a map file
+ */
+struct MappedPoint{
+    double x;
+    double y;
+};
+
+/**
+ * @brief The MappedSegment struct
+ * A segment stored in a map file, as the ids of its left and right endpoint
+ */
+struct MappedSegment{
+    uint32_t leftp;
+    uint32_t rightp;
+};
+
+/**
+ * @brief The MappedMapHeader struct
+ * The header at the beginning of a map file. Every section is stored at an offset from the beginning
+ * of the file, aligned to a cache line, so the file doesn't depend on the address at which it is mapped.
+ */
+struct MappedMapHeader{
+    char magic[8];          //"TRAPMAP" followed by a 0
+    uint32_t version;       //MAPPED_MAP_VERSION
+    uint32_t byteOrder;     //0x01020304 written in the byte order of the machine that saved the file
+    uint64_t fileSize;      //the size of the whole file, to detect a truncated file
+    uint64_t nodes, nodesOffset;             //the packed dag nodes
+    uint64_t dagSegments, dagSegmentsOffset; //the segments of the packed dag nodes
+    uint64_t trapezoids, trapezoidsOffset;   //the trapezoids of the map
+    uint64_t points, pointsOffset;           //the table of the points
+    uint64_t segments, segmentsOffset;       //the table of the segments
+};
+
+/**
+ * @brief The MappedTrapezoidalMap class
+ * A built trapezoidal map and its dag loaded from a map file. The file contains the packed dag, the
+ * trapezoids and the tables of the points and of the segments as arrays of fixed size records, which are used
+ * where they are: the file is a MappedFile, so opening a map only costs the page faults of the pages touched
+ * by the queries.
+ * The queries return the same trapezoids of the map that has been saved.
+ */
+class MappedTrapezoidalMap
+{
+    public:
+        //constructors
+        MappedTrapezoidalMap(const std::string& filename);
+
+        static void save(const std::string& filename, const TrapezoidalMap& T, const Dag& D);
+
+        //getters
+        const PackedDagNode* getNodes() const;
+        const PackedSegment* getDagSegments() const;
+        const MappedTrapezoid& getTrapezoid(size_t index) const;
+        const MappedPoint& getPoint(size_t index) const;
+        const MappedSegment& getSegment(size_t index) const;
+        size_t getNodesSize() const;
+        size_t getTsize() const;
+        size_t getPointsSize() const;
+        size_t getSegmentsSize() const;
+        bool isMemoryMapped() const;
+
+        static size_t toId(uint32_t id);
+
+    private:
+        const MappedMapHeader& header() const;
+
+        MappedFile file;     //the map file, mapped in memory or read in a buffer
+        const char * data;   //the content of the file
+};
+
+/**
+ * @brief MappedTrapezoidalMap::toId
+ * This method converts an id stored in 32 bits to the id used by the TrapezoidalMap: the values close to the
+ * maximum are the ids of the bounding box (BOUNDINGBOX_LEFTP...) or SIZE_MAX for a missing neighbor
+ * @param id an id of a MappedTrapezoid
+ * @return the same id as size_t
+ */
+inline size_t MappedTrapezoidalMap::toId(uint32_t id){
+    return id >= UINT32_MAX - 2 ? SIZE_MAX - (UINT32_MAX - id) : id;
+}
+
+#endif // MAPPED_TRAPEZOIDALMAP_H
@@ -0,0 +1,126 @@
+#include "packed_dag.h"
+
+#include <stdexcept>
+
+#define PACKED_MAX_NODES (1u << 30) //the ids of the children have 30 bits
+
+/**
+ * @brief PackedDag::PackedDag
+ * Empty constructor of the packed dag
+ */
+PackedDag::PackedDag(){
+}
+
+/**
+ * @brief PackedDag::PackedDag
+ * Constructor of the packed dag. Every node of the dag is converted in a packed node with the same id,
+ * the points of the point nodes are stored inside the nodes and the segments are copied in the segment vector.
+ * @param D the dag to pack
+ */
+PackedDag::PackedDag(const Dag& D){
+    size_t n = D.getVectorSize(DAGNODE);
+    if(n > PACKED_MAX_NODES){
+        throw std::length_error("PackedDag: too many nodes");
+    }
+
+    segments.resize(D.getVectorSize(SEGMENT));
+    for(size_t i = 0; i < segments.size(); i++){
+        const cg3::Segment2d& s = D.getElementInSVector(i);
+        segments[i] = {s.p1().x(), s.p1().y(), s.p2().x(), s.p2().y()};
+    }
+
+    nodes.resize(n);
+    for(size_t i = 0; i < n; i++){
+        const DagNode& d = D.getElementInDVector(i);
+        PackedDagNode& p = nodes[i];
+        packedNodeType type;
+        switch(d.getNodeType()){
+            case POINT:
+                type = PACKED_POINT;
+                p.x = D.getElementInPVector(d.getEntityId()).x();
+            break;
+            case SEGMENT:{
+                //a vertical segment has an infinite slope, as in the queries on the Dag, so the tie-break is the same
+                const cg3::Segment2d& s = D.getElementInSVector(d.getEntityId());
+                if(s.p1().x() != s.p2().x()){
+                    type = PACKED_SEGMENT;
+                }
+                else{
+                    type = PACKED_VERTICAL_SEGMENT;
+                }
+                p.segment = d.getEntityId();
+            }
+            break;
+            default:
+                type = PACKED_TRAPEZOID;
+                p.segment = 0;
+            break;
+        }
+        if(type == PACKED_TRAPEZOID){
+            p.left = uint32_t(d.getEntityId());
+            p.right = uint32_t(type) << 30;
+        }
+        else{
+            p.left = uint32_t(d.getLeftC());
+            p.right = uint32_t(d.getRightC()) | (uint32_t(type) << 30);
+        }
+    }
+}
+
+/**
+ * @brief PackedDag::getNode
+ * @param index the id of the node
+ * @return a reference to the packed node with the given id
+ */
+const PackedDagNode& PackedDag::getNode(size_t index) const{
+    return nodes[index];
+}
+
+/**
+ * @brief PackedDag::getSegment
+ * @param index the position of the segment
+ * @return a reference to the endpoints of the segment in the given position
+ */
+const PackedSegment& PackedDag::getSegment(size_t index) const{
+    return segments[index];
+}
+
+/**
+ * @brief PackedDag::getNodes
+ * @return a pointer to the first packed node, the root of the dag
+ */
+const PackedDagNode* PackedDag::getNodes() const{
+    return nodes.data();
+}
+
+/**
+ * @brief PackedDag::getSegments
+ * @return a pointer to the first segment
+ */
+const PackedSegment* PackedDag::getSegments() const{
+    return segments.data();
+}
+
+/**
+ * @brief PackedDag::getNodesSize
+ * @return the number of nodes of the packed dag
+ */
+size_t PackedDag::getNodesSize() const{
+    return nodes.size();
+}
+
+/**
+ * @brief PackedDag::getSegmentsSize
+ * @return the number of segments of the packed dag
+ */
+size_t PackedDag::getSegmentsSize() const{
+    return segments.size();
+}
+
+/**
+ * @brief PackedDag::getMemorySize
+ * @return the number of bytes used by the nodes and the segments of the packed dag
+ */
+size_t PackedDag::getMemorySize() const{
+    return nodes.size() * sizeof(PackedDagNode) + segments.size() * sizeof(PackedSegment);
+}
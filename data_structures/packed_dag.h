@@ -0,0 +1,85 @@
+#ifndef PACKED_DAG_H
+#define PACKED_DAG_H
+
+#include "dag.h"
+
+#include <cstdint>
+
+//the type of a node of the packed dag, stored in the two high bits of the right child.
+//A SEGMENT node whose segment is vertical is stored with its own type because the tie-break
+//of a query point lying on one of its endpoints goes to the right child instead of the left one
+enum packedNodeType {PACKED_POINT, PACKED_SEGMENT, PACKED_VERTICAL_SEGMENT, PACKED_TRAPEZOID};
+
+/**
+ * @brief The PackedDagNode struct
+ * A node of the packed dag, 16 bytes: four nodes share a cache line
+ */
+struct PackedDagNode{
+    uint32_t left;  //the id of the left child, or the id of the trapezoid if the node is a leaf
+    uint32_t right; //the id of the right child, the two high bits store the type of the node
+    union{
+        double x;         //POINT: the x coordinate of the point of the node
+        uint64_t segment; //SEGMENT: the position of the segment in the segment vector
+    };
+};
+
+/**
+ * @brief The PackedSegment struct
+ * The endpoints of a segment of the packed dag, 32 bytes: a segment never spans two cache lines
+ */
+struct alignas(32) PackedSegment{
+    double x1;
+    double y1;
+    double x2;
+    double y2;
+};
+
+/**
+ * @brief The PackedDag class
+ * A read-only copy of a Dag with a compact layout for the queries. The nodes use 32 bit child ids and
+ * store the type in their tag bits and the x coordinate of a point node inline, the segments are stored
+ * by value in a parallel vector: a query touches a node and at most one segment for every level of the dag.
+ * The ids of the nodes are the same of the Dag that has been packed.
+ */
+class PackedDag
+{
+    public:
+        //constructors
+        PackedDag();
+        PackedDag(const Dag& D);
+
+        //getters
+        const PackedDagNode& getNode(size_t index) const;
+        const PackedSegment& getSegment(size_t index) const;
+        const PackedDagNode* getNodes() const;
+        const PackedSegment* getSegments() const;
+        size_t getNodesSize() const;
+        size_t getSegmentsSize() const;
+        size_t getMemorySize() const;
+
+        //decoding of the nodes
+        static packedNodeType getNodeType(const PackedDagNode& n);
+        static uint32_t getRightC(const PackedDagNode& n);
+
+    private:
+        std::vector<PackedDagNode> nodes;   //the nodes, in the same order of the dag vector
+        std::vector<PackedSegment> segments; //the segments, in the same order of the segment vector
+};
+
+/**
+ * @brief PackedDag::getNodeType
+ * @return the type of the packed node n
+ */
+inline packedNodeType PackedDag::getNodeType(const PackedDagNode& n){
+    return packedNodeType(n.right >> 30);
+}
+
+/**
+ * @brief PackedDag::getRightC
+ * @return the id of the right child of the packed node n, without the type bits
+ */
+inline uint32_t PackedDag::getRightC(const PackedDagNode& n){
+    return n.right & 0x3fffffff;
+}
+
+#endif // PACKED_DAG_H
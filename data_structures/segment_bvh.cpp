@@ -0,0 +1,243 @@
+#include "segment_bvh.h"
+
+#include <cg3/geometry/intersections2.h>
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+#define SEGMENT_BVH_STACK 64 // the depth of the traversal stack, more than the depth of a bvh of 2^32 segments
+
+namespace {
+
+/**
+ * @brief spread
+ * @return the 16 low bits of v moved to the even bits of the result
+ */
+uint32_t spread(uint32_t v){
+    v &= 0xffff;
+    v = (v | (v << 8)) & 0x00ff00ff;
+    v = (v | (v << 4)) & 0x0f0f0f0f;
+    v = (v | (v << 2)) & 0x33333333;
+    v = (v | (v << 1)) & 0x55555555;
+    return v;
+}
+
+/**
+ * @brief quantize
+ * @return the position of v in [min, max] on 16 bits
+ */
+uint32_t quantize(double v, double min, double max){
+    if(max <= min){
+        return 0;
+    }
+    return uint32_t(std::min(65535.0, std::max(0.0, (v - min) / (max - min) * 65535.0)));
+}
+
+/**
+ * @brief overlaps
+ * @return true if the box [minX, maxX] x [minY, maxY] and the box of the node n share a point
+ */
+inline bool overlaps(const SegmentBvhNode& n, double minX, double minY, double maxX, double maxY){
+    return minX <= n.maxX && n.minX <= maxX && minY <= n.maxY && n.minY <= maxY;
+}
+
+}
+
+/**
+ * @brief SegmentBvh::SegmentBvh
+ * Empty constructor of the bvh
+ */
+SegmentBvh::SegmentBvh(){
+}
+
+/**
+ * @brief SegmentBvh::SegmentBvh
+ * Constructor of the bvh: the segments are sorted by the Morton code of the center of their bounding box,
+ * then the tree is built on the sorted segments. The construction takes O(n log n).
+ * @param segments the segments of the bvh
+ * @throws std::length_error if there are too many segments for the 32 bit ids of the nodes
+ */
+SegmentBvh::SegmentBvh(const std::vector<cg3::Segment2d>& segments){
+    if(segments.empty()){
+        return;
+    }
+    if(segments.size() >= UINT32_MAX / 2){
+        throw std::length_error("SegmentBvh: too many segments");
+    }
+
+    double minX = segments[0].p1().x(), maxX = minX, minY = segments[0].p1().y(), maxY = minY;
+    for(const cg3::Segment2d& s : segments){
+        double x = (s.p1().x() + s.p2().x()) / 2, y = (s.p1().y() + s.p2().y()) / 2;
+        minX = std::min(minX, x);
+        maxX = std::max(maxX, x);
+        minY = std::min(minY, y);
+        maxY = std::max(maxY, y);
+    }
+
+    std::vector<std::pair<uint32_t, uint32_t>> codes(segments.size());
+    for(size_t i = 0; i < segments.size(); i++){
+        const cg3::Segment2d& s = segments[i];
+        uint32_t x = quantize((s.p1().x() + s.p2().x()) / 2, minX, maxX);
+        uint32_t y = quantize((s.p1().y() + s.p2().y()) / 2, minY, maxY);
+        codes[i] = std::make_pair(spread(x) | (spread(y) << 1), uint32_t(i));
+    }
+    std::sort(codes.begin(), codes.end());
+
+    this->segments.reserve(segments.size());
+    for(const std::pair<uint32_t, uint32_t>& c : codes){
+        this->segments.push_back(segments[c.second]);
+    }
+    nodes.reserve(2 * (segments.size() + SEGMENT_BVH_LEAF - 1) / SEGMENT_BVH_LEAF);
+    build(0, segments.size());
+}
+
+/**
+ * @brief SegmentBvh::build
+ * This method builds the subtree of the sorted segments in [begin, end), in depth first order
+ * @return the id of the root of the subtree
+ */
+uint32_t SegmentBvh::build(size_t begin, size_t end){
+    uint32_t id = uint32_t(nodes.size());
+    nodes.push_back(SegmentBvhNode());
+    if(end - begin <= SEGMENT_BVH_LEAF){
+        SegmentBvhNode& n = nodes[id];
+        n.minX = n.minY = std::numeric_limits<double>::infinity();
+        n.maxX = n.maxY = -std::numeric_limits<double>::infinity();
+        for(size_t i = begin; i < end; i++){
+            const cg3::Segment2d& s = segments[i];
+            n.minX = std::min(n.minX, std::min(s.p1().x(), s.p2().x()));
+            n.minY = std::min(n.minY, std::min(s.p1().y(), s.p2().y()));
+            n.maxX = std::max(n.maxX, std::max(s.p1().x(), s.p2().x()));
+            n.maxY = std::max(n.maxY, std::max(s.p1().y(), s.p2().y()));
+        }
+        n.first = uint32_t(begin);
+        n.count = uint32_t(end - begin);
+        return id;
+    }
+
+    size_t middle = begin + (end - begin) / 2;
+    uint32_t left = build(begin, middle);
+    uint32_t right = build(middle, end);
+    SegmentBvhNode& n = nodes[id];
+    n.minX = std::min(nodes[left].minX, nodes[right].minX);
+    n.minY = std::min(nodes[left].minY, nodes[right].minY);
+    n.maxX = std::max(nodes[left].maxX, nodes[right].maxX);
+    n.maxY = std::max(nodes[left].maxY, nodes[right].maxY);
+    n.first = right;
+    n.count = 0;
+    return id;
+}
+
+/**
+ * @brief SegmentBvh::visit
+ * This method visits the segments of the bvh that intersect s, the visit stops when the visitor returns true
+ * @param s the query segment
+ * @param visitor called with every segment that intersects s
+ * @return true if the visit has been stopped by the visitor
+ */
+template<typename Visitor>
+bool SegmentBvh::visit(const cg3::Segment2d& s, Visitor& visitor) const{
+    if(nodes.empty()){
+        return false;
+    }
+    double minX = std::min(s.p1().x(), s.p2().x()), maxX = std::max(s.p1().x(), s.p2().x());
+    double minY = std::min(s.p1().y(), s.p2().y()), maxY = std::max(s.p1().y(), s.p2().y());
+
+    uint32_t stack[SEGMENT_BVH_STACK];
+    size_t top = 0;
+    stack[top++] = 0;
+    while(top > 0){
+        uint32_t id = stack[--top];
+        const SegmentBvhNode& n = nodes[id];
+        if(!overlaps(n, minX, minY, maxX, maxY)){
+            continue;
+        }
+        if(n.count == 0){
+            stack[top++] = n.first;
+            stack[top++] = id + 1; //the left child is visited first
+            continue;
+        }
+        for(uint32_t i = n.first; i < n.first + n.count; i++){
+            const cg3::Segment2d& t = segments[i];
+            if(std::min(t.p1().x(), t.p2().x()) <= maxX && minX <= std::max(t.p1().x(), t.p2().x()) &&
+                    std::min(t.p1().y(), t.p2().y()) <= maxY && minY <= std::max(t.p1().y(), t.p2().y()) &&
+                    checkSegmentIntersection(s, t) && visitor(t)){
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief SegmentBvh::findIntersection
+ * @param s the query segment
+ * @return a segment of the bvh that intersects s, nullptr if there isn't any
+ */
+const cg3::Segment2d* SegmentBvh::findIntersection(const cg3::Segment2d& s) const{
+    const cg3::Segment2d* found = nullptr;
+    auto visitor = [&found](const cg3::Segment2d& t){
+        found = &t;
+        return true;
+    };
+    visit(s, visitor);
+    return found;
+}
+
+/**
+ * @brief SegmentBvh::countIntersections
+ * @param s the query segment
+ * @return the number of segments of the bvh that intersect s
+ */
+size_t SegmentBvh::countIntersections(const cg3::Segment2d& s) const{
+    size_t count = 0;
+    auto visitor = [&count](const cg3::Segment2d&){
+        count++;
+        return false;
+    };
+    visit(s, visitor);
+    return count;
+}
+
+/**
+ * @brief SegmentBvh::getSegments
+ * @return the segments of the bvh, in the order of the leaves
+ */
+const std::vector<cg3::Segment2d>& SegmentBvh::getSegments() const{
+    return segments;
+}
+
+/**
+ * @brief SegmentBvh::size
+ * @return the number of segments of the bvh
+ */
+size_t SegmentBvh::size() const{
+    return segments.size();
+}
+
+/**
+ * @brief SegmentBvh::empty
+ * @return true if the bvh has no segments
+ */
+bool SegmentBvh::empty() const{
+    return segments.empty();
+}
+
+/**
+ * @brief SegmentBvh::clear
+ * This method removes all the segments of the bvh
+ */
+void SegmentBvh::clear(){
+    nodes.clear();
+    segments.clear();
+}
+
+/**
+ * @brief SegmentBvh::checkSegmentIntersection
+ * @return true if the segments s1 and s2 intersect in a point that is not a common endpoint
+ */
+bool SegmentBvh::checkSegmentIntersection(const cg3::Segment2d& s1, const cg3::Segment2d& s2){
+    return cg3::checkSegmentIntersection2(s1, s2, true);
+}
@@ -0,0 +1,63 @@
+#ifndef SEGMENT_BVH_H
+#define SEGMENT_BVH_H
+
+#include <cg3/geometry/segment2.h>
+
+#include <cstdint>
+#include <vector>
+
+#define SEGMENT_BVH_LEAF 4 // the maximum number of segments of a leaf of the bvh
+
+/**
+ * @brief The SegmentBvhNode struct
+ * A node of the bvh, 40 bytes: the bounding box of its segments and, for a leaf, the range of its segments.
+ * The left child of an inner node is the next node of the array, so only the right child is stored.
+ */
+struct SegmentBvhNode{
+    double minX;
+    double minY;
+    double maxX;
+    double maxY;
+    uint32_t first; //leaf: the position of the first segment, inner node: the id of the right child
+    uint32_t count; //leaf: the number of segments, inner node: 0
+};
+
+/**
+ * @brief The SegmentBvh class
+ * A bounding volume hierarchy of a set of segments, built at once. The segments are sorted by the Morton code
+ * of the center of their bounding box, so close segments are in the same leaves, and the tree is built by
+ * splitting the sorted range in halves. The nodes are stored in an array in depth first order, so a query
+ * visits the nodes in the order in which they are stored, and the segments are stored in the order of the leaves.
+ * The bvh is read-only: the queries can run on several threads.
+ */
+class SegmentBvh
+{
+    public:
+        //constructors
+        SegmentBvh();
+        SegmentBvh(const std::vector<cg3::Segment2d>& segments);
+
+        //queries
+        const cg3::Segment2d* findIntersection(const cg3::Segment2d& s) const;
+        size_t countIntersections(const cg3::Segment2d& s) const;
+
+        //getters
+        const std::vector<cg3::Segment2d>& getSegments() const;
+        size_t size() const;
+        bool empty() const;
+
+        void clear();
+
+        static bool checkSegmentIntersection(const cg3::Segment2d& s1, const cg3::Segment2d& s2);
+
+    private:
+        uint32_t build(size_t begin, size_t end);
+
+        template<typename Visitor>
+        bool visit(const cg3::Segment2d& s, Visitor& visitor) const;
+
+        std::vector<SegmentBvhNode> nodes;     //the nodes, the root is the first one
+        std::vector<cg3::Segment2d> segments;  //the segments, in the order of the leaves
+};
+
+#endif // SEGMENT_BVH_H
@@ -1,78 +1,195 @@
 #include "segment_intersection_checker.h"
 
-#include <cg3/geometry/intersections2.h>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+#define SEGMENT_CHECKER_CHUNK 1024 // the minimum number of segments checked by a thread of a batch query
+
+namespace {
+
+/**
+ * @brief Runs task(begin, end) on contiguous ranges of [0, n) on several threads
+ * @param n The number of elements
+ * @param threads The number of threads, 0 to use all the cores of the machine
+ * @param task The function called for every range
+ */
+template<typename Task>
+void parallelRanges(size_t n, size_t threads, const Task& task)
+{
+    if (threads == 0) {
+        threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+    }
+    threads = std::max<size_t>(1, std::min(threads, n / SEGMENT_CHECKER_CHUNK));
+    if (threads == 1) {
+        task(size_t(0), n);
+        return;
+    }
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threads; t++) {
+        workers.push_back(std::thread(task, n * t / threads, n * (t + 1) / threads));
+    }
+    for (std::thread& w : workers) {
+        w.join();
+    }
+}
+
+}
 
 SegmentIntersectionChecker::SegmentIntersectionChecker()
-    : aabbTree(&aabbValueExtractor),
-      keyOverlapChecker(&checkSegmentIntersection)
 {
 
 }
 
+/**
+ * @brief Inserts a segment. The segment is added to the buffer, and when the buffer is full its segments are
+ * merged with the smallest bvhs in a new bvh, as in a binary counter.
+ * @param seg The segment
+ */
 void SegmentIntersectionChecker::insert(const cg3::Segment2d& seg) {
-    aabbTree.insert(seg);
-}
+    buffer.push_back(seg);
+    if (buffer.size() < SEGMENT_CHECKER_BUFFER) {
+        return;
+    }
 
-size_t SegmentIntersectionChecker::countIntersections(const cg3::Segment2d& seg) {
-    std::vector<cg3::AABBTree<2, cg3::Segment2d>::iterator> out;
-    aabbTree.aabbOverlapQuery(seg, std::back_inserter(out), this->keyOverlapChecker);
-    return out.size();
+    std::vector<cg3::Segment2d> carry;
+    carry.swap(buffer);
+    for (size_t i = 0; ; i++) {
+        if (i == levels.size()) {
+            levels.push_back(SegmentBvh());
+        }
+        if (levels[i].empty() && carry.size() <= (size_t(SEGMENT_CHECKER_BUFFER) << i)) {
+            levels[i] = SegmentBvh(carry);
+            return;
+        }
+        carry.insert(carry.end(), levels[i].getSegments().begin(), levels[i].getSegments().end());
+        levels[i].clear();
+    }
 }
 
-bool SegmentIntersectionChecker::checkIntersections(const cg3::Segment2d& seg) {
-    return aabbTree.aabbOverlapCheck(seg, this->keyOverlapChecker);
+/**
+ * @brief Replaces the segments of the checker with a set of segments, in a single bvh
+ * @param segVec The segments
+ */
+void SegmentIntersectionChecker::construction(const std::vector<cg3::Segment2d>& segVec) {
+    clear();
+    if (segVec.empty()) {
+        return;
+    }
+    size_t level = 0;
+    while ((size_t(SEGMENT_CHECKER_BUFFER) << level) < segVec.size()) {
+        level++;
+    }
+    levels.resize(level + 1);
+    levels[level] = SegmentBvh(segVec);
 }
 
-size_t SegmentIntersectionChecker::countIntersection(const std::vector<cg3::Segment2d>& segVec) {
+size_t SegmentIntersectionChecker::countIntersections(const cg3::Segment2d& seg) const {
     size_t result = 0;
-    for (const cg3::Segment2d& seg : segVec) {
-        std::vector<cg3::AABBTree<2, cg3::Segment2d>::iterator> out;
-        aabbTree.aabbOverlapQuery(seg, std::back_inserter(out), this->keyOverlapChecker);
-        result += out.size();
+    for (const SegmentBvh& bvh : levels) {
+        result += bvh.countIntersections(seg);
+    }
+    for (const cg3::Segment2d& s : buffer) {
+        result += checkSegmentIntersection(seg, s) ? 1 : 0;
     }
     return result;
 }
 
-bool SegmentIntersectionChecker::checkIntersections(const std::vector<cg3::Segment2d>& segVec) {
-    for (const cg3::Segment2d& seg : segVec) {
-        if (aabbTree.aabbOverlapCheck(seg, this->keyOverlapChecker)) {
+bool SegmentIntersectionChecker::checkIntersections(const cg3::Segment2d& seg) const {
+    cg3::Segment2d intersected;
+    return findIntersection(seg, intersected);
+}
+
+/**
+ * @brief Finds a segment of the checker that intersects seg
+ * @param seg The query segment
+ * @param intersected The segment that intersects seg, if any
+ * @return True if a segment intersects seg
+ */
+bool SegmentIntersectionChecker::findIntersection(const cg3::Segment2d& seg, cg3::Segment2d& intersected) const {
+    for (const cg3::Segment2d& s : buffer) {
+        if (checkSegmentIntersection(seg, s)) {
+            intersected = s;
+            return true;
+        }
+    }
+    for (const SegmentBvh& bvh : levels) {
+        const cg3::Segment2d* s = bvh.findIntersection(seg);
+        if (s != nullptr) {
+            intersected = *s;
             return true;
         }
     }
     return false;
 }
 
-double SegmentIntersectionChecker::aabbValueExtractor(
-        const cg3::Segment2d& segment,
-        const cg3::AABBValueType& valueType,
-        const int& dim)
-{
-    if (valueType == cg3::AABBValueType::MIN) {
-        switch (dim) {
-        case 1:
-            return static_cast<double>(std::min(segment.p1().x(), segment.p2().x()));
-        case 2:
-            return static_cast<double>(std::min(segment.p1().y(), segment.p2().y()));
+/**
+ * @brief Counts the intersections of a set of segments with the segments of the checker, on several threads
+ * @param segVec The query segments
+ * @param threads The number of threads, 0 to use all the cores of the machine
+ * @return The sum of the intersections of every query segment
+ */
+size_t SegmentIntersectionChecker::countIntersection(const std::vector<cg3::Segment2d>& segVec, size_t threads) const {
+    std::atomic<size_t> result(0);
+    parallelRanges(segVec.size(), threads, [&](size_t begin, size_t end) {
+        size_t count = 0;
+        for (size_t i = begin; i < end; i++) {
+            count += countIntersections(segVec[i]);
         }
-    }
-    else if (valueType == cg3::AABBValueType::MAX) {
-        switch (dim) {
-        case 1:
-            return static_cast<double>(std::max(segment.p1().x(), segment.p2().x()));
-        case 2:
-            return static_cast<double>(std::max(segment.p1().y(), segment.p2().y()));
+        result += count;
+    });
+    return result;
+}
+
+/**
+ * @brief Checks if any segment of a set intersects the segments of the checker, on several threads.
+ * The threads stop as soon as an intersection is found.
+ * @param segVec The query segments
+ * @param threads The number of threads, 0 to use all the cores of the machine
+ * @return True if a query segment intersects a segment of the checker
+ */
+bool SegmentIntersectionChecker::checkIntersections(const std::vector<cg3::Segment2d>& segVec, size_t threads) const {
+    std::atomic<bool> found(false);
+    parallelRanges(segVec.size(), threads, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end && !found.load(std::memory_order_relaxed); i++) {
+            if (checkIntersections(segVec[i])) {
+                found = true;
+            }
         }
-    }
-    throw new std::runtime_error("Impossible to extract an AABB value.");
+    });
+    return found;
 }
 
+/**
+ * @brief Checks every segment of a set against the segments of the checker, on several threads
+ * @param segVec The query segments
+ * @param intersecting For every query segment, 1 if it intersects a segment of the checker, 0 otherwise
+ * @param threads The number of threads, 0 to use all the cores of the machine
+ */
+void SegmentIntersectionChecker::checkIntersections(const std::vector<cg3::Segment2d>& segVec, std::vector<char>& intersecting, size_t threads) const {
+    intersecting.resize(segVec.size());
+    parallelRanges(segVec.size(), threads, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            intersecting[i] = checkIntersections(segVec[i]) ? 1 : 0;
+        }
+    });
+}
+
+size_t SegmentIntersectionChecker::size() const {
+    size_t result = buffer.size();
+    for (const SegmentBvh& bvh : levels) {
+        result += bvh.size();
+    }
+    return result;
+}
 
 bool SegmentIntersectionChecker::checkSegmentIntersection(const cg3::Segment2d& seg1, const cg3::Segment2d& seg2)
 {
-    return cg3::checkSegmentIntersection2(seg1, seg2, true);
+    return SegmentBvh::checkSegmentIntersection(seg1, seg2);
 }
 
 void SegmentIntersectionChecker::clear()
 {
-    aabbTree.clear();
+    levels.clear();
+    buffer.clear();
 }
@@ -1,32 +1,37 @@
 #ifndef SEGMENTINTERSECTIONCHECKER_H
 #define SEGMENTINTERSECTIONCHECKER_H
 
-#include <cg3/data_structures/trees/aabbtree.h>
 #include <cg3/geometry/segment2.h>
 
+#include "data_structures/segment_bvh.h"
 
+#define SEGMENT_CHECKER_BUFFER 32 // the number of inserted segments kept out of the bvhs
+
+/**
+ * @brief This class checks if a segment intersects the segments of a set. The segments are stored
+ * in flat bvhs built at once: a set built with construction() is a single bvh, while the segments inserted
+ * one at a time are collected in a small buffer and then merged in bvhs whose sizes grow as powers of two,
+ * so an insertion takes O(log^2 n) amortized time and a query visits O(log n) bvhs.
+ * The queries don't modify the checker, so the batch queries run on several threads.
+ */
 class SegmentIntersectionChecker {
 
 public:
 
-    typedef cg3::AABBTree<2, cg3::Segment2d> AABBTree;
-    typedef AABBTree::KeyOverlapChecker KeyOverlapChecker;
-
     SegmentIntersectionChecker();
 
     void insert(const cg3::Segment2d& seg);
+    void construction(const std::vector<cg3::Segment2d>& segVec);
 
-    size_t countIntersections(const cg3::Segment2d& seg);
-    bool checkIntersections(const cg3::Segment2d& seg);
-
-    size_t countIntersection(const std::vector<cg3::Segment2d>& segVec);
-    bool checkIntersections(const std::vector<cg3::Segment2d>& segVec);
+    size_t countIntersections(const cg3::Segment2d& seg) const;
+    bool checkIntersections(const cg3::Segment2d& seg) const;
+    bool findIntersection(const cg3::Segment2d& seg, cg3::Segment2d& intersected) const;
 
+    size_t countIntersection(const std::vector<cg3::Segment2d>& segVec, size_t threads = 0) const;
+    bool checkIntersections(const std::vector<cg3::Segment2d>& segVec, size_t threads = 0) const;
+    void checkIntersections(const std::vector<cg3::Segment2d>& segVec, std::vector<char>& intersecting, size_t threads = 0) const;
 
-    static double aabbValueExtractor(
-            const cg3::Segment2d& segment,
-            const cg3::AABBValueType& valueType,
-            const int& dim);
+    size_t size() const;
 
     static bool checkSegmentIntersection(
             const cg3::Segment2d& seg1, const cg3::Segment2d& seg2);
@@ -35,8 +40,8 @@ public:
 
 private:
 
-    AABBTree aabbTree;
-    KeyOverlapChecker keyOverlapChecker;
+    std::vector<SegmentBvh> levels;        //the bvh of level i has at most SEGMENT_CHECKER_BUFFER * 2^i segments
+    std::vector<cg3::Segment2d> buffer;    //the last inserted segments, not yet in a bvh
 
 };
 
@@ -1,75 +1,54 @@
 #include "trapezoid.h"
+
+#include <stdexcept>
+
 /**
  * @brief Trapezoid::Trapezoid
  * This constructor initializes a trapezoid by initializing each of the four attributes with the values in input.
  * The neighbor array is initialized as well.
- * @param leftp the point to the left of the trapezoid
- * @param rightp the point to the right of the trapezoid
- * @param top the segment above the trapezoid
- * @param bottom the segment below the trapezoid
- */
-Trapezoid::Trapezoid(cg3::Point2d leftp, cg3::Point2d rightp, cg3::Segment2d top, cg3::Segment2d bottom):
-    leftp(leftp), rightp(rightp), bottom(bottom), top(top), color(cg3::Color(rand()%256, rand()%256, rand()%256)),
-    borderColor(cg3::Color(0,0,0)), borderWidth(2), dagIndex(SIZE_MAX)
+ * @param leftp the id of the point to the left of the trapezoid
+ * @param rightp the id of the point to the right of the trapezoid
+ * @param top the id of the segment above the trapezoid
+ * @param bottom the id of the segment below the trapezoid
+ */
+Trapezoid::Trapezoid(size_t leftp, size_t rightp, size_t top, size_t bottom):
+    leftp(leftp), rightp(rightp), top(top), bottom(bottom), trapIndex(SIZE_MAX), dagIndex(SIZE_MAX)
 {
     setEmptyNeighbors();
 }
 
 /**
- * @brief Trapezoid::getLeftp
- * @return the point to the left of the trapezoid
+ * @brief Trapezoid::getLeftpId
+ * @return the id of the point to the left of the trapezoid
  */
-const cg3::Point2d Trapezoid::getLeftp() const{
+size_t Trapezoid::getLeftpId() const{
     return this->leftp;
 }
 
 /**
- * @brief Trapezoid::getRightp
- * @return the point to the right of the trapezoid
+ * @brief Trapezoid::getRightpId
+ * @return the id of the point to the right of the trapezoid
  */
-const cg3::Point2d Trapezoid::getRightp() const{
+size_t Trapezoid::getRightpId() const{
     return this->rightp;
 }
 
 /**
- * @brief Trapezoid::getBottom
- * @return the segment below the trapezoid
+ * @brief Trapezoid::getBottomId
+ * @return the id of the segment below the trapezoid
  */
-const cg3::Segment2d Trapezoid::getBottom() const{
+size_t Trapezoid::getBottomId() const{
     return this->bottom;
 }
 
 /**
- * @brief Trapezoid::getTop
- * @return the segment above the trapezoid
+ * @brief Trapezoid::getTopId
+ * @return the id of the segment above the trapezoid
  */
-const cg3::Segment2d Trapezoid::getTop() const{
+size_t Trapezoid::getTopId() const{
     return this->top;
 }
 
-/**
- * @brief Trapezoid::getColor
- * @return the color to use for drawing the trapezoid
- */
-const cg3::Color Trapezoid::getColor() const{
-    return this->color;
-}
-
-/**
- * @brief Trapezoid::getBorderColor
- * @return the color to use for the border of the trapezoid
- */
-const cg3::Color Trapezoid::getBorderColor() const{
-    return this->borderColor;
-}
-/**
- * @brief Trapezoid::getBorderWidth
- * @return the value of the width to use for the border of the trapezoid
- */
-size_t Trapezoid::getBorderWidth() const{
-    return this->borderWidth;
-}
-
 /**
  * @brief Trapezoid::getId
  * @return the numeric id which identifies the trapezoid
@@ -86,38 +65,38 @@ size_t Trapezoid::getDagId() const{
     return this->dagIndex;
 }
 /**
- * @brief Trapezoid::setLeftp
- * This method sets the value of the left point member of the trapezoid
- * @param leftp the point to set as left
+ * @brief Trapezoid::setLeftpId
+ * This method sets the id of the point to the left of the trapezoid
+ * @param leftp the id of the point to set as left
  */
-void Trapezoid::setLeftp(cg3::Point2d leftp){
+void Trapezoid::setLeftpId(size_t leftp){
     this->leftp = leftp;
 }
 
 /**
- * @brief Trapezoid::setRightp
- * This method sets the value of the right point member of the trapezoid
- * @param rightp the point to set as right
+ * @brief Trapezoid::setRightpId
+ * This method sets the id of the point to the right of the trapezoid
+ * @param rightp the id of the point to set as right
  */
-void Trapezoid::setRightp(cg3::Point2d rightp) {
+void Trapezoid::setRightpId(size_t rightp) {
     this->rightp = rightp;
 }
 
 /**
- * @brief Trapezoid::setBottom
- * This method sets the value of the bottom member of the trapezoid
- * @param bottom the segment to set as bottom
+ * @brief Trapezoid::setBottomId
+ * This method sets the id of the segment below the trapezoid
+ * @param bottom the id of the segment to set as bottom
  */
-void Trapezoid::setBottom(cg3::Segment2d bottom){
+void Trapezoid::setBottomId(size_t bottom){
     this->bottom = bottom;
 }
 
 /**
- * @brief Trapezoid::setTop
- * This method sets the value of the top member of the trapezoid
- * @param top the segment to set as top
+ * @brief Trapezoid::setTopId
+ * This method sets the id of the segment above the trapezoid
+ * @param top the id of the segment to set as top
  */
-void Trapezoid::setTop(cg3::Segment2d top){
+void Trapezoid::setTopId(size_t top){
     this->top = top;
 }
 
@@ -130,41 +109,14 @@ void Trapezoid::setId(size_t index){
     trapIndex = index;
 }
 
-/**
- * @brief Trapezoid::setColor
- * This method sets the value of the color to use for filling the trapezoid
- * @param color the color to set
- */
-void Trapezoid::setColor(cg3::Color color){
-    this->color = color;
-}
-
-/**
- * @brief Trapezoid::setBorderColor
- * This method sets the value of the color to use for the border of the trapezoid
- * @param color the color to set
- */
-void Trapezoid::setBorderColor(cg3::Color color){
-    this->borderColor = color;
-}
-
-/**
- * @brief Trapezoid::setBorderWidth
- * This method sets the value of the border width of the trapezoid
- * @param width the value of the width to set
- */
-void Trapezoid::setBorderWidth(size_t width){
-    this->borderWidth = width;
-}
-
 /**
  * @brief Trapezoid::setEmptyNeighbors
- * This method initializes every element of the neighbor array with a placeholder value (SIZE_MAX)
- * that indicates that the trapezoid doesn't have a neighbor for that position
+ * This method initializes every element of the neighbor array with a placeholder value (UINT32_MAX, returned as
+ * SIZE_MAX by getNeighbor()) that indicates that the trapezoid doesn't have a neighbor for that position
  */
 void Trapezoid::setEmptyNeighbors(){
     for(size_t i = 0; i <= 3; i++){
-        neighbors[i] = SIZE_MAX;
+        neighbors[i] = UINT32_MAX;
     }
 }
 
@@ -175,42 +127,28 @@ void Trapezoid::setEmptyNeighbors(){
  * @param index the position of the neighbor id to return
  * @return the id of the trapezoid that is the neighbor in that position
  */
-size_t Trapezoid::getNeighbor(size_t index){
-    return neighbors[index];
+size_t Trapezoid::getNeighbor(size_t index) const{
+    return neighbors[index] == UINT32_MAX ? SIZE_MAX : neighbors[index];
 }
 
-/**
- * @brief Trapezoid::getNeighbors
- * @return the vector of neighbors of the current trapezoid
- */
-size_t* Trapezoid::getNeighbors(){
-    return neighbors;
-}
-
-
-
 /**
  * @brief Trapezoid::setNeighbor
- * This method replaces the value in the position index with the value rep passed as parameter
+ * This method replaces the value in the position index with the value rep passed as parameter.
+ * The ids are stored in 32 bits, an id that doesn't fit throws std::length_error.
  * @param index the position of the neighbor array in which replace the value
- * @param rep the new value for that position
+ * @param rep the new value for that position, SIZE_MAX for a missing neighbor
  */
 void Trapezoid::setNeighbor(size_t index, size_t rep){
-    neighbors[index] = rep;
-}
-
-
-/**
- * @brief Trapezoid::setNeighbor
- * This method replaces the value in the position index with the value rep passed as parameter
- * @param index the position of the neighbor array in which replace the value
- * @param rep the new value for that position
- */
-void Trapezoid::setNeighbors(size_t neighbors[]){
-    for(size_t i = 0; i < 4; i++){
-        this->neighbors[i] = neighbors[i];
+    if(rep == SIZE_MAX){
+        neighbors[index] = UINT32_MAX;
+        return;
     }
+    if(rep >= UINT32_MAX){
+        throw std::length_error("Trapezoid: too many trapezoids for a 32 bit neighbor id");
+    }
+    neighbors[index] = uint32_t(rep);
 }
+
 /**
  * @brief Trapezoid::setDagId
  * This method sets the attribute that represent the position in the dag in which the trapezoid is stored
@@ -3,11 +3,9 @@
 
 #include <cg3/geometry/point2.h>
 #include <cg3/geometry/segment2.h>
-#include <cg3/utilities/color.h>
+#include <cstdint>
 #define BOUNDINGBOX 1e+6 // the length of a side of the bounding box
 
-enum coincidence{NONE,LEFT,RIGHT,BOTH};
-
 class Trapezoid
 {
 
@@ -15,47 +13,37 @@ public:
 
     //constructors
     Trapezoid() = default;
-    Trapezoid(cg3::Point2d leftp, cg3::Point2d rightp, cg3::Segment2d top, cg3::Segment2d bottom);
+    Trapezoid(size_t leftp, size_t rightp, size_t top, size_t bottom);
 
     //getters
-    const cg3::Point2d getLeftp() const;
-    const cg3::Point2d getRightp() const;
-    const cg3::Segment2d getBottom() const;
-    const cg3::Segment2d getTop() const;
-    const cg3::Color getColor() const;
-    const cg3::Color getBorderColor() const;
-    size_t getBorderWidth() const;
+    size_t getLeftpId() const;
+    size_t getRightpId() const;
+    size_t getTopId() const;
+    size_t getBottomId() const;
     size_t getId() const;
-    size_t getNeighbor(size_t index);
-    size_t* getNeighbors();
+    size_t getNeighbor(size_t index) const;
     size_t getDagId() const;
 
     //setters
-    void setLeftp(cg3::Point2d leftp);
-    void setRightp(cg3::Point2d rightp);
-    void setBottom(cg3::Segment2d bottom);
-    void setTop(cg3::Segment2d top);
-    void setColor(cg3::Color color);
+    void setLeftpId(size_t leftp);
+    void setRightpId(size_t rightp);
+    void setTopId(size_t top);
+    void setBottomId(size_t bottom);
     void setId(size_t index);
-    void setBorderColor(cg3::Color color);
-    void setBorderWidth(size_t width);
     void setEmptyNeighbors();
     void setNeighbor(size_t index, size_t rep);
-    void setNeighbors(size_t neighbors[]);
     void setDagId(size_t index);
 
 private:
 
-    //attributes of a Trapezoid
-    cg3::Point2d leftp;     //the point to the left of the trapezoid
-    cg3::Point2d rightp;    //the point to the right of the trapezoid
-    cg3::Segment2d bottom;  //the segment below the trapezoid
-    cg3::Segment2d top;     //the segment above the trapezoid
-    cg3::Color color;       //the color for filling the trapezoid
-    cg3::Color borderColor; //the color of the border of the trapezoid
-    size_t borderWidth;     //the width of the border of the trapezoid
+    //attributes of a Trapezoid, the points and the segments are ids in the tables of the TrapezoidalMap.
+    //The attributes used for drawing are stored in the DrawableTrapezoidalMap
+    size_t leftp;           //the id of the point to the left of the trapezoid
+    size_t rightp;          //the id of the point to the right of the trapezoid
+    size_t top;             //the id of the segment above the trapezoid
+    size_t bottom;          //the id of the segment below the trapezoid
+    uint32_t neighbors[4];  //the array of the index of neighbors of a trapezoid, UINT32_MAX if there is no neighbor
     size_t trapIndex;       //the id of the trapezoid, the position in the trapezoidalmap
-    size_t neighbors[4];     //the array of the index of neighbors of a trapezoid
     size_t dagIndex;        //the position in which the element is stored in the dag
 };
 
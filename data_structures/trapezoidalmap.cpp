@@ -7,9 +7,12 @@
 /**
  * @brief TrapezoidalMap::TrapezoidalMap
  * This is the constructor of the trapezoidal map. This constructor calls the method which inserts the trapezoid
- * representing the bounding box into the vector.
+ * representing the bounding box into the table.
  */
-TrapezoidalMap::TrapezoidalMap()
+TrapezoidalMap::TrapezoidalMap():
+    removedCount(0), boxLeftp(-BOUNDINGBOX,-BOUNDINGBOX), boxRightp(BOUNDINGBOX,-BOUNDINGBOX),
+    boxTop(cg3::Point2d(-BOUNDINGBOX,BOUNDINGBOX),cg3::Point2d(BOUNDINGBOX,BOUNDINGBOX)),
+    boxBottom(cg3::Point2d(-BOUNDINGBOX,-BOUNDINGBOX),cg3::Point2d(BOUNDINGBOX,-BOUNDINGBOX))
 {
     insertBoundingBoxT();
 }
@@ -19,61 +22,65 @@ TrapezoidalMap::TrapezoidalMap()
  * This method inserts the trapezoid representing the bounding box into the trapezoidal map
  */
 void TrapezoidalMap::insertBoundingBoxT(){
-    Trapezoid t = Trapezoid(cg3::Point2d(-BOUNDINGBOX,-BOUNDINGBOX),
-                  cg3::Point2d(BOUNDINGBOX,-BOUNDINGBOX),
-                  cg3::Segment2d(cg3::Point2d(-BOUNDINGBOX,BOUNDINGBOX),cg3::Point2d(BOUNDINGBOX,BOUNDINGBOX)),
-                  cg3::Segment2d(cg3::Point2d(-BOUNDINGBOX,-BOUNDINGBOX),cg3::Point2d(BOUNDINGBOX,-BOUNDINGBOX))
-                  );
+    Trapezoid t = Trapezoid(BOUNDINGBOX_LEFTP, BOUNDINGBOX_RIGHTP, BOUNDINGBOX_TOP, BOUNDINGBOX_BOTTOM);
     t.setId(0); //the bounding box is the first trapezoid to be inserted, thus it occupies the position 0
-    t.setColor(cg3::Color(144,238,144)); //the color of the bounding box is light green
     t.setDagId(0);
-    t_map.push_back(t); //the trapezoid is inserted at the end of the vector
+    t_map.pushBack(t); //the trapezoid is inserted at the end of the table
 }
 
 /**
  * @brief TrapezoidalMap::getMap
- * @return the vector containing the trapezoids of the trapezoidal map
+ * @return a read-only reference to the table containing the trapezoids of the trapezoidal map
  */
-const std::vector<Trapezoid> TrapezoidalMap::getMap() const{
+const Arena<Trapezoid>& TrapezoidalMap::getMap() const{
     return t_map;
 }
 
 /**
  * @brief TrapezoidalMap::insertTrapezoid
- * This method sets the id of a trapezoid, inserts the trapezoid into the vector and returns the position
+ * This method sets the id of a trapezoid, inserts the trapezoid into the table and returns the position
  * in which the trapezoid is inserted
  * @param t the reference to the trapezoid to insert
  * @return the position in which the trapezoid is inserted
  */
 size_t TrapezoidalMap::insertTrapezoid(Trapezoid& t){
     t.setId(t_map.size()); //size of the map = index of the last element + 1 and the new trapezoid will be
-    t_map.push_back(t); //insert the trapezoid in the last position of the vector
-    return t_map.size() - 1;
+    return t_map.pushBack(t); //insert the trapezoid in the last position of the table
 }
 
 /**
  * @brief TrapezoidalMap::replaceTrapezoid
  * When a segment is inserted, the trapezoids intersected
  * are deleted and replaced with new trapezoids and this method manages this operation.
- * @param index the position in the vector of the trapezoid to delete
+ * The neighbors of the new trapezoid are the ones set in t.
+ * @param index the position in the table of the trapezoid to delete
  * @param t the trapezoid to insert at his place
  */
 void TrapezoidalMap::replaceTrapezoid(size_t index, Trapezoid& t){
-    t.setNeighbors(t_map[index].getNeighbors());
     t.setId(index);     //the new trapezoid will now have the id of the old trapezoid
-    t_map[index] = t;   //the old trapezoid is replaced with the new in the vector
+    t_map[index] = t;   //the old trapezoid is replaced with the new in the table
 }
 
 /**
  * @brief TrapezoidalMap::getTrapezoid
  * This method returns a reference of the trapezoid in the position passed as parameter
- * @param index the position in which the trapezoid to return is stored in the vector
+ * @param index the position in which the trapezoid to return is stored in the table
  * @return the trapezoid in the position index
  */
 Trapezoid& TrapezoidalMap::getTrapezoid(size_t index){
     return t_map[index];
 }
 
+/**
+ * @brief TrapezoidalMap::getTrapezoid
+ * Read-only version of getTrapezoid, used by the algorithms that only visit the map
+ * @param index the position in which the trapezoid to return is stored in the table
+ * @return a const reference to the trapezoid in the position index
+ */
+const Trapezoid& TrapezoidalMap::getTrapezoid(size_t index) const{
+    return t_map[index];
+}
+
 /**
  * @brief TrapezoidalMap::getTsize
  * @return the number of trapezoids stored in the Trapezoidal Map
@@ -85,14 +92,50 @@ size_t TrapezoidalMap::getTsize() const{
 /**
  * @brief TrapezoidalMap::clearTmap
  * This method clears the trapezoidal map. It is called when the "clear" button is pressed in the interface.
- * Firstly, all elements are removed from the vector and then the Trapezoid of the Bounding Box is reinserted
- * into the trapezoidal map
+ * Firstly, all elements are removed from the tables and then the Trapezoid of the Bounding Box is reinserted
+ * into the trapezoidal map. The tables are arenas, so they are released without visiting their elements.
  */
 void TrapezoidalMap::clearTmap(){
-    t_map.clear(); //remove all elements from the vector of the trapezoidal map
+    t_map.clear(); //remove all elements from the table of the trapezoidal map
+    points.clear();
+    segments.clear();
+    segmentPoints.clear();
+    pointMap.clear();
+    removedSegments.clear();
+    removedCount = 0;
     insertBoundingBoxT(); //insert the trapezoid of the bounding box in the trapezoidal map
 }
 
+/**
+ * @brief TrapezoidalMap::clearTrapezoids
+ * This method removes the trapezoids and leaves only the bounding box, the points and the segments are kept with
+ * their ids. It is used to build the map again from the segments that are still in it.
+ */
+void TrapezoidalMap::clearTrapezoids(){
+    t_map.clear();
+    insertBoundingBoxT();
+}
+
+/**
+ * @brief TrapezoidalMap::removeLastTrapezoid
+ * This method removes the trapezoid at the end of the table. The removal of a segment moves the last trapezoid in the
+ * place of a trapezoid that is no longer in the map and then removes it, so the ids of the trapezoids stay contiguous.
+ */
+void TrapezoidalMap::removeLastTrapezoid(){
+    t_map.resize(t_map.size() - 1);
+}
+
+/**
+ * @brief TrapezoidalMap::resizeTrapezoids
+ * This method changes the number of trapezoids in the table, the new positions are then filled with
+ * replaceTrapezoid(). It lets several threads store the trapezoids of a map built in parallel, each one in
+ * its own positions.
+ * @param n the new number of trapezoids
+ */
+void TrapezoidalMap::resizeTrapezoids(size_t n){
+    t_map.resize(n);
+}
+
 /**
  * @brief TrapezoidalMap::getNeighbor
  * This method returns for the trapezoid trap the id of the neighbor in the position indicated by the parameter index.
@@ -117,26 +160,7 @@ void TrapezoidalMap::setNeighbor(size_t trap, size_t index, size_t rep){
     t_map[trap].setNeighbor(index,rep);
 }
 
-void TrapezoidalMap::updateOldNeighbors(bool left, size_t curr_trap, size_t old_trap, size_t new_trap){
-    if (curr_trap != SIZE_MAX){
-        if(left){
-            if(getTrapezoid(curr_trap).getNeighbor(TOP_LEFT) == old_trap){
-                setNeighbor(curr_trap,TOP_LEFT,new_trap);
-            }
-            if(getTrapezoid(curr_trap).getNeighbor(BOTTOM_LEFT) == old_trap){
-                setNeighbor(curr_trap,BOTTOM_LEFT,new_trap);
-            }
-        }
-        else{
-            if(getTrapezoid(curr_trap).getNeighbor(TOP_RIGHT) == old_trap){
-                setNeighbor(curr_trap,TOP_RIGHT,new_trap);
-            }
-            if(getTrapezoid(curr_trap).getNeighbor(BOTTOM_RIGHT) == old_trap){
-                setNeighbor(curr_trap,BOTTOM_RIGHT,new_trap);
-            }
-        }
-    }
-}
+
 /**
  * @brief TrapezoidalMap::setDagId
  * This method sets dag_id as the position in the Dag for the trapezoid identified by trap_id
@@ -147,6 +171,199 @@ void TrapezoidalMap::setDagId(size_t trap_id, size_t dag_id){
     t_map[trap_id].setDagId(dag_id);
 }
 
-void TrapezoidalMap::setNeighbors(size_t trap_id, size_t * neighbors){
-    t_map[trap_id].setNeighbors(neighbors);
+/**
+ * @brief TrapezoidalMap::reserve
+ * This method plans the memory of the map before the insertion of some segments: n segments give at most 3n + 1
+ * trapezoids and 2n points. When the map holds only the bounding box, the table of the trapezoids is allocated
+ * again as a single block of 3n + 1 trapezoids and the bounding box is inserted back, so a construction from an
+ * empty map never grows the tables. When the map already has some segments, the tables grow by new blocks.
+ * @param segments the number of segments that will be inserted
+ * @param hugePages true to back the tables with huge pages, where the system supports them
+ */
+void TrapezoidalMap::reserve(size_t segments, bool hugePages){
+    size_t n = this->segments.size() + segments;
+    if(t_map.size() <= 1 && (t_map.capacity() < 3 * n + 1 || t_map.getHugePages() != hugePages)){
+        t_map.clear(); //the block allocated by the constructor for the bounding box is released
+        t_map.setHugePages(hugePages);
+        t_map.reserve(3 * n + 1);
+        insertBoundingBoxT();
+    }
+    else{
+        t_map.setHugePages(hugePages);
+        t_map.reserve(3 * n + 1);
+    }
+    points.setHugePages(hugePages);
+    this->segments.setHugePages(hugePages);
+    segmentPoints.setHugePages(hugePages);
+    removedSegments.setHugePages(hugePages);
+    points.reserve(2 * n);
+    this->segments.reserve(n);
+    segmentPoints.reserve(n);
+    removedSegments.reserve(n);
+    pointMap.reserve(2 * n);
+}
+
+/**
+ * @brief TrapezoidalMap::addPoint
+ * This method inserts a point in the table of the points, if it isn't already there
+ * @param p the point to insert
+ * @return the id of the point
+ */
+size_t TrapezoidalMap::addPoint(const cg3::Point2d& p){
+    std::unordered_map<cg3::Point2d, size_t>::iterator it = pointMap.find(p);
+    if(it != pointMap.end()){
+        return it->second; //a segment with the same endpoint has already been inserted
+    }
+    size_t id = points.pushBack(p);
+    pointMap.insert(std::make_pair(p, id));
+    return id;
+}
+
+/**
+ * @brief TrapezoidalMap::addSegment
+ * This method inserts a segment and its endpoints in the tables of the map. The segment is stored oriented from
+ * left to right, the ids are assigned in order of insertion, so they are the same of the dataset when the segments
+ * are added in the order of the dataset. The trapezoids are not modified.
+ * @param s the segment to insert
+ * @return the id of the segment
+ */
+size_t TrapezoidalMap::addSegment(const cg3::Segment2d& s){
+    cg3::Segment2d ordered = s.p1() > s.p2() ? cg3::Segment2d(s.p2(), s.p1()) : s;
+    size_t leftp = addPoint(ordered.p1());
+    size_t rightp = addPoint(ordered.p2());
+    segmentPoints.pushBack(std::make_pair(leftp, rightp));
+    removedSegments.pushBack(0);
+    return segments.pushBack(ordered);
+}
+
+/**
+ * @brief TrapezoidalMap::removeSegment
+ * This method marks a segment as removed from the map. The segment and its endpoints stay in the tables, so the ids
+ * of the other segments don't change and the nodes of the dag that refer to the segment are still valid.
+ * The trapezoids are not modified, algorithms::removeSegment() merges them.
+ * @param id the id of the segment
+ */
+void TrapezoidalMap::removeSegment(size_t id){
+    if(!removedSegments[id]){
+        removedSegments[id] = 1;
+        removedCount++;
+    }
+}
+
+/**
+ * @brief TrapezoidalMap::isSegmentRemoved
+ * @param id the id of a segment
+ * @return true if the segment has been removed from the map
+ */
+bool TrapezoidalMap::isSegmentRemoved(size_t id) const{
+    return removedSegments[id] != 0;
+}
+
+/**
+ * @brief TrapezoidalMap::getRemovedSegmentsSize
+ * @return the number of segments removed from the map, getSegmentsSize() minus this number are in the map
+ */
+size_t TrapezoidalMap::getRemovedSegmentsSize() const{
+    return removedCount;
+}
+
+/**
+ * @brief TrapezoidalMap::getPoint
+ * @param id the id of a point, or BOUNDINGBOX_LEFTP/BOUNDINGBOX_RIGHTP
+ * @return the point with the given id
+ */
+const cg3::Point2d& TrapezoidalMap::getPoint(size_t id) const{
+    if(id < points.size()){
+        return points[id];
+    }
+    return id == BOUNDINGBOX_LEFTP ? boxLeftp : boxRightp;
+}
+
+/**
+ * @brief TrapezoidalMap::getSegment
+ * @param id the id of a segment, or BOUNDINGBOX_TOP/BOUNDINGBOX_BOTTOM
+ * @return the segment with the given id, oriented from left to right
+ */
+const cg3::Segment2d& TrapezoidalMap::getSegment(size_t id) const{
+    if(id < segments.size()){
+        return segments[id];
+    }
+    return id == BOUNDINGBOX_TOP ? boxTop : boxBottom;
+}
+
+/**
+ * @brief TrapezoidalMap::getSegmentLeftpId
+ * @param id the id of a segment
+ * @return the id of the left endpoint of the segment
+ */
+size_t TrapezoidalMap::getSegmentLeftpId(size_t id) const{
+    return segmentPoints[id].first;
+}
+
+/**
+ * @brief TrapezoidalMap::getSegmentRightpId
+ * @param id the id of a segment
+ * @return the id of the right endpoint of the segment
+ */
+size_t TrapezoidalMap::getSegmentRightpId(size_t id) const{
+    return segmentPoints[id].second;
+}
+
+/**
+ * @brief TrapezoidalMap::getPointsSize
+ * @return the number of points in the table of the points
+ */
+size_t TrapezoidalMap::getPointsSize() const{
+    return points.size();
+}
+
+/**
+ * @brief TrapezoidalMap::getSegmentsSize
+ * @return the number of segments in the table of the segments
+ */
+size_t TrapezoidalMap::getSegmentsSize() const{
+    return segments.size();
+}
+
+/**
+ * @brief TrapezoidalMap::getLeftp
+ * @param t a trapezoid of the map
+ * @return the point to the left of the trapezoid
+ */
+const cg3::Point2d& TrapezoidalMap::getLeftp(const Trapezoid& t) const{
+    return getPoint(t.getLeftpId());
+}
+
+/**
+ * @brief TrapezoidalMap::getRightp
+ * @param t a trapezoid of the map
+ * @return the point to the right of the trapezoid
+ */
+const cg3::Point2d& TrapezoidalMap::getRightp(const Trapezoid& t) const{
+    return getPoint(t.getRightpId());
+}
+
+/**
+ * @brief TrapezoidalMap::getTop
+ * This method computes the side above the trapezoid: the part of the top segment between leftp and rightp.
+ * It is only used for drawing and exporting, the construction works on the ids.
+ * @param t a trapezoid of the map
+ * @return the top side of the trapezoid, oriented from left to right
+ */
+cg3::Segment2d TrapezoidalMap::getTop(const Trapezoid& t) const{
+    const cg3::Segment2d& s = getSegment(t.getTopId());
+    double x1 = getLeftp(t).x(), x2 = getRightp(t).x();
+    return cg3::Segment2d(cg3::Point2d(x1, utility::yAtX(s, x1)), cg3::Point2d(x2, utility::yAtX(s, x2)));
+}
+
+/**
+ * @brief TrapezoidalMap::getBottom
+ * This method computes the side below the trapezoid: the part of the bottom segment between leftp and rightp
+ * @param t a trapezoid of the map
+ * @return the bottom side of the trapezoid, oriented from left to right
+ */
+cg3::Segment2d TrapezoidalMap::getBottom(const Trapezoid& t) const{
+    const cg3::Segment2d& s = getSegment(t.getBottomId());
+    double x1 = getLeftp(t).x(), x2 = getRightp(t).x();
+    return cg3::Segment2d(cg3::Point2d(x1, utility::yAtX(s, x1)), cg3::Point2d(x2, utility::yAtX(s, x2)));
 }
@@ -3,6 +3,15 @@
 
 #include "trapezoid.h"
 #include "algorithms/utility.h"
+#include "utils/arena.h"
+
+#include <unordered_map>
+
+//the ids of the corners and of the sides of the bounding box, they are not stored in the tables of the map
+#define BOUNDINGBOX_LEFTP (SIZE_MAX - 1)   //the id of the point to the left of the bounding box
+#define BOUNDINGBOX_RIGHTP (SIZE_MAX - 2)  //the id of the point to the right of the bounding box
+#define BOUNDINGBOX_TOP (SIZE_MAX - 1)     //the id of the top side of the bounding box
+#define BOUNDINGBOX_BOTTOM (SIZE_MAX - 2)  //the id of the bottom side of the bounding box
 
 class TrapezoidalMap
 {
@@ -11,26 +20,57 @@ class TrapezoidalMap
         TrapezoidalMap();
 
         //getter
-        const std::vector<Trapezoid> getMap() const;
+        const Arena<Trapezoid>& getMap() const;
         size_t getTsize() const ;
 
-        //methods for managing the vector of trapezoids
+        //methods for managing the table of trapezoids
         size_t insertTrapezoid(Trapezoid& t);
         void replaceTrapezoid(size_t index, Trapezoid& t);
         Trapezoid& getTrapezoid(size_t index);
+        const Trapezoid& getTrapezoid(size_t index) const;
         void clearTmap();
+        void clearTrapezoids();
+        void removeLastTrapezoid();
+        void resizeTrapezoids(size_t n);
         void insertBoundingBoxT();
         void setDagId(size_t trap_id, size_t dag_id);
+        void reserve(size_t segments, bool hugePages = false);
+
+        //methods for managing the points and the segments referred by the trapezoids
+        size_t addPoint(const cg3::Point2d& p);
+        size_t addSegment(const cg3::Segment2d& s);
+        const cg3::Point2d& getPoint(size_t id) const;
+        const cg3::Segment2d& getSegment(size_t id) const;
+        size_t getSegmentLeftpId(size_t id) const;
+        size_t getSegmentRightpId(size_t id) const;
+        size_t getPointsSize() const;
+        size_t getSegmentsSize() const;
+        void removeSegment(size_t id);
+        bool isSegmentRemoved(size_t id) const;
+        size_t getRemovedSegmentsSize() const;
+
+        //geometry of a trapezoid, computed from its ids
+        const cg3::Point2d& getLeftp(const Trapezoid& t) const;
+        const cg3::Point2d& getRightp(const Trapezoid& t) const;
+        cg3::Segment2d getTop(const Trapezoid& t) const;
+        cg3::Segment2d getBottom(const Trapezoid& t) const;
 
         //methods to access to the neighbors of a trapezoid
         size_t getNeighbor(size_t trap, size_t index);
         void setNeighbor(size_t trap, size_t index, size_t rep);
-        void setNeighbors(size_t trap_id, size_t * neighbors);
-        void updateOldNeighbors(bool left, size_t curr_trap, size_t old_trap, size_t new_trap);
 
     private:
-        std::vector<Trapezoid> t_map; //the vector containing the trapezoids
+        Arena<Trapezoid> t_map; //the table containing the trapezoids
+
+        Arena<cg3::Point2d> points;                     //the endpoints of the segments, without duplicates
+        Arena<cg3::Segment2d> segments;                 //the segments, oriented from left to right
+        Arena<std::pair<size_t,size_t>> segmentPoints;  //the ids of the left and right endpoint of every segment
+        std::unordered_map<cg3::Point2d, size_t> pointMap;   //the id of every point, to avoid the duplicates
+        Arena<char> removedSegments;                    //1 for the segments removed from the map, they keep their id
+        size_t removedCount;                            //the number of segments removed from the map
 
+        cg3::Point2d boxLeftp, boxRightp; //the points of the bounding box
+        cg3::Segment2d boxTop, boxBottom; //the sides of the bounding box
 };
 
 #endif // TRAPEZOIDALMAP_H
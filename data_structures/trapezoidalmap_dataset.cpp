@@ -1,4 +1,63 @@
 #include "trapezoidalmap_dataset.h"
+#include "algorithms/predicates.h"
+
+#include <algorithm>
+#include <set>
+
+namespace {
+
+/**
+ * @brief The order of the sweep status of addSegments(): the segments crossed by the sweep line from
+ * the bottom to the top. Two segments are only compared when the second one is inserted, so they both
+ * cross the vertical line through the left endpoint of the segment that starts to the right.
+ * The segments are ordered from left to right (p1 < p2).
+ */
+struct SweepOrder {
+    const std::vector<cg3::Segment2d>* segments;
+
+    //a starts on the sweep line, on the right of the left endpoint of b or on it
+    bool below(size_t a, size_t b) const
+    {
+        const cg3::Segment2d& sa = (*segments)[a];
+        const cg3::Segment2d& sb = (*segments)[b];
+        double o = predicates::orientation(sb.p1(), sb.p2(), sa.p1());
+        if (o == 0) {
+            o = predicates::orientation(sb.p1(), sb.p2(), sa.p2());
+        }
+        return o < 0 || (o == 0 && a < b);
+    }
+
+    bool operator()(size_t a, size_t b) const
+    {
+        if (a == b) {
+            return false;
+        }
+        if (!((*segments)[a].p1() < (*segments)[b].p1())) {
+            return below(a, b);
+        }
+        return !below(b, a);
+    }
+};
+
+/**
+ * @brief An endpoint of a segment, the events of the sweep of addSegments()
+ */
+struct SweepEvent {
+    cg3::Point2d point;
+    size_t segment;
+    bool left;
+
+    //the events are sorted by point, and the segments that end in a point are removed before the ones that start there
+    bool operator<(const SweepEvent& e) const
+    {
+        if (point != e.point) {
+            return point < e.point;
+        }
+        return !left && e.left;
+    }
+};
+
+}
 
 TrapezoidalMapDataset::TrapezoidalMapDataset() :
     boundingBox(cg3::Point2d(0,0),cg3::Point2d(0,0))
@@ -150,6 +209,251 @@ size_t TrapezoidalMapDataset::addIndexedSegment(const IndexedSegment2d& indexedS
     return id;
 }
 
+/**
+ * @brief Adds a set of segments, with the same result of addSegment() called on every segment in the order of
+ * the input, but with a single validation of the intersections when the segments don't intersect.
+ * The degenerate and vertical segments, the duplicates of the dataset and the endpoints on the x-coordinate of a
+ * point of the dataset are found first with hash tables. A sweep of the plane in O(n log n) (Shamos-Hoey) then
+ * tells if any two of the remaining segments, or one of them and a segment of the dataset, intersect.
+ * The segments are then accepted in the order of the input: a segment is rejected if it is equal to an accepted
+ * segment, or if an endpoint has the x-coordinate of a different point of an accepted segment, so the points of
+ * the rejected segments are never claimed. When the sweep found no intersection, the intersection checker is built
+ * at once with the accepted segments. Otherwise every segment is also checked against the accepted ones and
+ * inserted in the checker, like addSegment() does, and the rejected ones are reported with the segment they intersect.
+ * The segments that are added get consecutive ids in the order of the input.
+ * @param segments The segments
+ * @return The rejected segments, ordered by their position in the input
+ */
+std::vector<TrapezoidalMapDataset::RejectedSegment> TrapezoidalMapDataset::addSegments(const std::vector<cg3::Segment2d>& segments)
+{
+    const size_t none = std::numeric_limits<size_t>::max();
+    std::vector<RejectedSegment> rejected;
+
+    //Segments of the sweep: the segments of the dataset followed by the input segments, ordered from left to right
+    size_t datasetSegments = indexedSegments.size();
+    std::vector<cg3::Segment2d> sweepSegments;
+    sweepSegments.reserve(datasetSegments + segments.size());
+    for (size_t i = 0; i < datasetSegments; i++) {
+        cg3::Segment2d segment = getSegment(i);
+        if (segment.p2() < segment.p1()) {
+            segment = cg3::Segment2d(segment.p2(), segment.p1());
+        }
+        sweepSegments.push_back(segment);
+    }
+
+    //Degenerate and vertical segments, duplicates and points not in general position with respect to the dataset:
+    //they don't depend on the other input segments. A copy of an earlier input segment is not swept, it is decided
+    //like the first copy.
+    std::vector<bool> candidate(segments.size(), false);
+    std::vector<bool> swept(segments.size(), false);
+    std::unordered_map<cg3::Segment2d, size_t> firstCopy;
+    for (size_t i = 0; i < segments.size(); i++) {
+        cg3::Segment2d orderedSegment = segments[i];
+        if (segments[i].p2() < segments[i].p1()) {
+            orderedSegment = cg3::Segment2d(segments[i].p2(), segments[i].p1());
+        }
+        sweepSegments.push_back(orderedSegment);
+
+        if (orderedSegment.p1() == orderedSegment.p2()) {
+            rejected.push_back(RejectedSegment{i, DEGENERATE, none, false});
+            continue;
+        }
+
+        bool found;
+        size_t id = findSegment(orderedSegment, found);
+        if (found) {
+            rejected.push_back(RejectedSegment{i, DUPLICATE, id, true});
+            continue;
+        }
+
+        if (orderedSegment.p1().x() == orderedSegment.p2().x()) {
+            rejected.push_back(RejectedSegment{i, NOT_GENERAL_POSITION, none, false});
+            continue;
+        }
+        bool generalPosition = true;
+        for (const cg3::Point2d& point : {orderedSegment.p1(), orderedSegment.p2()}) {
+            bool foundPoint;
+            findPoint(point, foundPoint);
+            if (!foundPoint && xCoordSet.find(point.x()) != xCoordSet.end()) {
+                rejected.push_back(RejectedSegment{i, NOT_GENERAL_POSITION, none, true});
+                generalPosition = false;
+                break;
+            }
+        }
+        if (!generalPosition) {
+            continue;
+        }
+
+        candidate[i] = true;
+        swept[i] = firstCopy.insert(std::make_pair(orderedSegment, i)).second;
+    }
+
+    //Sweep of the endpoints from left to right, it stops at the first intersection
+    std::vector<SweepEvent> events;
+    for (size_t s = 0; s < sweepSegments.size(); s++) {
+        if (s < datasetSegments || swept[s - datasetSegments]) {
+            events.push_back(SweepEvent{sweepSegments[s].p1(), s, true});
+            events.push_back(SweepEvent{sweepSegments[s].p2(), s, false});
+        }
+    }
+    std::sort(events.begin(), events.end());
+
+    typedef std::set<size_t, SweepOrder> SweepStatus;
+    SweepStatus status(SweepOrder{&sweepSegments});
+    std::vector<SweepStatus::iterator> position(sweepSegments.size(), status.end());
+    std::vector<std::pair<size_t, size_t>> adjacent;
+    bool intersections = false;
+
+    for (size_t e = 0; e < events.size() && !intersections; e++) {
+        size_t s = events[e].segment;
+        if (events[e].left) {
+            SweepStatus::iterator it = status.insert(s).first;
+            position[s] = it;
+            if (it != status.begin()) {
+                adjacent.push_back(std::make_pair(*std::prev(it), s));
+            }
+            if (std::next(it) != status.end()) {
+                adjacent.push_back(std::make_pair(s, *std::next(it)));
+            }
+        }
+        else {
+            SweepStatus::iterator it = status.erase(position[s]);
+            if (it != status.begin() && it != status.end()) {
+                adjacent.push_back(std::make_pair(*std::prev(it), *it));
+            }
+        }
+
+        //Segments that became adjacent
+        for (const std::pair<size_t, size_t>& pair : adjacent) {
+            if (SegmentIntersectionChecker::checkSegmentIntersection(sweepSegments[pair.first], sweepSegments[pair.second])) {
+                intersections = true;
+            }
+        }
+        adjacent.clear();
+    }
+
+    //Acceptance in the order of the input, the x-coordinates are claimed only by the accepted segments
+    std::unordered_map<cg3::Segment2d, size_t> acceptedSegments;
+    std::unordered_map<double, std::pair<cg3::Point2d, size_t>> claimedXCoords;
+    std::unordered_map<cg3::Segment2d, size_t> keptIndex; //the position in the sweep of the segments in the checker
+    std::vector<cg3::Segment2d> keptSegments;
+    if (intersections) {
+        for (size_t s = 0; s < datasetSegments; s++) {
+            keptIndex.insert(std::make_pair(sweepSegments[s], s));
+        }
+    }
+    for (size_t i = 0; i < segments.size(); i++) {
+        if (!candidate[i]) {
+            continue;
+        }
+        const cg3::Segment2d& orderedSegment = sweepSegments[datasetSegments + i];
+        candidate[i] = false;
+
+        std::unordered_map<cg3::Segment2d, size_t>::iterator duplicate = acceptedSegments.find(orderedSegment);
+        if (duplicate != acceptedSegments.end()) {
+            rejected.push_back(RejectedSegment{i, DUPLICATE, duplicate->second, false});
+            continue;
+        }
+
+        bool generalPosition = true;
+        for (const cg3::Point2d& point : {orderedSegment.p1(), orderedSegment.p2()}) {
+            std::unordered_map<double, std::pair<cg3::Point2d, size_t>>::iterator owner = claimedXCoords.find(point.x());
+            if (owner != claimedXCoords.end() && owner->second.first != point) {
+                rejected.push_back(RejectedSegment{i, NOT_GENERAL_POSITION, owner->second.second, false});
+                generalPosition = false;
+                break;
+            }
+        }
+        if (!generalPosition) {
+            continue;
+        }
+
+        if (intersections) {
+            cg3::Segment2d intersected;
+            if (intersectionChecker.findIntersection(orderedSegment, intersected)) {
+                std::unordered_map<cg3::Segment2d, size_t>::iterator other = keptIndex.find(intersected);
+                if (other == keptIndex.end()) {
+                    other = keptIndex.find(cg3::Segment2d(intersected.p2(), intersected.p1()));
+                }
+                assert(other != keptIndex.end());
+                if (other->second < datasetSegments) {
+                    rejected.push_back(RejectedSegment{i, INTERSECTING, other->second, true});
+                }
+                else {
+                    rejected.push_back(RejectedSegment{i, INTERSECTING, other->second - datasetSegments, false});
+                }
+                continue;
+            }
+            intersectionChecker.insert(orderedSegment);
+            keptIndex.insert(std::make_pair(orderedSegment, datasetSegments + i));
+        }
+        else {
+            keptSegments.push_back(orderedSegment);
+        }
+
+        candidate[i] = true;
+        acceptedSegments.insert(std::make_pair(orderedSegment, i));
+        claimedXCoords.insert(std::make_pair(orderedSegment.p1().x(), std::make_pair(orderedSegment.p1(), i)));
+        claimedXCoords.insert(std::make_pair(orderedSegment.p2().x(), std::make_pair(orderedSegment.p2(), i)));
+    }
+
+    //Without intersections the intersection checker is built at once if it is empty
+    if (!intersections && datasetSegments == 0) {
+        intersectionChecker.construction(keptSegments);
+    }
+    else if (!intersections) {
+        for (const cg3::Segment2d& segment : keptSegments) {
+            intersectionChecker.insert(segment);
+        }
+    }
+
+    //Insertion of the valid segments
+    for (size_t i = 0; i < segments.size(); i++) {
+        if (!candidate[i]) {
+            continue;
+        }
+        const cg3::Segment2d& orderedSegment = sweepSegments[datasetSegments + i];
+
+        bool foundPoint1, foundPoint2;
+        size_t id1 = findPoint(orderedSegment.p1(), foundPoint1);
+        if (!foundPoint1) {
+            bool insertedPoint1;
+            id1 = addPoint(orderedSegment.p1(), insertedPoint1);
+            assert(insertedPoint1);
+        }
+        size_t id2 = findPoint(orderedSegment.p2(), foundPoint2);
+        if (!foundPoint2) {
+            bool insertedPoint2;
+            id2 = addPoint(orderedSegment.p2(), insertedPoint2);
+            assert(insertedPoint2);
+        }
+
+        IndexedSegment2d indexedSegment(std::min(id1, id2), std::max(id1, id2));
+        segmentMap.insert(std::make_pair(indexedSegment, indexedSegments.size()));
+        indexedSegments.push_back(indexedSegment);
+    }
+
+    std::sort(rejected.begin(), rejected.end(), [](const RejectedSegment& a, const RejectedSegment& b) {
+        return a.index < b.index;
+    });
+    return rejected;
+}
+
+std::string TrapezoidalMapDataset::rejectionReasonDescription(RejectionReason reason)
+{
+    switch (reason) {
+    case DEGENERATE:
+        return "it is degenerate";
+    case DUPLICATE:
+        return "it is a duplicate of another segment";
+    case NOT_GENERAL_POSITION:
+        return "a point has the same x-coordinate of another point";
+    case INTERSECTING:
+        return "it has intersections with another segment";
+    }
+    return "";
+}
+
 size_t TrapezoidalMapDataset::findPoint(const cg3::Point2d &point, bool &found)
 {
     std::unordered_map<cg3::Point2d, size_t>::iterator it = pointMap.find(point);
@@ -1,6 +1,7 @@
 #ifndef TRAPEZOIDALMAP_DATASET_H
 #define TRAPEZOIDALMAP_DATASET_H
 
+#include <string>
 #include <unordered_map>
 #include <vector>
 #include <utility>
@@ -22,11 +23,36 @@ public:
 
     typedef std::pair<size_t, size_t> IndexedSegment2d;
 
+    /**
+     * @brief The reason for which a segment is not added by addSegments()
+     */
+    enum RejectionReason {
+        DEGENERATE,             //the endpoints are the same point
+        DUPLICATE,              //the segment is equal to another segment
+        NOT_GENERAL_POSITION,   //an endpoint has the x-coordinate of another point, or the segment is vertical
+        INTERSECTING            //the segment intersects another segment
+    };
+
+    /**
+     * @brief A segment that is not added by addSegments(). The other segment of the conflict is an input
+     * segment, or a segment that was already in the dataset if otherInDataset is true.
+     * other is the maximum size_t if there is no other segment (degenerate and vertical segments) or if the
+     * conflict is with a point of the dataset.
+     */
+    struct RejectedSegment {
+        size_t index;            //the position of the segment in the input
+        RejectionReason reason;
+        size_t other;            //the position in the input, or the id in the dataset, of the other segment
+        bool otherInDataset;
+    };
+
     TrapezoidalMapDataset();
 
     size_t addPoint(const cg3::Point2d& point, bool& pointInserted);
     size_t addSegment(const cg3::Segment2d& segment, bool& segmentInserted);
     size_t addIndexedSegment(const IndexedSegment2d& segment, bool& segmentInserted);
+    std::vector<RejectedSegment> addSegments(const std::vector<cg3::Segment2d>& segments);
+    static std::string rejectionReasonDescription(RejectionReason reason);
 
     size_t findPoint(const cg3::Point2d& point, bool& found);
     size_t findSegment(const cg3::Segment2d& segment, bool& found);
@@ -0,0 +1,46 @@
+#include "trapezoidalmap_snapshot.h"
+
+/**
+ * @brief TrapezoidalMapSnapshot::TrapezoidalMapSnapshot
+ * Constructor of the snapshot. The trapezoidal map and the dag are copied once, so the snapshot doesn't
+ * depend on the live structures, which can be modified or cleared while the snapshot is queried.
+ * The dag is packed once as well.
+ * @param T the trapezoidal map to freeze
+ * @param D the dag of the trapezoidal map to freeze
+ */
+TrapezoidalMapSnapshot::TrapezoidalMapSnapshot(const TrapezoidalMap& T, const Dag& D):
+    map(T), dag(D), packedDag(D)
+{
+}
+
+/**
+ * @brief TrapezoidalMapSnapshot::getMap
+ * @return a read-only reference to the frozen trapezoidal map
+ */
+const TrapezoidalMap& TrapezoidalMapSnapshot::getMap() const{
+    return map;
+}
+
+/**
+ * @brief TrapezoidalMapSnapshot::getDag
+ * @return a read-only reference to the frozen dag
+ */
+const Dag& TrapezoidalMapSnapshot::getDag() const{
+    return dag;
+}
+
+/**
+ * @brief TrapezoidalMapSnapshot::getPackedDag
+ * @return a read-only reference to the packed copy of the frozen dag
+ */
+const PackedDag& TrapezoidalMapSnapshot::getPackedDag() const{
+    return packedDag;
+}
+
+/**
+ * @brief TrapezoidalMapSnapshot::getTsize
+ * @return the number of trapezoids of the frozen trapezoidal map
+ */
+size_t TrapezoidalMapSnapshot::getTsize() const{
+    return map.getTsize();
+}
@@ -0,0 +1,32 @@
+#ifndef TRAPEZOIDALMAP_SNAPSHOT_H
+#define TRAPEZOIDALMAP_SNAPSHOT_H
+
+#include "trapezoidalmap.h"
+#include "dag.h"
+#include "packed_dag.h"
+
+/**
+ * @brief The TrapezoidalMapSnapshot class
+ * A frozen copy of a built trapezoidal map and of its Dag. The snapshot only exposes const methods and
+ * its members are never modified after the construction, so the same snapshot can be queried by
+ * several threads at the same time without any synchronization.
+ */
+class TrapezoidalMapSnapshot
+{
+    public:
+        //constructors
+        TrapezoidalMapSnapshot(const TrapezoidalMap& T, const Dag& D);
+
+        //getters
+        const TrapezoidalMap& getMap() const;
+        const Dag& getDag() const;
+        const PackedDag& getPackedDag() const;
+        size_t getTsize() const;
+
+    private:
+        const TrapezoidalMap map; //the frozen trapezoidal map
+        const Dag dag;            //the frozen search structure of the map
+        const PackedDag packedDag; //the compact copy of the dag used by the queries
+};
+
+#endif // TRAPEZOIDALMAP_SNAPSHOT_H
@@ -14,17 +14,47 @@ DrawableTrapezoidalMap::DrawableTrapezoidalMap(){
  */
 void DrawableTrapezoidalMap::draw() const{
     for(const Trapezoid& t : getMap()){
+        cg3::Color color = getColor(t.getId());
+        cg3::Color borderColor = cg3::Color(0,0,0);
+        int borderWidth = 2;
+        if(t.getId() == lastQueried){
+            //the queried trapezoid is red with an orange border
+            color = cg3::Color(255,0,0);
+            borderColor = cg3::Color(255,165,0);
+            borderWidth = 5;
+        }
+        //the sides of the trapezoid are clipped to the range of its points
+        cg3::Segment2d top = getTop(t);
+        cg3::Segment2d bottom = getBottom(t);
         //draw the face of the trapezoid
-        cg3::opengl::drawQuad2(t.getTop().p1(),t.getTop().p2(),t.getBottom().p2(),t.getBottom().p1(),
-                               t.getColor(), 1, true);
+        cg3::opengl::drawQuad2(top.p1(),top.p2(),bottom.p2(),bottom.p1(),
+                               color, 1, true);
         //draw the borders of the trapezoid
-        cg3::opengl::drawLine2(t.getTop().p1(),t.getTop().p2(),t.getBorderColor(), t.getBorderWidth());
-        cg3::opengl::drawLine2(t.getBottom().p1(),t.getBottom().p2(),t.getBorderColor(), t.getBorderWidth());
-        cg3::opengl::drawLine2(t.getTop().p1(),t.getBottom().p1(),t.getBorderColor(), t.getBorderWidth());
-        cg3::opengl::drawLine2(t.getTop().p2(),t.getBottom().p2(),t.getBorderColor(), t.getBorderWidth());
+        cg3::opengl::drawLine2(top.p1(),top.p2(),borderColor, borderWidth);
+        cg3::opengl::drawLine2(bottom.p1(),bottom.p2(),borderColor, borderWidth);
+        cg3::opengl::drawLine2(top.p1(),bottom.p1(),borderColor, borderWidth);
+        cg3::opengl::drawLine2(top.p2(),bottom.p2(),borderColor, borderWidth);
     }
 }
 
+/**
+ * @brief DrawableTrapezoidalMap::getColor
+ * This method returns the color for filling a trapezoid. The colors are random and they are generated
+ * the first time a trapezoid with that id is drawn. The bounding box alone is light green.
+ * @param trap the id of the trapezoid
+ * @return the color of the trapezoid
+ */
+const cg3::Color& DrawableTrapezoidalMap::getColor(size_t trap) const{
+    static const cg3::Color boundingBoxColor = cg3::Color(144,238,144);
+    if(getTsize() == 1){
+        return boundingBoxColor;
+    }
+    while(colors.size() <= trap){
+        colors.push_back(cg3::Color(rand()%256, rand()%256, rand()%256));
+    }
+    return colors[trap];
+}
+
 /**
  * @brief DrawableTrapezoidalMap::sceneCenter
  * Override of the sceneCenter method
@@ -45,18 +75,19 @@ double DrawableTrapezoidalMap::sceneRadius() const{
     return bbox.diag();
 }
 
-double DrawableTrapezoidalMap::getLastQueried() const{
+/**
+ * @brief DrawableTrapezoidalMap::getLastQueried
+ * @return the id of the highlighted trapezoid, SIZE_MAX if there is none
+ */
+size_t DrawableTrapezoidalMap::getLastQueried() const{
     return lastQueried;
 }
 
-const cg3::Color DrawableTrapezoidalMap::getLastColor() const{
-    return lastColor;
-}
-
+/**
+ * @brief DrawableTrapezoidalMap::setLastQueried
+ * This method sets the trapezoid to highlight, the trapezoid found by the last query
+ * @param last the id of the trapezoid, SIZE_MAX to remove the highlight
+ */
 void DrawableTrapezoidalMap::setLastQueried(size_t last){
     lastQueried = last;
 }
-
-void DrawableTrapezoidalMap::setLastColor(cg3::Color color){
-    lastColor = color;
-}
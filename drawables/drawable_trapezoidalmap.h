@@ -18,14 +18,14 @@ public:
     cg3::Point3d sceneCenter() const;
     double sceneRadius() const;
 
-    double getLastQueried() const;
-    const cg3::Color getLastColor() const;
+    size_t getLastQueried() const;
     void setLastQueried(size_t last);
-    void setLastColor(cg3::Color color);
 
 private:
-    int lastQueried = -1;
-    cg3::Color lastColor = cg3::Color(0,0,0);
+    const cg3::Color& getColor(size_t trap) const;
+
+    size_t lastQueried = SIZE_MAX;          //the id of the highlighted trapezoid, SIZE_MAX if there is none
+    mutable std::vector<cg3::Color> colors; //the colors for filling the trapezoids, indexed by the id of the trapezoid
 
 };
 
@@ -0,0 +1,36 @@
+# Segment generator: it writes random non intersecting segments with a chosen distribution in a segment file.
+# It doesn't use Qt nor OpenGL, so it can run on servers without a display.
+TEMPLATE = app
+TARGET = trapezoidalmap_generator
+CONFIG += console
+CONFIG -= app_bundle
+QT -= core gui
+
+# Debug configuration
+CONFIG(debug, debug|release){
+    DEFINES += DEBUG
+}
+
+# Release configuration
+CONFIG(release, debug|release){
+    DEFINES -= DEBUG
+    DEFINES += NDEBUG
+}
+
+# cg3lib works with c++11
+CONFIG += c++11
+
+# Only the core of cg3lib is needed, the viewer module requires Qt
+CONFIG += CG3_CORE
+
+include (../cg3lib/cg3.pri)
+
+# Sources of the algorithms and of the data structures
+include (../GAS_2122_TrapezoidalMaps.pri)
+
+unix:!macx{
+    LIBS += -pthread
+}
+
+SOURCES += \
+    main.cpp
@@ -0,0 +1,132 @@
+#include "utils/fileutils.h"
+#include "utils/segmentgenerator.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+namespace {
+
+/**
+ * @brief The Options struct
+ * The parameters of the generator, read from the command line
+ */
+struct Options{
+    SegmentGenerator::Parameters parameters;
+    std::string output;         //the segment file to write
+    bool binary = false;        //if the file is written in the binary segment format
+    size_t threads = 0;         //the threads of the generation, 0 for all the cores
+};
+
+/**
+ * @brief usage
+ * Prints the command line options of the generator
+ */
+void usage(const char * name){
+    std::cerr << "Usage: " << name << " --output path [options]" << std::endl <<
+                 "  --output path           the segment file to write" << std::endl <<
+                 "  --distribution name     uniform, clustered, horizontal, roads or adversarial (default uniform)" << std::endl <<
+                 "  --segments n            the number of segments (default 1000)" << std::endl <<
+                 "  --seed s                the seed of the random numbers (default 1)" << std::endl <<
+                 "  --radius r              the segments are in the square [-r, r] (default 1000000)" << std::endl <<
+                 "  --clusters k            clustered: the number of hotspots (default 16)" << std::endl <<
+                 "  --spread s              clustered: the standard deviation of a hotspot, relative to the radius (default 0.05)" << std::endl <<
+                 "  --segments-per-row n    horizontal: the number of segments in a row (default 4)" << std::endl <<
+                 "  --drop-rate f           roads: the fraction of streets removed from the grid (default 0.1)" << std::endl <<
+                 "  --threads n             the threads of the generation, 0 for all the cores (default 0)" << std::endl <<
+                 "  --binary                write the binary segment format instead of the text one" << std::endl <<
+                 "The options of the generator are saved in the file, so the same segments can be generated again." << std::endl;
+}
+
+/**
+ * @brief parseOptions
+ * Reads the options of the generator from the command line
+ * @return false if the command line is not valid
+ */
+bool parseOptions(int argc, char * argv[], Options& options){
+    SegmentGenerator::Parameters& p = options.parameters;
+    for(int i = 1; i < argc; i++){
+        std::string arg = argv[i];
+        if(arg == "--binary"){
+            options.binary = true;
+            continue;
+        }
+        if(i + 1 >= argc){
+            return false;
+        }
+        std::string value = argv[++i];
+        if(arg == "--output"){
+            options.output = value;
+        }
+        else if(arg == "--distribution"){
+            if(!SegmentGenerator::parseDistribution(value, p.distribution)){
+                return false;
+            }
+        }
+        else if(arg == "--segments"){
+            p.segments = std::strtoull(value.c_str(), nullptr, 10);
+        }
+        else if(arg == "--seed"){
+            p.seed = std::strtoul(value.c_str(), nullptr, 10);
+        }
+        else if(arg == "--radius"){
+            p.radius = std::strtod(value.c_str(), nullptr);
+        }
+        else if(arg == "--clusters"){
+            p.clusters = std::strtoull(value.c_str(), nullptr, 10);
+        }
+        else if(arg == "--spread"){
+            p.spread = std::strtod(value.c_str(), nullptr);
+        }
+        else if(arg == "--segments-per-row"){
+            p.segmentsPerRow = std::strtoull(value.c_str(), nullptr, 10);
+        }
+        else if(arg == "--drop-rate"){
+            p.dropRate = std::strtod(value.c_str(), nullptr);
+        }
+        else if(arg == "--threads"){
+            options.threads = std::strtoull(value.c_str(), nullptr, 10);
+        }
+        else{
+            return false;
+        }
+    }
+    return !options.output.empty() && p.radius > 0;
+}
+
+}
+
+/**
+ * The generator writes a segment file with random non intersecting segments, in general position, with one of the
+ * distributions of SegmentGenerator. The file starts with the options that generated it, so a benchmark on the
+ * file can be reproduced.
+ */
+int main(int argc, char * argv[]) {
+    Options options;
+    if(!parseOptions(argc, argv, options)){
+        usage(argv[0]);
+        return 1;
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::vector<cg3::Segment2d> segments = SegmentGenerator::generateSegments(options.parameters, options.threads);
+    double generateSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::string metadata = "trapezoidalmap_generator " + SegmentGenerator::describe(options.parameters);
+    start = std::chrono::steady_clock::now();
+    if(options.binary){
+        if(!FileUtils::saveSegmentsInBinaryFile(options.output, segments, metadata)){
+            std::cerr << "Cannot write " << options.output << std::endl;
+            return 1;
+        }
+    }
+    else{
+        FileUtils::saveSegmentsInFile(options.output, segments, metadata);
+    }
+    double saveSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cerr << "Segments: " << segments.size() << ", generation: " << generateSeconds << " s, save: " <<
+                 saveSeconds << " s" << std::endl;
+    return 0;
+}
@@ -10,6 +10,7 @@
 #include <cg3/utilities/timer.h>
 
 #include "utils/fileutils.h"
+#include "utils/randomutils.h"
 
 //Limits for the bounding box
 //It defines where points can be added
@@ -38,7 +39,8 @@ TrapezoidalMapManager::TrapezoidalMapManager(QWidget *parent) :
     firstPointSelectedSize(5),
     isFirstPointSelected(false),
     drawableMap(),
-    dag()
+    dag(),
+    buildSeed(0)
 {
     //NOTE 1: you probably need to initialize some objects in the constructor. You
     //can see how to initialize an attribute in the lines above. This is C++ style
@@ -196,24 +198,7 @@ void TrapezoidalMapManager::addSegmentToTrapezoidalMap(const cg3::Segment2d& seg
     //it more efficient in memory. However, depending on how you implement your algorithms and data 
     //structures, you could save directly the point (Point2d) in each trapezoid (it is fine).
 
-    cg3::Segment2d orderedSegment;
-    std::vector<Trapezoid> delta;
-
-    if(segment.p1() > segment.p2()){
-        orderedSegment = cg3::Segment2d(segment.p2(),segment.p1());
-    }
-    else{
-        orderedSegment = segment;
-    }
-
-    delta = algorithms::followSegment(drawableMap,dag,orderedSegment);
-
-    if(delta.size() == 1){
-        algorithms::splitin4(drawableMap,orderedSegment,dag,delta[0].getId());
-    }
-    else{
-        algorithms::multipleSplit(drawableMap,orderedSegment,dag,delta);
-    }
+    algorithms::addSegment(drawableMap,dag,segment);
 
 
 
@@ -264,21 +249,9 @@ void TrapezoidalMapManager::queryTrapezoidalMap(const cg3::Point2d& queryPoint)
     //When you find the trapezoid in which the point is contained, you should highlight
     //the output trapezoid in the canvas (DrawableTrapezoidMap should implement the method
     //to do that).
-    if(drawableMap.getLastQueried() != -1){
-        Trapezoid & old = drawableMap.getTrapezoid(drawableMap.getLastQueried());
-        old.setColor(drawableMap.getLastColor());
-        old.setBorderColor(cg3::Color(0,0,0));
-        old.setBorderWidth(2);
-    }
-
-    size_t query_node = algorithms::queryPoint(dag, queryPoint);
-    size_t query_index = dag.getElementInDVector(query_node).getEntityId();
-    Trapezoid & t = drawableMap.getTrapezoid(query_index);
-    drawableMap.setLastColor(t.getColor());
-    drawableMap.setLastQueried(query_index);
-    t.setColor(cg3::Color(255,0,0));
-    t.setBorderColor(cg3::Color(255,165,0));
-    t.setBorderWidth(5);
+    //the walk starts from the last queried trapezoid, the near queries of the mouse don't visit the dag
+    size_t query_index = algorithms::queryTrapezoid(drawableMap, dag, queryPoint, drawableMap.getLastQueried());
+    drawableMap.setLastQueried(query_index); //the drawable map highlights the queried trapezoid
 
 
 
@@ -298,6 +271,7 @@ void TrapezoidalMapManager::clearTrapezoidalMap()
 
     //#####################################################################
     drawableMap.clearTmap();
+    drawableMap.setLastQueried(SIZE_MAX);
     dag.clearDag();
 }
 
@@ -307,6 +281,37 @@ void TrapezoidalMapManager::clearTrapezoidalMap()
 //---------------------------------------------------------------------
 //Define your private methods here if you need some
 
+/**
+ * @brief Launch the randomized incremental construction of the trapezoidal map
+ * and measure its time efficiency. The segments are inserted in the random order given by the seed,
+ * the seed is stored and printed so that the same construction can be reproduced.
+ * @param[in] segments the segments to insert
+ * @param[in] seed the seed of the random insertion order
+ */
+void TrapezoidalMapManager::loadSegmentsRandomizedTrapezoidalMapAndMeasureTime(const std::vector<cg3::Segment2d>& segments, unsigned long seed)
+{
+    //Output message
+    std::cout << "Constructing the trapezoidal map for " << segments.size() << " segments in random order (seed " << seed << ")..." << std::endl;
+    buildSeed = seed;
+
+    //Timer for evaluating the efficiency of the algorithm
+    cg3::Timer t("Trapezoidal map construction");
+
+    //Launch incremental step for each segment, in the random order. The segments are added to the map
+    //before the construction, so the id of every segment is its position in the vector
+    algorithms::buildTrapezoidalMap(drawableMap, dag, segments, seed);
+
+    //Timer stop and visualization (both on console and UI)
+    t.stopAndPrint();
+    ui->loadSegmentsTimeLabel->setNum(t.delay());
+    ui->addSegmentTimeLabel->setText("");
+    ui->queryTimeLabel->setText("");
+
+    std::cout << "Seed: " << buildSeed << ", trapezoids: " << drawableMap.getTsize() <<
+                 ", DAG nodes: " << dag.getVectorSize(DAGNODE) << ", DAG depth: " << dag.getDepth() << std::endl;
+    std::cout << std::endl;
+}
+
 
 
 
@@ -406,35 +411,8 @@ void TrapezoidalMapManager::queryTrapezoidalMapAndMeasureTime(const cg3::Point2d
  */
 std::vector<cg3::Segment2d> TrapezoidalMapManager::generateRandomNonIntersectingSegments(size_t n, double radius) //Do not write code here
 {
-    double lower_bound = -radius + 1;
-    double upper_bound = radius - 1;
-
-    std::mt19937 rng;
-    rng.seed(std::random_device()());
-
-    std::vector<cg3::Point2d> randomPoints;
-    for (size_t i = 0; i < n * 10; i++) {
-        cg3::Point2d p;
-
-        std::uniform_real_distribution<double> dist(lower_bound,upper_bound);
-        p.setXCoord(dist(rng));
-        p.setYCoord(dist(rng));
-
-        randomPoints.push_back(p);
-    }
-
-    TrapezoidalMapDataset dataset;
-    while (dataset.segmentNumber() < n) {
-        std::uniform_int_distribution<int> dist(0, randomPoints.size() - 1);
-
-        cg3::Point2d p1 = randomPoints[static_cast<size_t>(dist(rng))];
-        cg3::Point2d p2 = randomPoints[static_cast<size_t>(dist(rng))];
-
-        bool insertedSegment;
-        dataset.addSegment(cg3::Segment2d(p1, p2), insertedSegment);
-    }
-
-    return dataset.getSegments();
+    //The generator lives in RandomUtils, so that it can also be used without the GUI
+    return RandomUtils::generateRandomNonIntersectingSegments(n, radius, std::random_device()());
 }
 
 /**
@@ -550,29 +528,22 @@ void TrapezoidalMapManager::on_loadSegmentsButton_clicked() //Do not write code
         //Load input segments in the vector (deleting the previous ones)
         std::vector<cg3::Segment2d> segments = FileUtils::getSegmentsFromFile(filename.toStdString());
 
-        //Add to the dataset
-        bool allSegmentInserted = true;
-        for (const cg3::Segment2d& segment : segments) {
-            bool insertedSegment;
-            drawableTrapezoidalMapDataset.addSegment(segment, insertedSegment);
-
-            allSegmentInserted &= insertedSegment;
-            if (!insertedSegment) {
-                std::cout << "The segment " << segment <<
-                    " will be ignored because it has intersections with other segments, "
-                    "it is degenerate, or a point has the same x-coordinate of another point." << std::endl;
-            }
+        //Add to the dataset, all the segments are validated together
+        std::vector<TrapezoidalMapDataset::RejectedSegment> rejected = drawableTrapezoidalMapDataset.addSegments(segments);
+        for (const TrapezoidalMapDataset::RejectedSegment& r : rejected) {
+            std::cout << "The segment " << segments[r.index] << " will be ignored because " <<
+                TrapezoidalMapDataset::rejectionReasonDescription(r.reason) << "." << std::endl;
         }
-        if (!allSegmentInserted) {
+        if (!rejected.empty()) {
             //Error message cannot add an intersecting segment
             QMessageBox::warning(this, "Cannot insert all segments",
                 "Some segment have be ignored because they have intersections with other segments, "
                 "they are degenerate, or a point has the same x-coordinate of another point.");
         }
 
-        //Launch the algorithm on the current vector of segments and measure
+        //Launch the randomized algorithm on the segments accepted by the dataset and measure
         //its efficiency with a timer
-        loadSegmentsTrapezoidalMapAndMeasureTime(segments);
+        loadSegmentsRandomizedTrapezoidalMapAndMeasureTime(drawableTrapezoidalMapDataset.getSegments(), std::random_device()());
 
         //The trapezoidal map has been changed, so we update the canvas for drawing.
         updateCanvas();
@@ -607,9 +578,9 @@ void TrapezoidalMapManager::on_randomSegmentsButton_clicked() //Do not write cod
         assert(insertedSegment);
     }
 
-    //Launch the algorithm on the current vector of segments and measure
+    //Launch the randomized algorithm on the current vector of segments and measure
     //its efficiency with a timer
-    loadSegmentsTrapezoidalMapAndMeasureTime(segments);
+    loadSegmentsRandomizedTrapezoidalMapAndMeasureTime(segments, std::random_device()());
 
     //The trapezoidal map has been changed, so we update the canvas for drawing.
     updateCanvas();
@@ -62,6 +62,7 @@ private:
     //Declare your attributes here
     DrawableTrapezoidalMap drawableMap;
     Dag dag;
+    unsigned long buildSeed; //the seed of the last randomized construction
 
 
     //#####################################################################
@@ -79,6 +80,7 @@ private:
     //---------------------------------------------------------------------
     //Declare your private methods here if you need some
 
+    void loadSegmentsRandomizedTrapezoidalMapAndMeasureTime(const std::vector<cg3::Segment2d>& segments, unsigned long seed);
 
 
 
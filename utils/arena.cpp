@@ -0,0 +1,70 @@
+#include "arena.h"
+
+#include <cstdint>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#define ARENA_MMAP
+#endif
+
+#define ARENA_HUGE_PAGE (size_t(2) << 20) // the size of a huge page, the blocks smaller than a huge page use normal pages
+
+/**
+ * @brief ArenaMemory::allocate
+ * This method allocates a block of an arena. The block is mapped from the system, so its pages are committed only
+ * when they are written. With huge pages the block is aligned to a huge page and the system is advised to back it
+ * with transparent huge pages.
+ * @param bytes the size of the block
+ * @param hugePages true to use huge pages
+ * @return the address of the block
+ * @throws std::bad_alloc if the block can't be allocated
+ */
+void* ArenaMemory::allocate(size_t bytes, bool hugePages){
+#ifdef ARENA_MMAP
+    //the blocks of a huge page or more are rounded up to whole huge pages, release() does the same
+    size_t size = bytes < ARENA_HUGE_PAGE ? bytes : (bytes + ARENA_HUGE_PAGE - 1) / ARENA_HUGE_PAGE * ARENA_HUGE_PAGE;
+    if(hugePages && bytes >= ARENA_HUGE_PAGE){
+        //a huge page more is mapped, then the pages before the first aligned address and after the block are unmapped
+        void * address = mmap(nullptr, size + ARENA_HUGE_PAGE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if(address == MAP_FAILED){
+            throw std::bad_alloc();
+        }
+        char * begin = static_cast<char *>(address);
+        char * aligned = begin + (ARENA_HUGE_PAGE - reinterpret_cast<uintptr_t>(begin) % ARENA_HUGE_PAGE) % ARENA_HUGE_PAGE;
+        if(aligned > begin){
+            munmap(begin, size_t(aligned - begin));
+        }
+        munmap(aligned + size, size_t(begin + ARENA_HUGE_PAGE - aligned));
+#ifdef MADV_HUGEPAGE
+        madvise(aligned, size, MADV_HUGEPAGE);
+#endif
+        return aligned;
+    }
+    void * address = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(address == MAP_FAILED){
+        throw std::bad_alloc();
+    }
+    return address;
+#else
+    (void)hugePages;
+    return ::operator new(bytes);
+#endif
+}
+
+/**
+ * @brief ArenaMemory::release
+ * This method returns a block of an arena to the system
+ * @param address the address of the block
+ * @param bytes the size of the block, as given to allocate()
+ */
+void ArenaMemory::release(void* address, size_t bytes){
+#ifdef ARENA_MMAP
+    if(bytes >= ARENA_HUGE_PAGE){
+        bytes = (bytes + ARENA_HUGE_PAGE - 1) / ARENA_HUGE_PAGE * ARENA_HUGE_PAGE;
+    }
+    munmap(address, bytes);
+#else
+    (void)bytes;
+    ::operator delete(address);
+#endif
+}
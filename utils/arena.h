@@ -0,0 +1,330 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include <utility>
+
+#define ARENA_MIN_BLOCK_BITS 10                       // the log2 of the capacity of the first growth block
+#define ARENA_MIN_BLOCK (size_t(1) << ARENA_MIN_BLOCK_BITS) // the capacity of the first growth block
+#define ARENA_MAX_BLOCKS 48                           // the number of growth blocks, enough for any size that can be allocated
+
+namespace ArenaMemory {
+    void* allocate(size_t bytes, bool hugePages);
+    void release(void* address, size_t bytes);
+}
+
+/**
+ * @brief The Arena class
+ * A table of elements addressed by their index, stored in a few large blocks. The first block has the capacity
+ * given to reserve(), the blocks added when it is full double in size, so the elements are never moved or copied
+ * once inserted and the references to them stay valid until the arena is cleared.
+ * The blocks are mapped directly from the system where possible, so the pages of a block that are never written
+ * are never committed, and they can be backed by huge pages.
+ * The elements are not destroyed one by one: clear() and the destructor release the blocks, without visiting the
+ * elements. The arena is meant for types whose destructor does nothing, like the trapezoids, the dag nodes and the
+ * points and segments of cg3.
+ */
+template<typename T>
+class Arena
+{
+    public:
+        class const_iterator;
+
+        //constructors
+        Arena();
+        Arena(const Arena& other);
+        Arena(Arena&& other);
+        Arena& operator=(Arena other);
+        ~Arena();
+
+        //methods for managing the elements
+        void reserve(size_t n);
+        size_t pushBack(const T& element);
+        void resize(size_t n);
+        void clear();
+        void setHugePages(bool hugePages);
+
+        //getters
+        T& operator[](size_t index);
+        const T& operator[](size_t index) const;
+        T& back();
+        size_t size() const;
+        size_t capacity() const;
+        size_t getReservedBytes() const;
+        bool empty() const;
+        bool getHugePages() const;
+
+        const_iterator begin() const;
+        const_iterator end() const;
+
+        /**
+         * @brief The const_iterator class
+         * A forward iterator on the elements of an arena, in the order of their indexes
+         */
+        class const_iterator{
+            public:
+                const_iterator(const Arena* arena, size_t index) : arena(arena), index(index) {}
+                const T& operator*() const { return (*arena)[index]; }
+                const T* operator->() const { return &(*arena)[index]; }
+                const_iterator& operator++() { index++; return *this; }
+                bool operator==(const const_iterator& other) const { return index == other.index; }
+                bool operator!=(const const_iterator& other) const { return index != other.index; }
+
+            private:
+                const Arena* arena;
+                size_t index;
+        };
+
+    private:
+        T* slot(size_t index) const;
+        void grow();
+        void swap(Arena& other);
+
+        T* first;                       //the first block, it has the capacity reserved before the first insertion
+        size_t firstCapacity;           //the number of elements of the first block
+        T* blocks[ARENA_MAX_BLOCKS];    //the growth blocks, the block k has ARENA_MIN_BLOCK << k elements
+        size_t growthBlocks;            //the number of growth blocks allocated
+        size_t count;                   //the number of elements
+        bool hugePages;                 //if the blocks are backed by huge pages
+};
+
+/**
+ * @brief Arena::Arena
+ * Constructor of an empty arena, no memory is allocated until the first insertion
+ */
+template<typename T>
+Arena<T>::Arena() :
+    first(nullptr), firstCapacity(0), growthBlocks(0), count(0), hugePages(false)
+{
+}
+
+/**
+ * @brief Arena::Arena
+ * Copy constructor, the elements of other are copied in a single block
+ */
+template<typename T>
+Arena<T>::Arena(const Arena& other) :
+    Arena()
+{
+    hugePages = other.hugePages;
+    reserve(other.count);
+    for(size_t i = 0; i < other.count; i++){
+        pushBack(other[i]);
+    }
+}
+
+/**
+ * @brief Arena::Arena
+ * Move constructor, the blocks of other are moved and other is left empty
+ */
+template<typename T>
+Arena<T>::Arena(Arena&& other) :
+    Arena()
+{
+    swap(other);
+}
+
+template<typename T>
+Arena<T>& Arena<T>::operator=(Arena other){
+    swap(other);
+    return *this;
+}
+
+template<typename T>
+Arena<T>::~Arena(){
+    clear();
+}
+
+/**
+ * @brief Arena::reserve
+ * This method makes room for n elements. When the arena has no blocks, the first block is allocated with exactly
+ * n elements, otherwise growth blocks are added. The elements already inserted are never moved.
+ * @param n the number of elements
+ */
+template<typename T>
+void Arena<T>::reserve(size_t n){
+    if(first == nullptr){
+        if(n > 0){
+            first = static_cast<T*>(ArenaMemory::allocate(n * sizeof(T), hugePages));
+            firstCapacity = n;
+        }
+        return;
+    }
+    while(capacity() < n){
+        grow();
+    }
+}
+
+/**
+ * @brief Arena::pushBack
+ * This method inserts an element after the last one, the arena grows by a block when it is full
+ * @param element the element to insert
+ * @return the index of the element
+ */
+template<typename T>
+size_t Arena<T>::pushBack(const T& element){
+    if(count == capacity()){
+        if(first == nullptr){
+            reserve(ARENA_MIN_BLOCK);
+        }
+        else{
+            grow();
+        }
+    }
+    new (slot(count)) T(element);
+    return count++;
+}
+
+/**
+ * @brief Arena::resize
+ * This method changes the number of elements, the new elements are default constructed
+ * @param n the new number of elements
+ */
+template<typename T>
+void Arena<T>::resize(size_t n){
+    reserve(n);
+    while(count < n){
+        new (slot(count)) T();
+        count++;
+    }
+    count = std::min(count, n);
+}
+
+/**
+ * @brief Arena::clear
+ * This method removes all the elements and releases the blocks. The elements are not visited, so the cost doesn't
+ * depend on their number.
+ */
+template<typename T>
+void Arena<T>::clear(){
+    if(first != nullptr){
+        ArenaMemory::release(first, firstCapacity * sizeof(T));
+    }
+    for(size_t k = 0; k < growthBlocks; k++){
+        ArenaMemory::release(blocks[k], (ARENA_MIN_BLOCK << k) * sizeof(T));
+    }
+    first = nullptr;
+    firstCapacity = 0;
+    growthBlocks = 0;
+    count = 0;
+}
+
+/**
+ * @brief Arena::setHugePages
+ * This method chooses if the blocks allocated from now on are backed by huge pages, where the system supports them
+ * @param hugePages true to use huge pages
+ */
+template<typename T>
+void Arena<T>::setHugePages(bool hugePages){
+    this->hugePages = hugePages;
+}
+
+template<typename T>
+inline T& Arena<T>::operator[](size_t index){
+    return *slot(index);
+}
+
+template<typename T>
+inline const T& Arena<T>::operator[](size_t index) const{
+    return *slot(index);
+}
+
+template<typename T>
+T& Arena<T>::back(){
+    return (*this)[count - 1];
+}
+
+template<typename T>
+size_t Arena<T>::size() const{
+    return count;
+}
+
+/**
+ * @brief Arena::capacity
+ * @return the number of elements that can be inserted without allocating a block
+ */
+template<typename T>
+size_t Arena<T>::capacity() const{
+    return firstCapacity + ((ARENA_MIN_BLOCK << growthBlocks) - ARENA_MIN_BLOCK);
+}
+
+/**
+ * @brief Arena::getReservedBytes
+ * @return the bytes of the blocks, the pages that have never been written may not be committed
+ */
+template<typename T>
+size_t Arena<T>::getReservedBytes() const{
+    return capacity() * sizeof(T);
+}
+
+template<typename T>
+bool Arena<T>::empty() const{
+    return count == 0;
+}
+
+template<typename T>
+bool Arena<T>::getHugePages() const{
+    return hugePages;
+}
+
+template<typename T>
+typename Arena<T>::const_iterator Arena<T>::begin() const{
+    return const_iterator(this, 0);
+}
+
+template<typename T>
+typename Arena<T>::const_iterator Arena<T>::end() const{
+    return const_iterator(this, count);
+}
+
+/**
+ * @brief Arena::slot
+ * This method finds the address of an element: the growth blocks start at firstCapacity and the block k holds the
+ * elements from (ARENA_MIN_BLOCK << k) - ARENA_MIN_BLOCK, so the block is given by the highest bit of the position
+ * @param index the index of the element
+ * @return the address of the element
+ */
+template<typename T>
+inline T* Arena<T>::slot(size_t index) const{
+    if(index < firstCapacity){
+        return first + index;
+    }
+    size_t position = index - firstCapacity + ARENA_MIN_BLOCK;
+    size_t k = 0;
+#if defined(__GNUC__) || defined(__clang__)
+    k = size_t(63 - __builtin_clzll(static_cast<unsigned long long>(position)));
+#else
+    for(size_t p = position; p > 1; p >>= 1){
+        k++;
+    }
+#endif
+    k -= ARENA_MIN_BLOCK_BITS;
+    return blocks[k] + (position - (ARENA_MIN_BLOCK << k));
+}
+
+/**
+ * @brief Arena::grow
+ * This method allocates the next growth block, twice the size of the previous one
+ */
+template<typename T>
+void Arena<T>::grow(){
+    if(growthBlocks == ARENA_MAX_BLOCKS){
+        throw std::bad_alloc();
+    }
+    blocks[growthBlocks] = static_cast<T*>(ArenaMemory::allocate((ARENA_MIN_BLOCK << growthBlocks) * sizeof(T), hugePages));
+    growthBlocks++;
+}
+
+template<typename T>
+void Arena<T>::swap(Arena& other){
+    std::swap(first, other.first);
+    std::swap(firstCapacity, other.firstCapacity);
+    std::swap(blocks, other.blocks);
+    std::swap(growthBlocks, other.growthBlocks);
+    std::swap(count, other.count);
+    std::swap(hugePages, other.hugePages);
+}
+
+#endif // ARENA_H
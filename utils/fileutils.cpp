@@ -1,54 +1,415 @@
 #include "fileutils.h"
 
+#include <algorithm>
+#include <clocale>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <fstream>
 #include <random>
 #include <iomanip>
+#include <sstream>
+#include <thread>
 
 #include "assert.h"
 
 #include "data_structures/trapezoidalmap_dataset.h"
+#include "utils/mappedfile.h"
+
+#define PARSE_CHUNK (1 << 20)          // the minimum number of bytes of text parsed by a thread
+#define SEGMENT_FILE_VERSION 2         // the version of the binary segment format, 2 adds the metadata
+#define SEGMENT_FILE_BYTE_ORDER 0x01020304
+
+namespace {
+
+const char SEGMENT_FILE_MAGIC[8] = {'T','R','A','P','S','E','G','\0'};
+
+/**
+ * @brief The SegmentFileHeader struct
+ * The header of a binary segment file, it is followed by the metadata text, padded to a multiple of 8 bytes,
+ * and by the coordinates x1 y1 x2 y2 of every segment as doubles. The files of version 1 have no metadata
+ * and their header ends after the number of segments.
+ */
+struct SegmentFileHeader{
+    char magic[8];          //"TRAPSEG" followed by a 0
+    uint32_t version;       //SEGMENT_FILE_VERSION
+    uint32_t byteOrder;     //0x01020304 written in the byte order of the machine that saved the file
+    uint64_t segments;      //the number of segments
+    uint64_t metadata;      //the size of the metadata text, since version 2
+};
+
+#define SEGMENT_FILE_HEADER_V1 24 // the size of the header of version 1
+
+/**
+ * @brief isSpace
+ * @return true if c separates two numbers in a segment file
+ */
+inline bool isSpace(char c){
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\v' || c == '\f';
+}
+
+/**
+ * @brief isDigit
+ * @return true if c is a decimal digit
+ */
+inline bool isDigit(char c){
+    return c >= '0' && c <= '9';
+}
+
+/**
+ * @brief slowParseDouble
+ * Parses a number that can't be converted exactly by parseDouble(). The number is copied, replacing the '.'
+ * with the decimal point of the C locale, because strtod depends on the locale
+ * @param begin the first character of the number
+ * @param end the character after the number
+ * @param decimalPoint the decimal point of the C locale
+ * @return the number
+ */
+double slowParseDouble(const char * begin, const char * end, char decimalPoint){
+    std::string token(begin, end);
+    std::replace(token.begin(), token.end(), '.', decimalPoint);
+    return std::strtod(token.c_str(), nullptr);
+}
+
+/**
+ * @brief parseDouble
+ * Parses a number of a segment file, independently from the locale. When the significant digits fit a double
+ * and the power of ten is exact the number is converted with a single rounding, so the result is the closest double
+ * as with strtod. The other numbers (more than 15-16 digits, big exponents) are converted by strtod.
+ * @param[in,out] p the first character of the number, the character after the number when the method returns
+ * @param end the end of the text
+ * @param decimalPoint the decimal point of the C locale, for the numbers converted by strtod
+ * @param[out] value the number
+ * @return false if there is no number at p
+ */
+bool parseDouble(const char *& p, const char * end, char decimalPoint, double& value){
+    static const double POW10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                   1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+    const char * begin = p;
+    bool negative = false;
+    if(p < end && (*p == '-' || *p == '+')){
+        negative = *p == '-';
+        p++;
+    }
+
+    uint64_t mantissa = 0;  //the significant digits
+    int digits = 0;         //the number of significant digits in the mantissa
+    int exponent = 0;       //the power of ten of the mantissa
+    bool truncated = false; //true if some significant digits don't fit the mantissa
+    bool any = false;       //true if there is at least a digit
+    for(; p < end && isDigit(*p); p++){
+        any = true;
+        if(digits < 19){
+            mantissa = mantissa * 10 + uint64_t(*p - '0');
+            digits += mantissa > 0 ? 1 : 0;
+        }
+        else{
+            exponent++;
+            truncated |= *p != '0';
+        }
+    }
+    if(p < end && *p == '.'){
+        for(p++; p < end && isDigit(*p); p++){
+            any = true;
+            if(digits < 19){
+                mantissa = mantissa * 10 + uint64_t(*p - '0');
+                digits += mantissa > 0 ? 1 : 0;
+                exponent--;
+            }
+            else{
+                truncated |= *p != '0';
+            }
+        }
+    }
+    if(!any){
+        p = begin;
+        return false;
+    }
+    if(p < end && (*p == 'e' || *p == 'E')){
+        const char * e = p + 1;
+        bool negativeExponent = false;
+        if(e < end && (*e == '-' || *e == '+')){
+            negativeExponent = *e == '-';
+            e++;
+        }
+        if(e < end && isDigit(*e)){
+            int value = 0;
+            for(; e < end && isDigit(*e); e++){
+                value = std::min(value * 10 + (*e - '0'), 100000);
+            }
+            exponent += negativeExponent ? -value : value;
+            p = e;
+        }
+    }
+
+    if(!truncated && mantissa <= (uint64_t(1) << 53) && exponent >= -22 && exponent <= 22){
+        //both the mantissa and the power of ten are exact, so the division or the product is rounded once
+        value = exponent < 0 ? double(mantissa) / POW10[-exponent] : double(mantissa) * POW10[exponent];
+        value = negative ? -value : value;
+    }
+    else{
+        value = slowParseDouble(begin, p, decimalPoint);
+    }
+    return true;
+}
+
+/**
+ * @brief countNumbers
+ * @return the number of blank separated tokens in the text [begin, end)
+ */
+size_t countNumbers(const char * begin, const char * end){
+    size_t count = 0;
+    bool space = true;
+    for(const char * p = begin; p < end; p++){
+        bool s = isSpace(*p);
+        count += space && !s ? 1 : 0;
+        space = s;
+    }
+    return count;
+}
+
+/**
+ * @brief parseSegments
+ * Parses the segments that start in the text [begin, end). The first number of the text has position first
+ * among the numbers of the file: the numbers before the first complete segment belong to the segment parsed by
+ * the previous chunk, while the last segment is completed with the numbers after end.
+ * A token that is not a number, or that continues after a number, is a malformed segment: the parsing of the chunk
+ * stops there and the position of the segment is returned, so the segments of the file can be truncated before it.
+ * @param begin the first character of the chunk, it is the beginning of a number or a blank
+ * @param end the end of the chunk, it is the end of a number or a blank
+ * @param textEnd the end of the text of the file
+ * @param first the position of the first number of the chunk
+ * @param decimalPoint the decimal point of the C locale
+ * @param[out] segments the segments of the file, the segments of the chunk are written in their positions
+ * @return the position of the first malformed segment of the chunk, SIZE_MAX if there isn't any
+ */
+size_t parseSegments(const char * begin, const char * end, const char * textEnd, size_t first, char decimalPoint,
+                     std::vector<cg3::Segment2d>& segments){
+    const char * p = begin;
+    double value;
+    //skip the numbers of the segment started in the previous chunk
+    for(size_t skip = (4 - first % 4) % 4; skip > 0; skip--){
+        while(p < end && isSpace(*p)){
+            p++;
+        }
+        if(p >= end){
+            return SIZE_MAX;
+        }
+        if(!parseDouble(p, end, decimalPoint, value) || (p < end && !isSpace(*p))){
+            return first / 4; //the segment started in the previous chunk is malformed
+        }
+    }
+    size_t s = (first + 3) / 4;
+    while(s < segments.size()){
+        while(p < end && isSpace(*p)){
+            p++;
+        }
+        if(p >= end){
+            return SIZE_MAX; //the next segment starts in the next chunk
+        }
+        double c[4];
+        for(size_t i = 0; i < 4; i++){
+            while(p < textEnd && isSpace(*p)){
+                p++;
+            }
+            if(!parseDouble(p, textEnd, decimalPoint, c[i]) || (p < textEnd && !isSpace(*p))){
+                return s;
+            }
+        }
+        segments[s++] = cg3::Segment2d(cg3::Point2d(c[0], c[1]), cg3::Point2d(c[2], c[3]));
+    }
+    return SIZE_MAX;
+}
+
+/**
+ * @brief getSegmentsFromText
+ * Parses a text segment file: the number of segments followed by the coordinates x1 y1 x2 y2 of every segment.
+ * The lines starting with '#' before the number of segments are the metadata of the file.
+ * The text is divided in chunks at the blanks between the numbers and the chunks are parsed in parallel:
+ * the numbers of every chunk are counted first, so every thread knows the position of its segments in the output.
+ * A number of segments that is not a non-negative integer gives no segments, and the segments are truncated
+ * before the first malformed one.
+ * @param text the content of the file
+ * @param size the size of the file
+ * @param[out] metadata the metadata lines, without the '#'
+ * @return the segments of the file
+ */
+std::vector<cg3::Segment2d> getSegmentsFromText(const char * text, size_t size, std::string& metadata){
+    char decimalPoint = std::localeconv()->decimal_point[0];
+    const char * end = text + size;
+    const char * p = text;
+    metadata.clear();
+    while(true){
+        while(p < end && isSpace(*p)){
+            p++;
+        }
+        if(p >= end || *p != '#'){
+            break;
+        }
+        const char * line = ++p;
+        while(p < end && *p != '\n'){
+            p++;
+        }
+        if(line < p && *line == ' '){
+            line++;
+        }
+        metadata += (metadata.empty() ? "" : "\n") + std::string(line, p > line && p[-1] == '\r' ? p - 1 : p);
+    }
+    double n;
+    if(!parseDouble(p, end, decimalPoint, n) || (p < end && !isSpace(*p)) || !std::isfinite(n) || n < 0 || n != std::floor(n)){
+        return std::vector<cg3::Segment2d>();
+    }
+    //the number of segments is only trusted for the allocation if the file is big enough to contain them, the
+    //comparison is made on doubles so that a huge number is never converted
+    size_t count = n < double(size / 8) ? size_t(n) : size / 8;
+    std::vector<cg3::Segment2d> segments(count);
+
+    size_t threads = std::max<size_t>(1, std::min<size_t>(std::thread::hardware_concurrency(), (end - p) / PARSE_CHUNK));
+    std::vector<const char *> bounds(threads + 1, end);
+    bounds[0] = p;
+    for(size_t i = 1; i < threads; i++){
+        //a chunk ends at a blank, so no number is divided between two chunks
+        const char * b = std::max(bounds[i - 1], p + (end - p) / threads * i);
+        while(b < end && !isSpace(*b)){
+            b++;
+        }
+        bounds[i] = b;
+    }
+
+    std::vector<size_t> first(threads + 1, 0);
+    std::vector<std::thread> workers;
+    for(size_t i = 0; i < threads; i++){
+        workers.push_back(std::thread([&bounds, &first, i](){ first[i + 1] = countNumbers(bounds[i], bounds[i + 1]); }));
+    }
+    for(std::thread& w : workers){
+        w.join();
+    }
+    for(size_t i = 1; i <= threads; i++){
+        first[i] += first[i - 1];
+    }
+    if(first[threads] / 4 < segments.size()){
+        segments.resize(first[threads] / 4); //the file contains less segments than declared
+    }
+
+    workers.clear();
+    std::vector<size_t> malformed(threads, SIZE_MAX);
+    for(size_t i = 0; i < threads; i++){
+        workers.push_back(std::thread([&bounds, &first, &segments, &malformed, end, decimalPoint, i](){
+            malformed[i] = parseSegments(bounds[i], bounds[i + 1], end, first[i], decimalPoint, segments);
+        }));
+    }
+    for(std::thread& w : workers){
+        w.join();
+    }
+    size_t valid = *std::min_element(malformed.begin(), malformed.end());
+    if(valid < segments.size()){
+        segments.resize(valid); //the segments after a malformed one are not trusted
+    }
+    return segments;
+}
+
+/**
+ * @brief formatDouble
+ * Writes the shortest decimal representation of value that is parsed back to the same double
+ * @param value the number
+ * @param decimalPoint the decimal point of the C locale, used by snprintf
+ * @param[out] buffer the text of the number
+ */
+void formatDouble(double value, char decimalPoint, char buffer[32]){
+    for(int precision = 15; precision <= 17; precision++){
+        std::snprintf(buffer, 32, "%.*g", precision, value);
+        std::replace(buffer, buffer + std::strlen(buffer), decimalPoint, '.');
+        const char * p = buffer;
+        double parsed;
+        if(parseDouble(p, buffer + std::strlen(buffer), decimalPoint, parsed) && parsed == value){
+            return;
+        }
+    }
+}
+
+}
 
 namespace FileUtils {
 
+/**
+ * @brief Read the segments of a file. The file can be a text file, with the number of segments followed by the
+ * coordinates x1 y1 x2 y2 of every segment, or a binary file written by saveSegmentsInBinaryFile(). The file is
+ * mapped in memory and the text is parsed in parallel, without depending on the locale.
+ * @param filename Name of the file
+ * @return Vector of segments, empty if the file can't be read
+ */
 std::vector<cg3::Segment2d> getSegmentsFromFile(const std::string& filename) {
-    std::vector<cg3::Segment2d> segments;
-	
-	std::ifstream infile;
-    infile.open(filename);
-
-    int n;
-    infile >> n;
-
-    for (int i = 0; i < n; i++) {
-        double x = 0.0;
-        double y = 0.0;
-		
-        infile >> x >> y;
-        cg3::Point2d p1(x,y);
-		
-        infile >> x >> y;
-        cg3::Point2d p2(x,y);
-		
-        segments.push_back(cg3::Segment2d(p1, p2));
-    }
-	
-    return segments;
+    std::string metadata;
+    return getSegmentsFromFile(filename, metadata);
+}
+
+/**
+ * @brief Parse the segments and the metadata of the text of a segment file, already in memory: the same format
+ * of getSegmentsFromFile(), the segments are truncated before the first malformed one
+ * @param text The content of the file
+ * @param metadata The metadata of the text, empty if there isn't any
+ * @return Vector of segments, empty if the number of segments is not valid
+ */
+std::vector<cg3::Segment2d> getSegmentsFromString(const std::string& text, std::string& metadata) {
+    return getSegmentsFromText(text.data(), text.size(), metadata);
+}
+
+/**
+ * @brief Read the segments and the metadata of a file, see getSegmentsFromFile(const std::string&)
+ * @param filename Name of the file
+ * @param metadata The metadata of the file (e.g. the parameters of the generator), empty if there isn't any
+ * @return Vector of segments, empty if the file can't be read
+ */
+std::vector<cg3::Segment2d> getSegmentsFromFile(const std::string& filename, std::string& metadata) {
+    metadata.clear();
+    MappedFile file;
+    if (!file.open(filename)) {
+        return std::vector<cg3::Segment2d>();
+    }
+    if (file.getSize() >= SEGMENT_FILE_HEADER_V1 &&
+            std::memcmp(file.getData(), SEGMENT_FILE_MAGIC, sizeof(SEGMENT_FILE_MAGIC)) == 0) {
+        return getSegmentsFromBinaryFile(filename, metadata);
+    }
+    return getSegmentsFromText(file.getData(), file.getSize(), metadata);
 }
 
-std::vector<cg3::Segment2d> saveSegmentsInFile(const std::string& filename, const std::vector<cg3::Segment2d>& segments) {
+/**
+ * @brief Save the segments in a text file. Every coordinate is written with the shortest representation
+ * that is read back as the same double, so no precision is lost.
+ * @param filename Name of the file
+ * @param segments Vector of segments
+ * @param metadata Text written at the beginning of the file, every line preceded by '#'
+ * @return The segments
+ */
+std::vector<cg3::Segment2d> saveSegmentsInFile(const std::string& filename, const std::vector<cg3::Segment2d>& segments, const std::string& metadata) {
     std::ofstream outfile;
     outfile.open(filename);
 
+    if (!metadata.empty()) {
+        std::istringstream lines(metadata);
+        std::string line;
+        while (std::getline(lines, line)) {
+            outfile << "# " << line << "\n";
+        }
+    }
     outfile << segments.size() << std::endl;
 
+    char decimalPoint = std::localeconv()->decimal_point[0];
+    char buffer[32];
     for (const cg3::Segment2d& segment : segments) {
         const cg3::Point2d& p1 = segment.p1();
         const cg3::Point2d& p2 = segment.p2();
 
-        outfile << std::fixed;
-        outfile << std::setprecision(4) << p1.x() << " " << std::setprecision(4) << p1.y() << " ";
-        outfile << std::setprecision(4) << p2.x() << " " << std::setprecision(4) << p2.y();
-        outfile << std::endl;
+        formatDouble(p1.x(), decimalPoint, buffer);
+        outfile << buffer << " ";
+        formatDouble(p1.y(), decimalPoint, buffer);
+        outfile << buffer << " ";
+        formatDouble(p2.x(), decimalPoint, buffer);
+        outfile << buffer << " ";
+        formatDouble(p2.y(), decimalPoint, buffer);
+        outfile << buffer << "\n";
     }
 
     outfile.close();
@@ -56,5 +417,90 @@ std::vector<cg3::Segment2d> saveSegmentsInFile(const std::string& filename, cons
     return segments;
 }
 
+/**
+ * @brief Read the segments of a binary file written by saveSegmentsInBinaryFile()
+ * @param filename Name of the file
+ * @return Vector of segments, empty if the file can't be read or it is not a valid segment file
+ */
+std::vector<cg3::Segment2d> getSegmentsFromBinaryFile(const std::string& filename) {
+    std::string metadata;
+    return getSegmentsFromBinaryFile(filename, metadata);
+}
+
+/**
+ * @brief Read the segments and the metadata of a binary file written by saveSegmentsInBinaryFile()
+ * @param filename Name of the file
+ * @param metadata The metadata of the file, empty if there isn't any
+ * @return Vector of segments, empty if the file can't be read or it is not a valid segment file
+ */
+std::vector<cg3::Segment2d> getSegmentsFromBinaryFile(const std::string& filename, std::string& metadata) {
+    metadata.clear();
+    MappedFile file;
+    if (!file.open(filename) || file.getSize() < SEGMENT_FILE_HEADER_V1) {
+        return std::vector<cg3::Segment2d>();
+    }
+    SegmentFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(&header, file.getData(), std::min(sizeof(header), file.getSize()));
+    if (std::memcmp(header.magic, SEGMENT_FILE_MAGIC, sizeof(SEGMENT_FILE_MAGIC)) != 0 ||
+            header.version < 1 || header.version > SEGMENT_FILE_VERSION || header.byteOrder != SEGMENT_FILE_BYTE_ORDER) {
+        return std::vector<cg3::Segment2d>();
+    }
+    uint64_t offset = SEGMENT_FILE_HEADER_V1;
+    if (header.version >= 2) {
+        offset = sizeof(header) + (header.metadata + 7) / 8 * 8;
+        if (file.getSize() < sizeof(header) || header.metadata > file.getSize() || offset > file.getSize()) {
+            return std::vector<cg3::Segment2d>();
+        }
+    }
+    if (header.segments > (file.getSize() - offset) / (4 * sizeof(double))) {
+        return std::vector<cg3::Segment2d>();
+    }
+    metadata.assign(file.getData() + sizeof(header), header.version >= 2 ? header.metadata : 0);
+
+    const double * coordinates = reinterpret_cast<const double *>(file.getData() + offset);
+    std::vector<cg3::Segment2d> segments;
+    segments.reserve(header.segments);
+    for (size_t i = 0; i < header.segments; i++) {
+        const double * c = coordinates + 4 * i;
+        segments.push_back(cg3::Segment2d(cg3::Point2d(c[0], c[1]), cg3::Point2d(c[2], c[3])));
+    }
+
+    return segments;
+}
+
+/**
+ * @brief Save the segments in a binary file: a header and the metadata followed by the coordinates x1 y1 x2 y2
+ * of every segment as doubles. The coordinates are stored exactly and the file can be read without parsing.
+ * @param filename Name of the file
+ * @param segments Vector of segments
+ * @param metadata Text stored in the file (e.g. the parameters of the generator)
+ * @return false if the file can't be written
+ */
+bool saveSegmentsInBinaryFile(const std::string& filename, const std::vector<cg3::Segment2d>& segments, const std::string& metadata) {
+    std::ofstream outfile(filename, std::ios::binary | std::ios::trunc);
+    if (!outfile) {
+        return false;
+    }
+
+    SegmentFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, SEGMENT_FILE_MAGIC, sizeof(SEGMENT_FILE_MAGIC));
+    header.version = SEGMENT_FILE_VERSION;
+    header.byteOrder = SEGMENT_FILE_BYTE_ORDER;
+    header.segments = segments.size();
+    header.metadata = metadata.size();
+    outfile.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    outfile.write(metadata.data(), std::streamsize(metadata.size()));
+    outfile.write("\0\0\0\0\0\0\0", std::streamsize((8 - metadata.size() % 8) % 8));
+
+    for (const cg3::Segment2d& segment : segments) {
+        double c[4] = {segment.p1().x(), segment.p1().y(), segment.p2().x(), segment.p2().y()};
+        outfile.write(reinterpret_cast<const char *>(c), sizeof(c));
+    }
+
+    outfile.close();
+    return bool(outfile);
+}
 
 }
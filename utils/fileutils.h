@@ -1,6 +1,7 @@
 #ifndef FILEUTILS_H
 #define FILEUTILS_H
 
+#include <string>
 #include <vector>
 #include <cg3/geometry/point2.h>
 #include <cg3/geometry/segment2.h>
@@ -8,8 +9,15 @@
 namespace FileUtils {
 
 std::vector<cg3::Segment2d> getSegmentsFromFile(const std::string& filename);
+std::vector<cg3::Segment2d> getSegmentsFromFile(const std::string& filename, std::string& metadata);
+std::vector<cg3::Segment2d> getSegmentsFromString(const std::string& text, std::string& metadata);
 
-std::vector<cg3::Segment2d> saveSegmentsInFile(const std::string& filename, const std::vector<cg3::Segment2d>& segments);
+std::vector<cg3::Segment2d> saveSegmentsInFile(const std::string& filename, const std::vector<cg3::Segment2d>& segments, const std::string& metadata = "");
+
+std::vector<cg3::Segment2d> getSegmentsFromBinaryFile(const std::string& filename);
+std::vector<cg3::Segment2d> getSegmentsFromBinaryFile(const std::string& filename, std::string& metadata);
+
+bool saveSegmentsInBinaryFile(const std::string& filename, const std::vector<cg3::Segment2d>& segments, const std::string& metadata = "");
 
 }
 
@@ -0,0 +1,117 @@
+#include "mappedfile.h"
+
+#include <cstdint>
+#include <fstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define MAPPED_FILE_MMAP
+#endif
+
+#define MAPPED_FILE_ALIGNMENT 64 // the alignment of the buffer, a cache line
+
+/**
+ * @brief MappedFile::MappedFile
+ * Constructor of an empty mapped file
+ */
+MappedFile::MappedFile():
+    data(nullptr), size(0), mapped(false), buffer(nullptr)
+{
+}
+
+/**
+ * @brief MappedFile::~MappedFile
+ * Destructor of the mapped file, the file is unmapped or the buffer is freed
+ */
+MappedFile::~MappedFile(){
+    close();
+}
+
+/**
+ * @brief MappedFile::open
+ * This method maps a file in memory, or reads it in a buffer if it can't be mapped.
+ * The file previously opened is closed.
+ * @param filename the name of the file
+ * @return false if the file can't be read
+ */
+bool MappedFile::open(const std::string& filename){
+    close();
+#ifdef MAPPED_FILE_MMAP
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if(fd >= 0){
+        struct stat st;
+        if(fstat(fd, &st) == 0 && st.st_size > 0){
+            void * address = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if(address != MAP_FAILED){
+                data = static_cast<const char *>(address);
+                size = size_t(st.st_size);
+                mapped = true;
+            }
+        }
+        ::close(fd);
+    }
+    if(mapped){
+        return true;
+    }
+#endif
+    std::ifstream in(filename, std::ios::binary | std::ios::ate);
+    if(!in){
+        return false;
+    }
+    size = size_t(in.tellg());
+    in.seekg(0);
+    //the buffer is aligned as a mapped file would be
+    buffer = new char[size + MAPPED_FILE_ALIGNMENT];
+    char * aligned = buffer + (MAPPED_FILE_ALIGNMENT - reinterpret_cast<uintptr_t>(buffer) % MAPPED_FILE_ALIGNMENT) % MAPPED_FILE_ALIGNMENT;
+    in.read(aligned, std::streamsize(size));
+    data = aligned;
+    if(!in){
+        close();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief MappedFile::close
+ * This method unmaps the file or frees the buffer
+ */
+void MappedFile::close(){
+#ifdef MAPPED_FILE_MMAP
+    if(mapped){
+        munmap(const_cast<char *>(data), size);
+    }
+#endif
+    delete[] buffer;
+    data = nullptr;
+    size = 0;
+    buffer = nullptr;
+    mapped = false;
+}
+
+/**
+ * @brief MappedFile::getData
+ * @return a pointer to the content of the file, nullptr if no file is open
+ */
+const char* MappedFile::getData() const{
+    return data;
+}
+
+/**
+ * @brief MappedFile::getSize
+ * @return the size of the file in bytes
+ */
+size_t MappedFile::getSize() const{
+    return size;
+}
+
+/**
+ * @brief MappedFile::isMemoryMapped
+ * @return true if the file is mapped in memory, false if it has been read in a buffer
+ */
+bool MappedFile::isMemoryMapped() const{
+    return mapped;
+}
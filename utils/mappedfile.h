@@ -0,0 +1,36 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <string>
+
+/**
+ * @brief The MappedFile class
+ * A read-only file mapped in memory. On the systems without mmap, or when the file can't be mapped,
+ * the file is read in a single buffer. In both cases the content starts at an address aligned to
+ * a cache line.
+ */
+class MappedFile
+{
+    public:
+        //constructors
+        MappedFile();
+        ~MappedFile();
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        bool open(const std::string& filename);
+        void close();
+
+        //getters
+        const char* getData() const;
+        size_t getSize() const;
+        bool isMemoryMapped() const;
+
+    private:
+        const char * data;   //the content of the file
+        size_t size;         //the size of the file
+        bool mapped;         //true if data is mapped in memory, false if it has been read in buffer
+        char * buffer;       //the buffer allocated when the file can't be mapped
+};
+
+#endif // MAPPEDFILE_H
@@ -0,0 +1,67 @@
+#include "randomutils.h"
+
+#include <random>
+
+#include "data_structures/trapezoidalmap_dataset.h"
+
+namespace RandomUtils {
+
+/**
+ * @brief Generate random points, uniformly distributed in a square centered in the origin
+ * @param n Number of points
+ * @param radius Radius from origin
+ * @param seed Seed of the random number generator
+ * @return Vector of points
+ */
+std::vector<cg3::Point2d> generateRandomPoints(size_t n, double radius, unsigned long seed) {
+    double lower_bound = -radius + 1;
+    double upper_bound = radius - 1;
+
+    std::mt19937 rng;
+    rng.seed(seed);
+
+    std::vector<cg3::Point2d> randomPoints;
+    randomPoints.reserve(n);
+    for (size_t i = 0; i < n; i++) {
+        cg3::Point2d p;
+
+        std::uniform_real_distribution<double> dist(lower_bound,upper_bound);
+        p.setXCoord(dist(rng));
+        p.setYCoord(dist(rng));
+
+        randomPoints.push_back(p);
+    }
+
+    return randomPoints;
+}
+
+/**
+ * @brief Generate random non intersecting and non degenerate segments. The endpoints are
+ * picked among 10*n random points until the dataset accepts n segments, so the same seed
+ * always gives the same segments.
+ * @param n Number of segments
+ * @param radius Radius from origin
+ * @param seed Seed of the random number generator
+ * @return Vector of segments
+ */
+std::vector<cg3::Segment2d> generateRandomNonIntersectingSegments(size_t n, double radius, unsigned long seed) {
+    std::mt19937 rng;
+    rng.seed(seed);
+
+    std::vector<cg3::Point2d> randomPoints = generateRandomPoints(n * 10, radius, rng());
+
+    TrapezoidalMapDataset dataset;
+    while (dataset.segmentNumber() < n) {
+        std::uniform_int_distribution<int> dist(0, randomPoints.size() - 1);
+
+        cg3::Point2d p1 = randomPoints[static_cast<size_t>(dist(rng))];
+        cg3::Point2d p2 = randomPoints[static_cast<size_t>(dist(rng))];
+
+        bool insertedSegment;
+        dataset.addSegment(cg3::Segment2d(p1, p2), insertedSegment);
+    }
+
+    return dataset.getSegments();
+}
+
+}
@@ -0,0 +1,16 @@
+#ifndef RANDOMUTILS_H
+#define RANDOMUTILS_H
+
+#include <vector>
+#include <cg3/geometry/point2.h>
+#include <cg3/geometry/segment2.h>
+
+namespace RandomUtils {
+
+std::vector<cg3::Point2d> generateRandomPoints(size_t n, double radius, unsigned long seed);
+
+std::vector<cg3::Segment2d> generateRandomNonIntersectingSegments(size_t n, double radius, unsigned long seed);
+
+}
+
+#endif // RANDOMUTILS_H
@@ -0,0 +1,501 @@
+#include "segmentgenerator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <locale>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+#define GENERATOR_CHUNK 65536  // the minimum number of elements generated by a thread
+#define GENERATOR_MARGIN 0.9   // the fraction of the free space of a cell used by its segment
+#define GENERATOR_PI 3.14159265358979323846
+
+namespace {
+
+/**
+ * @brief The Random struct
+ * A splitmix64 generator. Every element is generated with its own stream, given by the seed and by the
+ * position of the element, so the result doesn't depend on the order in which the elements are generated
+ * or on the number of threads. The conversions to double are written explicitly, so the numbers are the same
+ * with every standard library.
+ */
+struct Random {
+    uint64_t state;
+
+    Random(uint64_t seed, uint64_t stream) : state(seed)
+    {
+        state = next() ^ (stream * 0xd1b54a32d192ed03ULL);
+        next();
+    }
+
+    uint64_t next()
+    {
+        uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+
+    //a number in [0, 1)
+    double uniform()
+    {
+        return double(next() >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+    double uniform(double min, double max)
+    {
+        return min + (max - min) * uniform();
+    }
+
+    //a number with the standard normal distribution (Box-Muller)
+    double normal()
+    {
+        double u = 1.0 - uniform();
+        return std::sqrt(-2.0 * std::log(u)) * std::cos(2.0 * GENERATOR_PI * uniform());
+    }
+
+    //a number in [0, n)
+    uint64_t below(uint64_t n)
+    {
+        return next() % n;
+    }
+};
+
+//the streams of the random numbers that are not bound to an element
+const uint64_t STREAM_CENTERS = UINT64_MAX;
+const uint64_t STREAM_SHUFFLE = UINT64_MAX - 1;
+const uint64_t STREAM_CELLS = uint64_t(1) << 62;
+
+/**
+ * @brief Runs task(begin, end) on contiguous ranges of [0, n) on several threads
+ */
+template<typename Task>
+void parallelRanges(size_t n, size_t threads, const Task& task)
+{
+    threads = std::max<size_t>(1, std::min(threads, n / GENERATOR_CHUNK));
+    std::vector<std::thread> workers;
+    for (size_t t = 1; t < threads; t++) {
+        workers.push_back(std::thread(task, n * t / threads, n * (t + 1) / threads));
+    }
+    task(size_t(0), n / threads);
+    for (std::thread& w : workers) {
+        w.join();
+    }
+}
+
+/**
+ * @brief The rectangle of a cell of the partition of the points
+ */
+struct Cell {
+    double minX, minY, maxX, maxY;
+};
+
+/**
+ * @brief Partitions the points [begin, end) of a cell in cells that contain a single point, splitting the cells
+ * by the median point on their longer side, and generates a segment inside every final cell: the segments are in
+ * disjoint cells, so they don't intersect. The points are compared by a total order, so the cells don't depend on
+ * the implementation of std::nth_element.
+ * @param points The points, they are reordered
+ * @param begin The first point of the cell
+ * @param end The end of the points of the cell
+ * @param cell The rectangle of the cell
+ * @param seed The seed of the segments
+ * @param threads The number of threads that can be used for the cell
+ * @param segments The segments, the segment of the point in position i is written in position i
+ */
+void partitionCells(std::vector<cg3::Point2d>& points, size_t begin, size_t end, Cell cell, unsigned long seed,
+                    size_t threads, std::vector<cg3::Segment2d>& segments)
+{
+    if (end - begin == 1) {
+        const cg3::Point2d& p = points[begin];
+        Random r(seed, STREAM_CELLS + begin);
+        double free = std::min(std::min(p.x() - cell.minX, cell.maxX - p.x()), std::min(p.y() - cell.minY, cell.maxY - p.y()));
+        double half = free * GENERATOR_MARGIN * r.uniform(0.25, 1);
+        double angle = r.uniform(0, 2 * GENERATOR_PI);
+        double dx = half * std::cos(angle), dy = half * std::sin(angle);
+        segments[begin] = cg3::Segment2d(cg3::Point2d(p.x() - dx, p.y() - dy), cg3::Point2d(p.x() + dx, p.y() + dy));
+        return;
+    }
+
+    bool vertical = cell.maxX - cell.minX >= cell.maxY - cell.minY; //split by a vertical line
+    auto less = [vertical](const cg3::Point2d& a, const cg3::Point2d& b) {
+        if (vertical) {
+            return a.x() < b.x() || (a.x() == b.x() && a.y() < b.y());
+        }
+        return a.y() < b.y() || (a.y() == b.y() && a.x() < b.x());
+    };
+    size_t middle = begin + (end - begin) / 2;
+    std::nth_element(points.begin() + begin, points.begin() + middle, points.begin() + end, less);
+    const cg3::Point2d& lower = *std::max_element(points.begin() + begin, points.begin() + middle, less);
+    const cg3::Point2d& upper = points[middle];
+
+    Cell left = cell, right = cell;
+    if (vertical) {
+        left.maxX = right.minX = (lower.x() + upper.x()) / 2;
+    }
+    else {
+        left.maxY = right.minY = (lower.y() + upper.y()) / 2;
+    }
+
+    if (threads > 1) {
+        std::thread worker(partitionCells, std::ref(points), begin, middle, left, seed, threads / 2, std::ref(segments));
+        partitionCells(points, middle, end, right, seed, threads - threads / 2, segments);
+        worker.join();
+    }
+    else {
+        partitionCells(points, begin, middle, left, seed, 1, segments);
+        partitionCells(points, middle, end, right, seed, 1, segments);
+    }
+}
+
+/**
+ * @brief Generates the segments of the UNIFORM and CLUSTERED distributions: one point for every segment,
+ * then a short segment around every point, inside its cell of the partition of the points
+ */
+std::vector<cg3::Segment2d> generateCellSegments(const SegmentGenerator::Parameters& p, size_t threads)
+{
+    double r = p.radius;
+    std::vector<cg3::Point2d> centers;
+    if (p.distribution == SegmentGenerator::CLUSTERED) {
+        Random random(p.seed, STREAM_CENTERS);
+        for (size_t i = 0; i < std::max<size_t>(1, p.clusters); i++) {
+            double x = random.uniform(-0.8 * r, 0.8 * r);
+            double y = random.uniform(-0.8 * r, 0.8 * r);
+            centers.push_back(cg3::Point2d(x, y));
+        }
+    }
+
+    std::vector<cg3::Point2d> points(p.segments);
+    parallelRanges(p.segments, threads, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            Random random(p.seed, i);
+            double x = random.uniform(-r, r), y = random.uniform(-r, r);
+            if (!centers.empty()) {
+                const cg3::Point2d& c = centers[random.below(centers.size())];
+                //the points out of the square are drawn again, after some attempts the uniform point is kept
+                for (int attempt = 0; attempt < 16; attempt++) {
+                    double cx = c.x() + random.normal() * p.spread * r;
+                    double cy = c.y() + random.normal() * p.spread * r;
+                    if (cx > -r && cx < r && cy > -r && cy < r) {
+                        x = cx;
+                        y = cy;
+                        break;
+                    }
+                }
+            }
+            points[i] = cg3::Point2d(x, y);
+        }
+    });
+
+    std::vector<cg3::Segment2d> segments(p.segments);
+    if (!points.empty()) {
+        partitionCells(points, 0, points.size(), Cell{-r, -r, r, r}, p.seed, threads, segments);
+    }
+    return segments;
+}
+
+/**
+ * @brief Generates the segments of the HORIZONTAL distribution: the square is divided in rows, and every row in
+ * segmentsPerRow columns. Every segment spans most of its column and it stays in its row, so the segments are long
+ * and thin when there are many rows.
+ */
+std::vector<cg3::Segment2d> generateHorizontalSegments(const SegmentGenerator::Parameters& p, size_t threads)
+{
+    size_t columns = std::max<size_t>(1, p.segmentsPerRow);
+    size_t rows = (p.segments + columns - 1) / columns;
+    double r = p.radius;
+    double w = 2 * r / columns, h = 2 * r / std::max<size_t>(1, rows);
+
+    std::vector<cg3::Segment2d> segments(p.segments);
+    parallelRanges(p.segments, threads, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            Random random(p.seed, i);
+            double x0 = -r + (i % columns) * w, y0 = -r + (i / columns) * h;
+            double x1 = x0 + w * random.uniform(0.02, 0.1);
+            double x2 = x0 + w * random.uniform(0.9, 0.98);
+            double y1 = y0 + h * random.uniform(0.1, 0.9);
+            double y2 = y0 + h * random.uniform(0.1, 0.9);
+            segments[i] = cg3::Segment2d(cg3::Point2d(x1, y1), cg3::Point2d(x2, y2));
+        }
+    });
+    return segments;
+}
+
+/**
+ * @brief Generates the segments of the ROADS distribution: the streets between the neighbor crossings of a grid,
+ * whose crossings are moved by a random offset smaller than a sixth of the spacing, so every street stays in the
+ * band of its row or of its column and only touches the other streets at its endpoints. A fraction of the streets
+ * is removed, then the streets are sampled to obtain the number of segments.
+ */
+std::vector<cg3::Segment2d> generateRoadSegments(const SegmentGenerator::Parameters& p)
+{
+    double keep = std::max(0.01, 1.0 - p.dropRate);
+    size_t side = size_t(std::ceil(std::sqrt(p.segments / (2 * keep)))) + 2;
+    double r = p.radius;
+
+    std::vector<cg3::Segment2d> streets;
+    while (streets.size() < p.segments) {
+        double s = 2 * r / side;
+        std::vector<cg3::Point2d> crossings(side * side);
+        for (size_t i = 0; i < side * side; i++) {
+            Random random(p.seed, i);
+            double x = -r + (i % side + 0.5 + random.uniform(-0.15, 0.15)) * s;
+            double y = -r + (i / side + 0.5 + random.uniform(-0.15, 0.15)) * s;
+            crossings[i] = cg3::Point2d(x, y);
+        }
+
+        streets.clear();
+        for (size_t i = 0; i < side * side; i++) {
+            Random random(p.seed, STREAM_CELLS + i);
+            if (i % side + 1 < side && random.uniform() >= p.dropRate) {
+                streets.push_back(cg3::Segment2d(crossings[i], crossings[i + 1]));
+            }
+            if (i / side + 1 < side && random.uniform() >= p.dropRate) {
+                streets.push_back(cg3::Segment2d(crossings[i], crossings[i + side]));
+            }
+        }
+        side++;
+    }
+
+    //a random sample of the streets, in the order of the grid
+    Random random(p.seed, STREAM_SHUFFLE);
+    std::vector<char> taken(streets.size(), 0);
+    for (size_t i = 0; i < p.segments; i++) {
+        taken[i] = 1;
+    }
+    for (size_t i = streets.size(); i > 1; i--) {
+        std::swap(taken[i - 1], taken[random.below(i)]);
+    }
+    std::vector<cg3::Segment2d> segments;
+    segments.reserve(p.segments);
+    for (size_t i = 0; i < streets.size(); i++) {
+        if (taken[i]) {
+            segments.push_back(streets[i]);
+        }
+    }
+    return segments;
+}
+
+/**
+ * @brief Generates the segments of the ADVERSARIAL distribution: horizontal segments stacked from the bottom to the
+ * top, every segment longer than the ones below it. When they are inserted in this order, every segment splits the
+ * trapezoid above the previous one, so the dag has a path with a node for every segment.
+ */
+std::vector<cg3::Segment2d> generateAdversarialSegments(const SegmentGenerator::Parameters& p)
+{
+    double r = p.radius;
+    double n = double(std::max<size_t>(1, p.segments));
+    std::vector<cg3::Segment2d> segments(p.segments);
+    for (size_t i = 0; i < p.segments; i++) {
+        double y = -r + (i + 0.5) * 2 * r / n;
+        double x = 0.5 * r + 0.45 * r * i / n;
+        segments[i] = cg3::Segment2d(cg3::Point2d(-x, y), cg3::Point2d(x, y));
+    }
+    return segments;
+}
+
+/**
+ * @brief Moves the endpoints that have the x-coordinate of a different point to the next free doubles, so the
+ * points are in general position. The same point shared by several segments keeps the same coordinates.
+ * The moves are of a few units in the last place, so the segments don't cross.
+ * @param segments The segments
+ */
+void separateXCoordinates(std::vector<cg3::Segment2d>& segments)
+{
+    std::vector<cg3::Point2d> points;
+    points.reserve(2 * segments.size());
+    for (const cg3::Segment2d& s : segments) {
+        points.push_back(s.p1());
+        points.push_back(s.p2());
+    }
+    std::sort(points.begin(), points.end());
+    std::vector<double> xs;
+    std::unordered_set<double> repeated;
+    for (size_t i = 0; i < points.size(); i++) {
+        if (i > 0 && points[i].x() == points[i - 1].x() && points[i].y() != points[i - 1].y()) {
+            repeated.insert(points[i].x());
+        }
+        if (i == 0 || points[i].x() != points[i - 1].x()) {
+            xs.push_back(points[i].x());
+        }
+    }
+    points = std::vector<cg3::Point2d>();
+    if (repeated.empty()) {
+        return;
+    }
+
+    //the first point with a repeated x-coordinate keeps it, the other ones are moved
+    std::unordered_map<double, cg3::Point2d> owner;
+    std::unordered_map<cg3::Point2d, cg3::Point2d> moved;
+    std::unordered_set<double> used;
+    auto separate = [&](const cg3::Point2d& point) {
+        if (repeated.find(point.x()) == repeated.end()) {
+            return point;
+        }
+        std::unordered_map<cg3::Point2d, cg3::Point2d>::iterator m = moved.find(point);
+        if (m != moved.end()) {
+            return m->second;
+        }
+        std::unordered_map<double, cg3::Point2d>::iterator o = owner.find(point.x());
+        if (o == owner.end() || o->second == point) {
+            owner.insert(std::make_pair(point.x(), point));
+            return point;
+        }
+        double x = point.x();
+        do {
+            x = std::nextafter(x, INFINITY);
+        } while (std::binary_search(xs.begin(), xs.end(), x) || used.find(x) != used.end());
+        used.insert(x);
+        cg3::Point2d result(x, point.y());
+        moved.insert(std::make_pair(point, result));
+        return result;
+    };
+    for (cg3::Segment2d& s : segments) {
+        s = cg3::Segment2d(separate(s.p1()), separate(s.p2()));
+    }
+}
+
+/**
+ * @brief The shortest text of a double that is read back as the same double, in the classic locale
+ */
+std::string formatDouble(double v)
+{
+    std::string text;
+    for (int precision = 15; precision <= 17; precision++) {
+        std::ostringstream out;
+        out.imbue(std::locale::classic());
+        out.precision(precision);
+        out << v;
+        text = out.str();
+        std::istringstream in(text);
+        in.imbue(std::locale::classic());
+        double read = 0;
+        in >> read;
+        if (read == v) {
+            break;
+        }
+    }
+    return text;
+}
+
+}
+
+namespace SegmentGenerator {
+
+/**
+ * @brief Generates a set of non intersecting, non degenerate segments in general position with the given distribution.
+ * The segments don't intersect by construction, so no intersection test is needed and the generation takes
+ * O(n log n) for every distribution. The segments are shuffled, except for the ADVERSARIAL distribution, whose
+ * order is the point of the distribution.
+ * @param parameters The distribution and its parameters
+ * @param threads The number of threads, 0 to use all the cores of the machine. The segments don't depend on it.
+ * @return The segments
+ */
+std::vector<cg3::Segment2d> generateSegments(const Parameters& parameters, size_t threads)
+{
+    if (threads == 0) {
+        threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+    }
+
+    std::vector<cg3::Segment2d> segments;
+    switch (parameters.distribution) {
+    case UNIFORM:
+    case CLUSTERED:
+        segments = generateCellSegments(parameters, threads);
+        break;
+    case HORIZONTAL:
+        segments = generateHorizontalSegments(parameters, threads);
+        break;
+    case ROADS:
+        segments = generateRoadSegments(parameters);
+        break;
+    case ADVERSARIAL:
+        segments = generateAdversarialSegments(parameters);
+        break;
+    }
+
+    separateXCoordinates(segments);
+
+    //two points of a segment can only be equal if two random points coincide
+    segments.erase(std::remove_if(segments.begin(), segments.end(), [](const cg3::Segment2d& s) {
+        return s.p1() == s.p2();
+    }), segments.end());
+
+    if (parameters.distribution != ADVERSARIAL) {
+        Random random(parameters.seed, STREAM_SHUFFLE);
+        for (size_t i = segments.size(); i > 1; i--) {
+            std::swap(segments[i - 1], segments[random.below(i)]);
+        }
+    }
+    return segments;
+}
+
+/**
+ * @brief The name of a distribution, as used by parseDistribution() and describe()
+ */
+std::string getDistributionName(Distribution distribution)
+{
+    switch (distribution) {
+    case UNIFORM:
+        return "uniform";
+    case CLUSTERED:
+        return "clustered";
+    case HORIZONTAL:
+        return "horizontal";
+    case ROADS:
+        return "roads";
+    case ADVERSARIAL:
+        return "adversarial";
+    }
+    return "";
+}
+
+/**
+ * @brief Reads the name of a distribution
+ * @return False if the name is not the name of a distribution
+ */
+bool parseDistribution(const std::string& name, Distribution& distribution)
+{
+    for (Distribution d : {UNIFORM, CLUSTERED, HORIZONTAL, ROADS, ADVERSARIAL}) {
+        if (getDistributionName(d) == name) {
+            distribution = d;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Describes the parameters as the options of the generator that give the same segments,
+ * e.g. "--distribution clustered --segments 1000 --seed 1 --radius 1000000 --clusters 16 --spread 0.05"
+ * @param parameters The parameters
+ * @return The description, a single line
+ */
+std::string describe(const Parameters& parameters)
+{
+    std::ostringstream out;
+    out.imbue(std::locale::classic());
+    out << "--distribution " << getDistributionName(parameters.distribution) <<
+           " --segments " << parameters.segments <<
+           " --seed " << parameters.seed <<
+           " --radius " << formatDouble(parameters.radius);
+    switch (parameters.distribution) {
+    case CLUSTERED:
+        out << " --clusters " << parameters.clusters << " --spread " << formatDouble(parameters.spread);
+        break;
+    case HORIZONTAL:
+        out << " --segments-per-row " << parameters.segmentsPerRow;
+        break;
+    case ROADS:
+        out << " --drop-rate " << formatDouble(parameters.dropRate);
+        break;
+    default:
+        break;
+    }
+    return out.str();
+}
+
+}
@@ -0,0 +1,46 @@
+#ifndef SEGMENTGENERATOR_H
+#define SEGMENTGENERATOR_H
+
+#include <string>
+#include <vector>
+#include <cg3/geometry/point2.h>
+#include <cg3/geometry/segment2.h>
+
+namespace SegmentGenerator {
+
+/**
+ * @brief The distributions of the generated segments
+ */
+enum Distribution {
+    UNIFORM,        //short segments uniformly distributed in the square
+    CLUSTERED,      //short segments concentrated around some hotspots
+    HORIZONTAL,     //long thin near-horizontal segments, in rows
+    ROADS,          //the streets of a jittered grid, sharing their endpoints at the crossings
+    ADVERSARIAL     //stacked horizontal segments sorted from the bottom, so an insertion in the order of the file gives a deep dag
+};
+
+/**
+ * @brief The parameters of a generated set of segments: the same parameters always give the same segments,
+ * with any number of threads, since the random numbers don't depend on the standard library
+ */
+struct Parameters {
+    Distribution distribution = UNIFORM;
+    size_t segments = 1000;         //the number of segments
+    double radius = 1e6;            //the segments are in the square [-radius, radius]
+    unsigned long seed = 1;         //the seed of the random numbers
+    size_t clusters = 16;           //CLUSTERED: the number of hotspots
+    double spread = 0.05;           //CLUSTERED: the standard deviation of a hotspot, relative to the radius
+    size_t segmentsPerRow = 4;      //HORIZONTAL: the number of segments in a row
+    double dropRate = 0.1;          //ROADS: the fraction of streets removed from the grid
+};
+
+std::vector<cg3::Segment2d> generateSegments(const Parameters& parameters, size_t threads = 0);
+
+std::string getDistributionName(Distribution distribution);
+bool parseDistribution(const std::string& name, Distribution& distribution);
+
+std::string describe(const Parameters& parameters);
+
+}
+
+#endif // SEGMENTGENERATOR_H